@@ -0,0 +1,15 @@
+// vertex shader
+// covering a level of an octahedral map with a single triangle, of which every fragment is pre-filtered
+// use with: 'pre_filter_map.frag', compiled with OCTAHEDRAL defined
+#version 330 core
+
+// coordinates of the octahedral map in [-1, 1] (see {CubemapConverter::get_octahedral_direction})
+out vec2 coordinates;
+
+void main()
+{
+    // a triangle of twice the size of the viewport, without vertex attributes
+    vec2 position = vec2(float((gl_VertexID & 1) << 2) - 1., float((gl_VertexID & 2) << 1) - 1.);
+    coordinates = position;
+    gl_Position = vec4(position, 0., 1.);
+}
@@ -0,0 +1,73 @@
+// functions of the octahedral layout of {IblTier}, shared by the shaders sampling or rendering octahedral maps
+// this is not a shader on its own: it is inserted after the definitions of a shader, see {Shader::create_shader}
+
+/* Returns the direction of {coordinates} in [-1, 1] of an octahedral map, as
+   {CubemapConverter::get_octahedral_direction}. */
+vec3 octahedral_direction(vec2 coordinates)
+{
+    vec3 d = vec3(coordinates.x, 1. - abs(coordinates.x) - abs(coordinates.y), coordinates.y);
+    if (d.y < 0.) {
+        // the corners mirror over the edges of the diamond
+        d.xz = (1. - abs(coordinates.yx)) * vec2(coordinates.x >= 0. ? 1. : -1., coordinates.y >= 0. ? 1. : -1.);
+    }
+
+    return d;
+}
+
+/* Returns the texture coordinates of direction {d} in an octahedral map, the inverse of the above. */
+vec2 octahedral_coordinates(vec3 d)
+{
+    d /= abs(d.x) + abs(d.y) + abs(d.z);
+    vec2 st = d.xz;
+    if (d.y < 0.) {
+        // the lower hemisphere folds over the edges of the diamond into the corners
+        st = (1. - abs(d.zx)) * vec2(d.x >= 0. ? 1. : -1., d.z >= 0. ? 1. : -1.);
+    }
+
+    return st * .5 + .5;
+}
+
+/* Returns the texel of a map of {size} that neighbours {texel} on the sphere. Each edge of the map is a fold, the
+   texel past it is the one mirrored along the edge, and past a corner it is the opposite corner. */
+ivec2 octahedral_wrap(ivec2 texel, ivec2 size)
+{
+    if (texel.x < 0 || texel.x >= size.x) {
+        texel = ivec2(clamp(texel.x, 0, size.x - 1), size.y - 1 - texel.y);
+    }
+    if (texel.y < 0 || texel.y >= size.y) {
+        texel = ivec2(size.x - 1 - texel.x, clamp(texel.y, 0, size.y - 1));
+    }
+
+    return texel;
+}
+
+/* Bilinearly samples {level} of octahedral {map} at {coordinates}, with the taps wrapping over the folds. */
+vec3 sample_octahedral_level(sampler2D map, vec2 coordinates, int level)
+{
+    ivec2 size = textureSize(map, level);
+    vec2 texel = coordinates * vec2(size) - .5;
+    ivec2 base = ivec2(floor(texel));
+    vec2 f = texel - vec2(base);
+
+    vec3 c00 = texelFetch(map, octahedral_wrap(base, size), level).rgb;
+    vec3 c10 = texelFetch(map, octahedral_wrap(base + ivec2(1, 0), size), level).rgb;
+    vec3 c01 = texelFetch(map, octahedral_wrap(base + ivec2(0, 1), size), level).rgb;
+    vec3 c11 = texelFetch(map, octahedral_wrap(base + ivec2(1, 1), size), level).rgb;
+
+    return mix(mix(c00, c10, f.x), mix(c01, c11, f.x), f.y);
+}
+
+/* Samples octahedral {map} in direction {d} at level {lod}, clamped to {max_lod}, the last level of {map}. Filtering
+   is done here instead of by the sampler, which would clamp at the edges of the map and show its folds as seams. */
+vec3 sample_octahedral(sampler2D map, vec3 d, float lod, float max_lod)
+{
+    vec2 coordinates = octahedral_coordinates(d);
+    lod = clamp(lod, 0., max_lod);
+    int level = int(lod);
+    vec3 color = sample_octahedral_level(map, coordinates, level);
+    if (lod > float(level)) {
+        color = mix(color, sample_octahedral_level(map, coordinates, level + 1), lod - float(level));
+    }
+
+    return color;
+}
@@ -5,27 +5,45 @@
 #version 330 core
 
 #define NUM_LIGHTS 10
+#define MAX_REFLECTION_LOD 4. // last level of {pre_filter_map}
 #define M_PI 3.1415926535897932384626433832795
 
-uniform sampler2D texture_diff;     // 0
-uniform sampler2D texture_norm;     // 1
-uniform sampler2D texture_ao;       // 2
-uniform sampler2D texture_rough;    // 3
-uniform sampler2D texture_disp;     // 4
-uniform sampler2D texture_spec;     // 5
+uniform sampler2D texture_diff;        // 0
+uniform sampler2D texture_norm;        // 1
+uniform sampler2D texture_rough_metal; // 2, roughness and metallic
+uniform sampler2D texture_ao_disp;     // 3, ambient occlusion and displacement
 
-uniform int has_spec;
-
-uniform samplerCube irradiance_map; // 6
+#ifdef OCTAHEDRAL
+uniform sampler2D pre_filter_map;   // 7, octahedral map
+#else
 uniform samplerCube pre_filter_map; // 7
+#endif
 uniform sampler2D brdf_lut;         // 8
 
 uniform vec3 color_light[NUM_LIGHTS];
 
+// irradiance of the dominant light of the environment, which is removed from {pre_filter_map} and the coefficients
+// below, scaled by the exposure of the environment. zero if the environment has none
+uniform vec3 color_dominant_light;
+
+// spherical harmonics of the irradiance of the environment, scaled by the cosine convolution and 1 / pi
+// also rotated by the yaw and scaled by the exposure of the environment
+uniform vec3 irradiance_coefficients[9];
+
+// rotates world directions into {pre_filter_map} and scales what is read from it, the yaw and exposure of the
+// environment, or identity for a reflection probe since its capture already holds both
+uniform mat3 pre_filter_rotation;
+uniform float pre_filter_intensity;
+
+// whether to output linear radiance instead of tone mapping, used when capturing a reflection probe
+uniform bool linear_output;
+
 in vec2 tex;
 in vec3 tangent_pos_light[NUM_LIGHTS];
+in vec3 tangent_dominant_light;
 in vec3 tangent_pos_view;
 in vec3 tangent_frag_pos;
+in mat3 tangent_to_world;
 
 out vec4 frag_color;
 
@@ -53,6 +71,17 @@ float geometry_schlick_ggx(float n_dot_v, float roughness);
    Uses Smith's method (which uses Schlick-GGX). */
 float geometry_smith(vec3 n, vec3 v, vec3 l, float roughness);
 
+/* Returns the radiance reflected towards {v} of light arriving from direction {l} with {radiance}, by a surface with
+   normal {n} and the given material. Uses the Cook-Torrance BRDF. */
+vec3 reflect_light(vec3 n, vec3 v, vec3 l, vec3 radiance, vec3 albedo, vec3 f_0, float roughness, float metallic);
+
+/* Evaluates {irradiance_coefficients} in unit direction {n}, giving the cosine weighted radiance divided by pi.
+   (https://cseweb.ucsd.edu/~ravir/papers/envmap/envmap.pdf) */
+vec3 irradiance_sh(vec3 n);
+
+/* Samples level {lod} of {pre_filter_map} in direction {d}, in the layout it is stored in. */
+vec3 sample_pre_filter(vec3 d, float lod);
+
 /* Use displacement map to parallax map the texcoords to new ones.
    Uses Parallax Occlusion Mapping.*/
 vec2 parallax_mapping(vec2 tex_coords, vec3 view_dir);
@@ -61,23 +90,21 @@ void main()
 {
     vec3 v          = normalize(tangent_pos_view - tangent_frag_pos); // direction from point to camera
     vec2 tex_coords = parallax_mapping(tex, v);
-
+    // linear RGB, the sRGB texture format makes the hardware decode it when sampled
     // convert SRGB to linear RGB
-    vec3 albedo = pow(texture(texture_diff, tex_coords).rgb, vec3(2.2));
+    vec3 albedo = texture(texture_diff, tex_coords).rgb;
 
     // obtain normal from normal map in range [0, 1], transform to [-1, 1] ({normal} is in tangent space)
-    vec3 normal = texture(texture_norm, tex_coords).rgb;
-    normal = normalize(normal * 2.0 - 1.0);
+    // only X and Y are stored (BC5 has two channels), Z is rebuilt since the normal has unit length
+    vec2 normal_xy = texture(texture_norm, tex_coords).rg * 2.0 - 1.0;
+    vec3 normal = normalize(vec3(normal_xy, sqrt(max(1. - dot(normal_xy, normal_xy), 0.))));
 
     vec3 r = reflect(-v, normal);
 
-    float ao = texture(texture_ao, tex_coords).r;
-    float roughness = texture(texture_rough, tex_coords).r;
-
-    float metallic = 0.f;
-    if (bool(has_spec)) {
-        metallic = texture(texture_spec, tex_coords).r;
-    }
+    vec2 rough_metal = texture(texture_rough_metal, tex_coords).rg;
+    float ao = texture(texture_ao_disp, tex_coords).r;
+    float roughness = rough_metal.r;
+    float metallic = rough_metal.g;
 
     vec3 l_o = vec3(0.0);                  // total outgoing radiance of this fragment
     vec3 f_0 = vec3(0.04);                 // surface reflection at zero incidence (0.04 for dielectric)
@@ -85,41 +112,31 @@ void main()
 
     for (int i = 0; i < NUM_LIGHTS; i++) {
         vec3 l = normalize(tangent_pos_light[i] - tangent_frag_pos); // direction from point to light
-        vec3 h = normalize(v + l);                                   // halfway vector
 
         // calculate light attenuation
         float distance    = length(tangent_pos_light[i] - tangent_frag_pos); // distance towards light
         float attenuation = 1.0 / (distance * distance); // light attenuation is inversely squarely correlated with dist
         vec3 radiance     = color_light[i] * attenuation;
 
-        // compute approximations
-        float ndf = distribution_ggx(normal, h, roughness);
-        float g   = geometry_smith(normal, v, l, roughness);
-        vec3 f    = fresnel_schlick_roughness(max(dot(h, v), 0.), f_0, roughness);
-
-        vec3 k_s = f;              // specular contribution determined by fresnel approximation
-        vec3 k_d = vec3(1.) - k_s; // diffuse contribution by law of energy conservation
-        k_d *= 1. - metallic;      // reduce diffuse contribution for metallic surfaces
-
-        // plug in equation and add to outgoing radiance l_o
-        vec3 numerator    = ndf * g * f;
-        float denominator = 4. * max(dot(normal, v), 0.) * max(dot(normal, l), 0.);
-        vec3 specular     = numerator / max(denominator, .001); // prevent div zero
-
-        float n_dot_l = max(dot(normal, l), 0.);
-        l_o += (k_d * albedo / M_PI + specular) * radiance * n_dot_l;
+        l_o += reflect_light(normal, v, l, radiance, albedo, f_0, roughness, metallic);
     }
 
+    // the dominant light is directional, it is not attenuated
+    l_o += reflect_light(
+            normal, v, normalize(tangent_dominant_light), color_dominant_light, albedo, f_0, roughness, metallic);
+
     // ambient lighting (we now use IBL as the ambient term)
     vec3 k_s = fresnel_schlick_roughness(max(dot(normal, v), 0.), f_0, roughness);
     vec3 k_d = 1. - k_s;
     k_d *= 1. - metallic;
-    vec3 irradiance = texture(irradiance_map, normal).rgb;
+    // ringing of the expansion may dip below zero
+    vec3 irradiance = max(irradiance_sh(tangent_to_world * normal), vec3(0.));
     vec3 diffuse    = irradiance * albedo;
 
     // sample pre-filter map and BRDF lut and combine them together as per the Split-Sum approximation
-    const float MAX_REFLECTION_LOD = 4.;
-    vec3 prefiltered_color = textureLod(pre_filter_map, r, roughness * MAX_REFLECTION_LOD).rgb;
+    vec3 r_pre_filter      = pre_filter_rotation * (tangent_to_world * r);
+    vec3 prefiltered_color = sample_pre_filter(r_pre_filter, roughness * MAX_REFLECTION_LOD);
+    prefiltered_color     *= pre_filter_intensity;
     vec2 brdf              = texture(brdf_lut, vec2(max(dot(normal, v), 0.), roughness)).rg;
     vec3 specular          = prefiltered_color * (k_s * brdf.x + brdf.y);
 
@@ -128,8 +145,10 @@ void main()
     vec3 color = ambient + l_o;
 
     // reinhard tone mapping + gamma correction
-    color = color / (color + vec3(1.));
-    color = pow(color, vec3(1. / 2.2));
+    if (!linear_output) {
+        color = color / (color + vec3(1.));
+        color = pow(color, vec3(1. / 2.2));
+    }
 
     frag_color = vec4(color, 1.0);
 }
@@ -179,6 +198,50 @@ float geometry_smith(vec3 n, vec3 v, vec3 l, float roughness)
     return ggx1 * ggx2;
 }
 
+vec3 reflect_light(vec3 n, vec3 v, vec3 l, vec3 radiance, vec3 albedo, vec3 f_0, float roughness, float metallic)
+{
+    vec3 h = normalize(v + l); // halfway vector
+
+    // compute approximations
+    float ndf = distribution_ggx(n, h, roughness);
+    float g   = geometry_smith(n, v, l, roughness);
+    vec3 f    = fresnel_schlick_roughness(max(dot(h, v), 0.), f_0, roughness);
+
+    vec3 k_s = f;              // specular contribution determined by fresnel approximation
+    vec3 k_d = vec3(1.) - k_s; // diffuse contribution by law of energy conservation
+    k_d *= 1. - metallic;      // reduce diffuse contribution for metallic surfaces
+
+    // plug in equation
+    vec3 numerator    = ndf * g * f;
+    float denominator = 4. * max(dot(n, v), 0.) * max(dot(n, l), 0.);
+    vec3 specular     = numerator / max(denominator, .001); // prevent div zero
+
+    float n_dot_l = max(dot(n, l), 0.);
+    return (k_d * albedo / M_PI + specular) * radiance * n_dot_l;
+}
+
+vec3 irradiance_sh(vec3 n)
+{
+    return irradiance_coefficients[0] * .282095
+         + irradiance_coefficients[1] * .488603 * n.y
+         + irradiance_coefficients[2] * .488603 * n.z
+         + irradiance_coefficients[3] * .488603 * n.x
+         + irradiance_coefficients[4] * 1.092548 * n.x * n.y
+         + irradiance_coefficients[5] * 1.092548 * n.y * n.z
+         + irradiance_coefficients[6] * .315392 * (3. * n.z * n.z - 1.)
+         + irradiance_coefficients[7] * 1.092548 * n.x * n.z
+         + irradiance_coefficients[8] * .546274 * (n.x * n.x - n.y * n.y);
+}
+
+vec3 sample_pre_filter(vec3 d, float lod)
+{
+#ifdef OCTAHEDRAL
+    return sample_octahedral(pre_filter_map, d, lod, MAX_REFLECTION_LOD);
+#else
+    return textureLod(pre_filter_map, d, lod).rgb;
+#endif
+}
+
 vec2 parallax_mapping(vec2 tex_coords, vec3 view_dir)
 {
 //    return tex_coords;
@@ -191,19 +254,19 @@ vec2 parallax_mapping(vec2 tex_coords, vec3 view_dir)
     vec2 delta_tex_coords = p / float(NUM_LAYERS);
 
     vec2  current_tex_coords      = tex_coords; // the tex coords at the current_layer_depth
-    float current_depth_map_value = texture(texture_disp, current_tex_coords).r;
+    float current_depth_map_value = texture(texture_ao_disp, current_tex_coords).g;
 
     while(current_layer_depth > current_depth_map_value) {
         // shift texture coordinates along direction of p
         current_tex_coords -= delta_tex_coords;
         // get depthmap value at current texture coordinates
-        current_depth_map_value = texture(texture_disp, current_tex_coords).r;
+        current_depth_map_value = texture(texture_ao_disp, current_tex_coords).g;
         current_layer_depth -= LAYER_DEPTH;
     }
 
     // get texture coordinates before collision (reverse operations)
     vec2 prev_tex_coords = current_tex_coords + delta_tex_coords;
-    float before_depth = texture(texture_disp, prev_tex_coords).r - (current_layer_depth + LAYER_DEPTH);
+    float before_depth = texture(texture_ao_disp, prev_tex_coords).g - (current_layer_depth + LAYER_DEPTH);
 
     // get depth after collision for linear interpolation
     float after_depth  = current_depth_map_value - current_layer_depth;
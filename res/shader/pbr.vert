@@ -12,6 +12,7 @@ uniform mat4 projection_matrix;
 
 uniform vec3 pos_light[NUM_LIGHTS];
 uniform vec3 pos_camera;
+uniform vec3 direction_dominant_light; // unit direction towards the dominant light of the environment
 
 layout (location = 0) in vec3 in_position;
 layout (location = 1) in vec2 in_texture_coordinates;
@@ -21,8 +22,10 @@ layout (location = 4) in vec3 in_bitangent;
 
 out vec2 tex;
 out vec3 tangent_pos_light[NUM_LIGHTS];
+out vec3 tangent_dominant_light;
 out vec3 tangent_pos_view;
 out vec3 tangent_frag_pos;
+out mat3 tangent_to_world;
 
 void main()
 {
@@ -40,5 +43,11 @@ void main()
     tangent_pos_view  = tbn * pos_camera;
     tangent_frag_pos  = tbn * frag_pos;
 
+    // a direction, which the tangent frame only rotates
+    tangent_dominant_light = tbn * direction_dominant_light;
+
+    // the environment and reflection probes are looked up in world space
+    tangent_to_world = mat3(t, b, n);
+
     gl_Position = projection_matrix * view_matrix * model_matrix * vec4(in_position, 1.0);
 }
\ No newline at end of file
@@ -3,7 +3,18 @@
 // use with: 'skybox.vert'
 #version 330 core
 
+#ifdef OCTAHEDRAL
+uniform sampler2D environment_map;   // octahedral map
+#else
 uniform samplerCube environment_map;
+#endif
+uniform float environment_intensity; // exposure of the environment as a linear factor
+uniform bool linear_output;          // whether to skip tone mapping, used when capturing a reflection probe
+
+// the dominant light that was removed from {environment_map}, drawn back as a disk of constant radiance
+uniform vec3 dominant_light_direction; // in the frame of {environment_map}
+uniform vec3 dominant_light_radiance;
+uniform float dominant_light_cos_radius;
 
 in vec3 local_pos;
 
@@ -11,11 +22,24 @@ out vec4 frac_color;
 
 void main()
 {
+#ifdef OCTAHEDRAL
+    // the first level, the coordinates jump at the folds which would select the coarsest level along them
+    vec3 env_color = sample_octahedral(environment_map, local_pos, 0., 0.);
+#else
     vec3 env_color = texture(environment_map, local_pos).rgb;
+#endif
+
+    // not when capturing a reflection probe, objects reflecting the probe shade the dominant light analytically already
+    if (!linear_output && dot(normalize(local_pos), dominant_light_direction) > dominant_light_cos_radius) {
+        env_color += dominant_light_radiance;
+    }
+    env_color *= environment_intensity;
 
     // environment map is in hdr, so apply reinhard to tone map to ldr
-    env_color = env_color / (env_color + vec3(1.0));
-    env_color = pow(env_color, vec3(1.0 / 2.2));
+    if (!linear_output) {
+        env_color = env_color / (env_color + vec3(1.0));
+        env_color = pow(env_color, vec3(1.0 / 2.2));
+    }
 
     frac_color = vec4(env_color, 1.0);
-}
\ No newline at end of file
+}
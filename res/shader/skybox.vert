@@ -8,15 +8,17 @@ layout (location = 0) in vec3 in_position;
 uniform mat4 projection_matrix;
 uniform mat4 view_matrix;
 uniform mat4 model_matrix;
+// rotates directions into the environment map, the inverse of the yaw of the environment
+uniform mat3 environment_rotation;
 
 out vec3 local_pos;
 
 void main()
 {
-    local_pos = in_position;
+    local_pos = environment_rotation * in_position; // rotated per vertex, it interpolates linearly
 
     mat4 rot_view = mat4(mat3(view_matrix)); // remove translation from the view matrix
-    vec4 clip_pos = projection_matrix * rot_view * model_matrix * vec4(local_pos, 1.0);
+    vec4 clip_pos = projection_matrix * rot_view * model_matrix * vec4(in_position, 1.0);
 
     gl_Position = clip_pos.xyww;
 }
\ No newline at end of file
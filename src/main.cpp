@@ -1,4 +1,5 @@
 #include <cstdlib>
+#include <cstring>
 
 #include <glm/mat4x4.hpp>
 
@@ -7,15 +8,46 @@
 #include <stb_image_write.h>
 
 #include "system/window.hpp"
+#include "system/opengl/ibl_tier.hpp"
 #include "system/camera.hpp"
 #include "system/renderer.hpp"
 #include "system/manager/texture_manager.hpp"
 #include "util/nm_math.hpp"
 
+/** Radians the environment is rotated by, and stops its exposure is changed by, per key press. */
+static const float ENVIRONMENT_YAW_STEP = glm::radians(15.f);
+static const float ENVIRONMENT_EXPOSURE_STEP = .5f;
+
 void update(Camera *camera, Renderer *renderer, Scene *scene);
 
-int main()
+int main(int argc, char **argv)
 {
+    // the tier and layout are fixed for the lifetime of the application, textures are created at its resolutions,
+    // formats and texture type
+    IblTier::Level tier = IblTier::DEFAULT;
+    IblTier::Layout layout = IblTier::DEFAULT_LAYOUT;
+    bool preload = true;
+    for (int i = 1; i < argc; i += 2) {
+        if (i + 1 < argc && strcmp(argv[i], "--ibl-tier") == 0) {
+            if (IblTier::find(argv[i + 1], &tier) == EXIT_FAILURE) {
+                return EXIT_FAILURE;
+            }
+        } else if (i + 1 < argc && strcmp(argv[i], "--ibl-layout") == 0) {
+            if (IblTier::find_layout(argv[i + 1], &layout) == EXIT_FAILURE) {
+                return EXIT_FAILURE;
+            }
+        } else if (i + 1 < argc && strcmp(argv[i], "--preload") == 0 &&
+                   (strcmp(argv[i + 1], "on") == 0 || strcmp(argv[i + 1], "off") == 0)) {
+            preload = strcmp(argv[i + 1], "on") == 0;
+        } else {
+            fprintf(stderr, "USAGE: %s [--ibl-tier {low|medium|high}] [--ibl-layout {cubemap|octahedral}]\n"
+                            "       [--preload {on|off}]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    IblTier::select_layout(layout);
+    IblTier::select(tier);
+
     if (window::get_instance().initialize() == EXIT_FAILURE) {
         nm_log::log(LOG_ERROR, "failed to create window\n");
         return EXIT_FAILURE;
@@ -25,6 +57,9 @@ int main()
     TextureManager texture_manager;
     PrimitiveManager primitive_manager;
 
+    // show placeholders while material textures load, instead of stalling on large textures
+    texture_manager.set_streaming(true, TextureManager::DEFAULT_UPLOAD_BUDGET);
+
     Camera camera(
             (float) window::get_instance().get_input_handler()->get_size_x() /
             (float) window::get_instance().get_input_handler()->get_size_y(),
@@ -32,6 +67,14 @@ int main()
 
     Renderer renderer(&camera, &shader_manager, &texture_manager, &primitive_manager);
 
+    // build all other environments in the background, such that switching to one does not have to prepare it
+    GLFWwindow *loader_context = preload ? window::get_instance().create_shared_context() : nullptr;
+    if (loader_context) {
+        texture_manager.start_preloading([loader_context](bool current) {
+            glfwMakeContextCurrent(current ? loader_context : nullptr);
+        }, renderer.get_cubemap());
+    }
+
     Scene scene(&renderer);
 
     while (!window::get_instance().should_close()) {
@@ -42,6 +85,12 @@ int main()
 
         scene.update();
 
+        // upload part of the textures that finished decoding in the background
+        texture_manager.update_streaming();
+
+        // take over environments that the loader thread finished
+        texture_manager.update_preloading();
+
         renderer.render(&scene);
 
         // allow managers to deallocate objects not used in last frame
@@ -50,6 +99,10 @@ int main()
         primitive_manager.make_space();
     }
 
+    // the reflection probes of the scene and the loader thread use the context, which is destroyed with the window
+    scene.erase();
+    texture_manager.stop_preloading();
+
     window::get_instance().cleanup();
 
     return EXIT_SUCCESS;
@@ -68,18 +121,32 @@ void update(Camera *camera, Renderer *renderer, Scene *scene)
 
     // environment switching
     if (window::get_instance().get_input_handler()->get_key_state(input::NUM_1, input::PRESSED)) {
-        renderer->switch_skybox(
-                CUBEMAP_NOON_GRASS, CUBEMAP_NOON_GRASS_IRRADIANCE, CUBEMAP_NOON_GRASS_PRE_FILTER);
+        renderer->switch_skybox(CUBEMAP_NOON_GRASS, CUBEMAP_NOON_GRASS_PRE_FILTER);
     }
 
     if (window::get_instance().get_input_handler()->get_key_state(input::NUM_2, input::PRESSED)) {
-        renderer->switch_skybox(
-                CUBEMAP_STUDIO, CUBEMAP_STUDIO_IRRADIANCE, CUBEMAP_STUDIO_PRE_FILTER);
+        renderer->switch_skybox(CUBEMAP_STUDIO, CUBEMAP_STUDIO_PRE_FILTER);
     }
 
     if (window::get_instance().get_input_handler()->get_key_state(input::NUM_3, input::PRESSED)) {
-        renderer->switch_skybox(
-                CUBEMAP_MOONLESS_GOLF, CUBEMAP_MOONLESS_GOLF_IRRADIANCE, CUBEMAP_MOONLESS_GOLF_PRE_FILTER);
+        renderer->switch_skybox(CUBEMAP_MOONLESS_GOLF, CUBEMAP_MOONLESS_GOLF_PRE_FILTER);
+    }
+
+    // environment rotation and exposure, applied while rendering so they need no re-baking
+    if (window::get_instance().get_input_handler()->get_key_state(input::LEFT, input::PRESSED)) {
+        renderer->set_environment_yaw(renderer->get_environment_yaw() - ENVIRONMENT_YAW_STEP);
+    }
+
+    if (window::get_instance().get_input_handler()->get_key_state(input::RIGHT, input::PRESSED)) {
+        renderer->set_environment_yaw(renderer->get_environment_yaw() + ENVIRONMENT_YAW_STEP);
+    }
+
+    if (window::get_instance().get_input_handler()->get_key_state(input::MINUS, input::PRESSED)) {
+        renderer->set_environment_exposure(renderer->get_environment_exposure() - ENVIRONMENT_EXPOSURE_STEP);
+    }
+
+    if (window::get_instance().get_input_handler()->get_key_state(input::EQUAL, input::PRESSED)) {
+        renderer->set_environment_exposure(renderer->get_environment_exposure() + ENVIRONMENT_EXPOSURE_STEP);
     }
 
     // scene switching
@@ -259,7 +326,8 @@ void update(Camera *camera, Renderer *renderer, Scene *scene)
             glm::vec3 b = glm::vec3(old_far.x / old_far.w, old_far.y / old_far.w, old_far.z / old_far.w);
             // scale the movement with the dot product of projected mouse movement and movement axis
             // do not normalize the direction as to scale with how fast the mouse is moving
-            object->position += axis * (SENSITIVITY * glm::dot(a - b, axis));
+            // reflection probes that see the object at its old or new position are captured again
+            scene->move_object(object, object->position + axis * (SENSITIVITY * glm::dot(a - b, axis)));
         }
     }
 
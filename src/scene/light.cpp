@@ -13,7 +13,7 @@ void Light::render(bool debug_mode)
 {
     SceneObject::render(debug_mode);
 
-    renderer->render_default(
+    renderer->queue_default(
             PRIMITIVE_SPHERE,
             color,
             glm::scale(
@@ -26,4 +26,9 @@ void Light::render(bool debug_mode)
 bool Light::hit(float *t, glm::vec3 origin, glm::vec3 direction)
 {
     return nm_math::ray_sphere(t, origin, direction, position, 1.f / SCALE);
+}
+
+bool Light::contains(glm::vec3 point)
+{
+    return glm::length(point - position) < 1.f / SCALE;
 }
\ No newline at end of file
@@ -16,6 +16,8 @@ public:
     void render(bool debug_mode) override;
 
     bool hit(float *t, glm::vec3 origin, glm::vec3 direction) override;
+
+    bool contains(glm::vec3 point) override;
 };
 
 #endif //PBR_LIGHT_HPP
@@ -1,8 +1,18 @@
 #include "scene.hpp"
 
 #include "sphere.hpp"
+#include "../system/material.hpp"
 #include "../system/renderer.hpp"
 
+/** Materials of the spheres of {Scene::construct} and {Scene::construct_other}, from left to right. */
+static const std::vector<Material::MaterialType> SCENE_MATERIALS = {
+        Material::MATERIAL_BRICK_1K, Material::MATERIAL_METAL_1K, Material::MATERIAL_DENIM_1K,
+        Material::MATERIAL_MARBLE_1K};
+static const std::vector<Material::MaterialType> OTHER_SCENE_MATERIALS = {Material::MATERIAL_BRICK_4K};
+
+/** Radius of the reflection probes, which reaches the neighbouring spheres of the sphere a probe is placed in. */
+static const float REFLECTION_PROBE_RADIUS = 2.5f;
+
 Scene::Scene(
         Renderer *renderer
 ) :
@@ -16,6 +26,11 @@ Scene::~Scene()
     for (auto &object : objects) {
         delete object;
     }
+
+    for (auto &probe : reflection_probes) {
+        ReflectionProbe::delete_probe(probe);
+        delete probe;
+    }
 }
 
 void Scene::erase()
@@ -24,18 +39,23 @@ void Scene::erase()
         delete object;
     }
     objects.clear();
+
+    for (auto &probe : reflection_probes) {
+        ReflectionProbe::delete_probe(probe);
+        delete probe;
+    }
+    reflection_probes.clear();
 }
 
 void Scene::construct()
 {
-    objects.emplace_back(
-            (SceneObject *) new Sphere(this, renderer, glm::vec3(-3.f, 0.f, 0.f), Material::MATERIAL_BRICK_1K));
-    objects.emplace_back(
-            (SceneObject *) new Sphere(this, renderer, glm::vec3(-1.f, 0.f, 0.f), Material::MATERIAL_METAL_1K));
-    objects.emplace_back(
-            (SceneObject *) new Sphere(this, renderer, glm::vec3(+1.f, 0.f, 0.f), Material::MATERIAL_DENIM_1K));
-    objects.emplace_back(
-            (SceneObject *) new Sphere(this, renderer, glm::vec3(+3.f, 0.f, 0.f), Material::MATERIAL_MARBLE_1K));
+    // spheres spaced two units apart, centered around the origin
+    for (size_t i = 0; i < SCENE_MATERIALS.size(); i++) {
+        float x = 2.f * (float) i - (float) (SCENE_MATERIALS.size() - 1);
+        objects.emplace_back(
+                (SceneObject *) new Sphere(this, renderer, glm::vec3(x, 0.f, 0.f), SCENE_MATERIALS[i]));
+        add_reflection_probe(objects.back());
+    }
 
     // little bit awkward, but having Light a child of SceneObject allows for nice code elsewhere
     for (auto &light : lights) {
@@ -46,7 +66,8 @@ void Scene::construct()
 void Scene::construct_other()
 {
     objects.emplace_back(
-            (SceneObject *) new Sphere(this, renderer, glm::vec3(0.f), Material::MATERIAL_BRICK_4K));
+            (SceneObject *) new Sphere(this, renderer, glm::vec3(0.f), OTHER_SCENE_MATERIALS[0]));
+    add_reflection_probe(objects.back());
     lights.emplace_back(new Light(this, renderer, glm::vec3(-1.f, 1.f, -1.f), glm::vec3(1.f, 0.f, 0.f)));
     lights.emplace_back(new Light(this, renderer, glm::vec3(-1.f, 1.f, +1.f), glm::vec3(0.f, 1.f, 0.f)));
     lights.emplace_back(new Light(this, renderer, glm::vec3(+1.f, 1.f, -1.f), glm::vec3(0.f, 0.f, 1.f)));
@@ -69,24 +90,90 @@ void Scene::switch_scene()
     scene_one = !scene_one;
 }
 
+void Scene::get_textures(std::vector<uint32_t> *textures)
+{
+    for (auto &object : objects) {
+        object->get_textures(textures);
+    }
+}
+
+void Scene::get_next_textures(std::vector<uint32_t> *textures)
+{
+    for (Material::MaterialType id : scene_one ? OTHER_SCENE_MATERIALS : SCENE_MATERIALS) {
+        Material *material;
+        if (Material::get_material_by_id(id, &material) == EXIT_SUCCESS) {
+            material->get_textures(textures);
+        }
+    }
+}
+
 void Scene::render(bool debug_mode)
 {
+    begin_draw_queue();
+
     // draw all objects
     for (auto &object : objects) {
         object->render(debug_mode);
     }
 
+    // to always draw widget on top, it is queued in the overlay pass
     if (has_selection) {
-        // remove stored depth buffer
-        glClear(GL_DEPTH_BUFFER_BIT);
-
-        // to always draw widget on top
         for (auto &object : objects) {
             if (object->selected) {
                 renderer->render_widget(object->position);
             }
         }
     }
+
+    renderer->submit_draw_queue();
+}
+
+void Scene::render_capture(const ReflectionProbe *probe)
+{
+    begin_draw_queue();
+
+    // the object the probe belongs to would reflect itself, and an object around the probe would cover all its faces
+    for (auto &object : objects) {
+        if (object->reflection_probe != probe && !object->contains(probe->position)) {
+            object->render(false);
+        }
+    }
+
+    renderer->submit_draw_queue();
+}
+
+ReflectionProbe *Scene::find_reflection_probe(glm::vec3 position)
+{
+    ReflectionProbe *closest = nullptr;
+    float closest_distance = std::numeric_limits<float>::max();
+    for (auto &probe : reflection_probes) {
+        float distance = glm::length(position - probe->position);
+        if (ReflectionProbe::contains(probe, position) && distance < closest_distance) {
+            closest_distance = distance;
+            closest = probe;
+        }
+    }
+
+    return closest;
+}
+
+void Scene::move_object(SceneObject *object, glm::vec3 position)
+{
+    invalidate_reflection_probes(object);
+    object->position = position;
+    if (object->reflection_probe) {
+        object->reflection_probe->position = position;
+    }
+    invalidate_reflection_probes(object);
+}
+
+void Scene::invalidate_reflection_probes(SceneObject *object)
+{
+    for (auto &probe : reflection_probes) {
+        if (ReflectionProbe::overlaps(probe, object->position, object->get_bounding_radius())) {
+            probe->dirty = true;
+        }
+    }
 }
 
 void Scene::update()
@@ -119,4 +206,29 @@ void Scene::cast_ray(glm::vec3 origin, glm::vec3 direction)
         has_selection = true;
         closest->selected = true;
     }
-}
\ No newline at end of file
+}
+void Scene::begin_draw_queue()
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> colors;
+    for (auto &light : lights) {
+        positions.emplace_back(light->position);
+        colors.emplace_back(light->color);
+    }
+
+    renderer->begin_draw_queue(positions, colors);
+}
+
+void Scene::add_reflection_probe(SceneObject *object)
+{
+    auto *probe = new ReflectionProbe;
+    if (ReflectionProbe::create_probe(probe, object->position, REFLECTION_PROBE_RADIUS) == EXIT_FAILURE) {
+        nm_log::log(LOG_ERROR, "failed to create reflection probe, objects around it reflect the environment\n");
+        delete probe;
+
+        return;
+    }
+
+    reflection_probes.emplace_back(probe);
+    object->reflection_probe = probe;
+}
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "light.hpp"
+#include "../system/opengl/reflection_probe.hpp"
 #include "../system/camera.hpp"
 #include "../system/manager/shader_manager.hpp"
 #include "../system/manager/texture_manager.hpp"
@@ -19,6 +20,7 @@ private:
 public:
     std::vector<SceneObject *> objects;
     std::vector<Light *> lights;
+    std::vector<ReflectionProbe *> reflection_probes;
     /** Whether a scene object is selected. Redundant information since scene objects also maintain this,
      * but the alternative is a pointer to the selected object, which may go invalid.*/
     bool has_selection = false;
@@ -29,6 +31,7 @@ public:
 
     virtual ~Scene();
 
+    /** Deletes all objects and reflection probes, the latter own OpenGL objects and are deleted while it exists. */
     void erase();
 
     /** Scene with four spheres. */
@@ -41,9 +44,38 @@ public:
 
     void render(bool debug_mode);
 
+    /**
+     * Renders the objects seen from {probe} into its capture, leaving out the object it belongs to and those that
+     * enclose it. */
+    void render_capture(const ReflectionProbe *probe);
+
+    /** Returns the closest reflection probe that {position} lies within, nullptr if there is none. */
+    ReflectionProbe *find_reflection_probe(glm::vec3 position);
+
+    /**
+     * Moves {object} and its reflection probe to {position}, capturing the probes that see any part of it at its old or
+     * new position again. */
+    void move_object(SceneObject *object, glm::vec3 position);
+
+    /** Appends the ids of all textures needed to render the objects in the scene to {textures}. */
+    void get_textures(std::vector<uint32_t> *textures);
+
+    /** Appends the ids of all textures needed by the scene {switch_scene} switches to next to {textures}. */
+    void get_next_textures(std::vector<uint32_t> *textures);
+
     void update();
 
     void cast_ray(glm::vec3 origin, glm::vec3 direction);
+
+private:
+    /** Starts the draw queue of the renderer with the lights of the scene, objects queue their draws into it. */
+    void begin_draw_queue();
+
+    /** Captures the reflection probes that see any part of {object} again. */
+    void invalidate_reflection_probes(SceneObject *object);
+
+    /** Adds a reflection probe at the position of {object}, which moves along with it. */
+    void add_reflection_probe(SceneObject *object);
 };
 
 #endif //SCENE_SCENE_HPP
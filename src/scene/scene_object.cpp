@@ -9,4 +9,17 @@ SceneObject::SceneObject(
 {}
 
 void SceneObject::render(bool debug_mode)
-{}
\ No newline at end of file
+{}
+
+bool SceneObject::contains(glm::vec3)
+{
+    return false;
+}
+
+float SceneObject::get_bounding_radius()
+{
+    return 0.f;
+}
+
+void SceneObject::get_textures(std::vector<uint32_t> *)
+{}
@@ -1,12 +1,17 @@
 #ifndef SCENE_SCENEOBJECT_HPP
 #define SCENE_SCENEOBJECT_HPP
 
+#include <cstdint>
+#include <vector>
+
 #include <glm/vec3.hpp>
 
 class Scene;
 
 class Renderer;
 
+struct ReflectionProbe;
+
 class SceneObject {
 protected:
     Scene *scene;
@@ -16,6 +21,9 @@ public:
 
     bool selected = false;
 
+    /** Probe that moves along with the object and that it reflects, which leaves the object out of its capture. */
+    ReflectionProbe *reflection_probe = nullptr;
+
     SceneObject(Scene *scene, Renderer *renderer, glm::vec3 position);
 
     virtual ~SceneObject() = default;
@@ -23,6 +31,15 @@ public:
     virtual void render(bool debug_mode);
 
     virtual bool hit(float *t, glm::vec3 origin, glm::vec3 direction) = 0;
+
+    /** Whether {point} lies inside the object. */
+    virtual bool contains(glm::vec3 point);
+
+    /** Radius of the sphere around {position} that encloses the object. */
+    virtual float get_bounding_radius();
+
+    /** Appends the ids of all textures needed to render this object to {textures}. */
+    virtual void get_textures(std::vector<uint32_t> *textures);
 };
 
 #endif //SCENE_SCENEOBJECT_HPP
@@ -13,19 +13,30 @@ void Sphere::render(bool debug_mode)
 {
     SceneObject::render(debug_mode);
 
-    std::vector<glm::vec3> positions;
-    std::vector<glm::vec3> colors;
-    for (auto &light : scene->lights) {
-        positions.emplace_back(light->position);
-        colors.emplace_back(light->color);
-    }
-
-    renderer->render_pbr(
-            PRIMITIVE_SPHERE, material, positions, colors,
-            glm::translate(glm::identity<glm::mat4>(), position));
+    renderer->queue_pbr(
+            PRIMITIVE_SPHERE, material, glm::translate(glm::identity<glm::mat4>(), position),
+            reflection_probe ? reflection_probe : scene->find_reflection_probe(position));
 }
 
 bool Sphere::hit(float *t, glm::vec3 origin, glm::vec3 direction)
 {
     return nm_math::ray_sphere(t, origin, direction, position, 1.f);
 }
+
+bool Sphere::contains(glm::vec3 point)
+{
+    return glm::length(point - position) < 1.f;
+}
+
+float Sphere::get_bounding_radius()
+{
+    return 1.f;
+}
+
+void Sphere::get_textures(std::vector<uint32_t> *textures)
+{
+    Material *p_material;
+    if (Material::get_material_by_id(material, &p_material) == EXIT_SUCCESS) {
+        p_material->get_textures(textures);
+    }
+}
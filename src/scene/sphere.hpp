@@ -14,6 +14,12 @@ public:
     void render(bool debug_mode) override;
 
     bool hit(float *t, glm::vec3 origin, glm::vec3 direction) override;
+
+    bool contains(glm::vec3 point) override;
+
+    float get_bounding_radius() override;
+
+    void get_textures(std::vector<uint32_t> *textures) override;
 };
 
 #endif //PBR_SPHERE_HPP
@@ -94,7 +94,10 @@ public:
         P = GLFW_KEY_P,
         SPACE = GLFW_KEY_SPACE,
         BACKSPACE = GLFW_KEY_BACKSPACE,
+        LEFT = GLFW_KEY_LEFT,
         RIGHT = GLFW_KEY_RIGHT,
+        MINUS = GLFW_KEY_MINUS,
+        EQUAL = GLFW_KEY_EQUAL,
         NUM_1 = GLFW_KEY_1,
         NUM_2 = GLFW_KEY_2,
         NUM_3 = GLFW_KEY_3,
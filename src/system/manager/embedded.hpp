@@ -44,29 +44,30 @@ extern const size_t skybox_vert_len;
 extern const char skybox_frag[];
 extern const size_t skybox_frag_len;
 
-extern const char irradiance_map_vert[];
-extern const size_t irradiance_map_vert_len;
-
-extern const char irradiance_map_frag[];
-extern const size_t irradiance_map_frag_len;
-
 extern const char pre_filter_map_vert[];
 extern const size_t pre_filter_map_vert_len;
 
+extern const char pre_filter_map_geom[];
+extern const size_t pre_filter_map_geom_len;
+
 extern const char pre_filter_map_frag[];
 extern const size_t pre_filter_map_frag_len;
 
-extern const char brdf_vert[];
-extern const size_t brdf_vert_len;
+extern const char pre_filter_octahedral_vert[];
+extern const size_t pre_filter_octahedral_vert_len;
 
-extern const char brdf_frag[];
-extern const size_t brdf_frag_len;
+extern const char octahedral_glsl[];
+extern const size_t octahedral_glsl_len;
 
 /** Texture */
 
 extern const char test_png[];
 extern const size_t test_png_len;
 
+/** Texture file generated by {pbr_brdf_lut} during the build. */
+extern const char brdf_lut_tex[];
+extern const size_t brdf_lut_tex_len;
+
 extern const char brick_diff_png[];
 extern const size_t brick_diff_png_len;
 
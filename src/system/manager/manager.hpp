@@ -21,8 +21,10 @@ private:
         T *item;
         /** Whether it was used last frame. */
         bool used;
+        /** Whether it is kept regardless of being used, see {make_resident}. */
+        bool resident;
 
-        Item(T *item, bool used) : item(item), used(used)
+        Item(T *item, bool used) : item(item), used(used), resident(false)
         {};
     };
 
@@ -43,20 +45,16 @@ protected:
     /** Map of all items, indexed by id. */
     std::map<uint32_t, Item> map;
 
-public:
-    /** Pure virtual, to force implementers to call {delete_item} on all remaining items in {map}. */
-    virtual ~Manager() = 0;
-
     /**
-     * Returns a pointer to the requested object indicated by {id}.
-     * Remains valid until the next call to {get} or {make_space}. */
-    // todo error handling
-    T *get(uint32_t id)
+     * Like {get}, but only marks a newly created item as used if {used} is set. An item created with {used} unset
+     * lives until the next call to {make_space}, unless it is requested using {get} before that.
+     * Returns nullptr if the item could not be created. */
+    T *acquire(uint32_t id, bool used)
     {
         // try to find in buffer
         auto item = map.find(id);
         if (item != map.end()) {
-            item->second.used = true;
+            item->second.used |= used;
             return item->second.item;
         }
 
@@ -64,19 +62,46 @@ public:
         T *t;
         if (create_item(&t, id) != EXIT_SUCCESS) {
             nm_log::log(LOG_ERROR, "manager could not create item!\n");
+
+            return nullptr;
         }
 
-        map.insert(std::make_pair(id, Item(t, true)));
+        map.insert(std::make_pair(id, Item(t, used)));
+
+        return t;
+    }
+
+    /** Adds {t}, which is created outside of {create_item}, as the item with {id}. No item with {id} may exist. */
+    void insert(uint32_t id, T *t, bool used)
+    {
+        map.insert(std::make_pair(id, Item(t, used)));
+    }
 
-        return map.find(id)->second.item;
+    /** Excludes the existing item with {id} from {make_space}, such that it lives as long as the manager. */
+    void make_resident(uint32_t id)
+    {
+        map.at(id).resident = true;
+    }
+
+public:
+    /** Pure virtual, to force implementers to call {delete_item} on all remaining items in {map}. */
+    virtual ~Manager() = 0;
+
+    /**
+     * Returns a pointer to the requested object indicated by {id}.
+     * Remains valid until the next call to {get} or {make_space}. */
+    // todo error handling
+    T *get(uint32_t id)
+    {
+        return acquire(id, true);
     }
 
-    /** Deletes and removes from the map all items that were not used in the last frame. */
+    /** Deletes and removes from the map all items that were not used in the last frame, unless they are resident. */
     void make_space()
     {
         // https://stackoverflow.com/questions/8234779/how-to-remove-from-a-map-while-iterating-it
         for (auto it = map.begin(); it != map.end() /* not hoisted */; /* no increment */) {
-            if (!it->second.used) {
+            if (!it->second.used && !it->second.resident) {
                 // deallocate all items not used
                 delete_item(&it->second.item, it->first);
                 // remove from map
@@ -0,0 +1,179 @@
+#include "resource_pack.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "../../util/nm_log.hpp"
+#include "../../util/util.hpp"
+
+static const char MAGIC[4] = {'P', 'B', 'R', 'P'};
+
+/** Header at the start of the pack, followed by the table of contents. */
+struct PackHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t alignment;
+};
+
+const uint32_t ResourcePack::VERSION = 1;
+const uint32_t ResourcePack::ALIGNMENT = 64 * 1024;
+
+static uint64_t hash_name(const char *name)
+{
+    return Util::hash(name, strlen(name));
+}
+
+static uint64_t align(uint64_t offset)
+{
+    return (offset + ResourcePack::ALIGNMENT - 1) / ResourcePack::ALIGNMENT * ResourcePack::ALIGNMENT;
+}
+
+int ResourcePack::write(const char *file_name, const std::vector<const char *> &names)
+{
+    // read all files up front, the table of contents precedes them
+    struct Loaded {
+        Entry entry;
+        const char *name;
+        char *buffer;
+    };
+    std::vector<Loaded> loaded;
+    for (const char *name : names) {
+        char *buffer = nullptr;
+        size_t size;
+        if (Util::read_file(&buffer, &size, name) == EXIT_FAILURE) {
+            nm_log::log(LOG_WARN, "skipping \"%s\"\n", name);
+            delete[] buffer;
+            continue;
+        }
+        loaded.push_back(Loaded{Entry{hash_name(name), 0, size}, name, buffer});
+    }
+
+    std::sort(loaded.begin(), loaded.end(), [](const Loaded &a, const Loaded &b) {
+        return a.entry.name_hash < b.entry.name_hash;
+    });
+
+    int rval = EXIT_SUCCESS;
+    for (size_t i = 1; i < loaded.size(); i++) {
+        if (loaded[i].entry.name_hash == loaded[i - 1].entry.name_hash) {
+            nm_log::log(LOG_ERROR, "\"%s\" and \"%s\" have the same name hash\n", loaded[i - 1].name, loaded[i].name);
+            rval = EXIT_FAILURE;
+        }
+    }
+
+    uint64_t offset = align(sizeof(PackHeader) + loaded.size() * sizeof(Entry));
+    for (auto &item : loaded) {
+        item.entry.offset = offset;
+        offset = align(offset + item.entry.size);
+    }
+
+    FILE *file = rval == EXIT_SUCCESS ? fopen(file_name, "wb") : nullptr;
+    if (rval == EXIT_SUCCESS && !file) {
+        nm_log::log(LOG_ERROR, "failed to open file \"%s\" for writing\n", file_name);
+        rval = EXIT_FAILURE;
+    }
+
+    if (file) {
+        PackHeader header{{MAGIC[0], MAGIC[1], MAGIC[2], MAGIC[3]}, VERSION, (uint32_t) loaded.size(), ALIGNMENT};
+        bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+        uint64_t position = sizeof(header);
+        for (const auto &item : loaded) {
+            written = written && fwrite(&item.entry, sizeof(item.entry), 1, file) == 1;
+            position += sizeof(item.entry);
+        }
+        for (const auto &item : loaded) {
+            // zero padding up to the aligned offset
+            for (; written && position < item.entry.offset; position++) {
+                written = fputc(0, file) != EOF;
+            }
+            written = written && fwrite(item.buffer, sizeof(char), item.entry.size, file) == item.entry.size;
+            position += item.entry.size;
+            nm_log::log(LOG_INFO, "packed \"%s\" (%zu bytes)\n", item.name, (size_t) item.entry.size);
+        }
+        fclose(file);
+
+        if (!written) {
+            nm_log::log(LOG_ERROR, "failed to write resource pack \"%s\"\n", file_name);
+            rval = EXIT_FAILURE;
+        }
+    }
+
+    for (auto &item : loaded) {
+        delete[] item.buffer;
+    }
+
+    return rval;
+}
+
+int ResourcePack::open(ResourcePack *pack, const char *file_name)
+{
+    if (MappedFile::map_file(&pack->mapped_file, file_name) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    PackHeader header{};
+    const uint8_t *data = pack->mapped_file.data;
+    size_t size = pack->mapped_file.size;
+    if (size >= sizeof(header)) {
+        memcpy(&header, data, sizeof(header));
+    }
+
+    bool valid = memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.version == VERSION &&
+                 header.alignment == ALIGNMENT && (size - sizeof(header)) / sizeof(Entry) >= header.entry_count;
+    const auto *entries = (const Entry *) (data + sizeof(header));
+    for (uint32_t i = 0; valid && i < header.entry_count; i++) {
+        valid = entries[i].offset <= size && entries[i].size <= size - entries[i].offset;
+    }
+
+    if (!valid) {
+        nm_log::log(LOG_ERROR, "\"%s\" is not a valid version %d resource pack\n", file_name, VERSION);
+        MappedFile::unmap_file(&pack->mapped_file);
+
+        return EXIT_FAILURE;
+    }
+
+    pack->entries = entries;
+    pack->entry_count = header.entry_count;
+    nm_log::log(LOG_INFO, "mapped resource pack \"%s\" with %d entries\n", file_name, pack->entry_count);
+
+    return EXIT_SUCCESS;
+}
+
+void ResourcePack::close(ResourcePack *pack)
+{
+    MappedFile::unmap_file(&pack->mapped_file);
+    pack->entries = nullptr;
+    pack->entry_count = 0;
+}
+
+const ResourcePack::Entry *ResourcePack::find_entry(const char *name) const
+{
+    uint64_t name_hash = hash_name(name);
+    const Entry *end = entries + entry_count;
+    const Entry *entry = std::lower_bound(entries, end, name_hash, [](const Entry &entry, uint64_t hash) {
+        return entry.name_hash < hash;
+    });
+
+    return entry != end && entry->name_hash == name_hash ? entry : nullptr;
+}
+
+int ResourcePack::find(const char *name, const uint8_t **data, size_t *size) const
+{
+    const Entry *entry = find_entry(name);
+    if (!entry) {
+        return EXIT_FAILURE;
+    }
+
+    *data = mapped_file.data + entry->offset;
+    *size = entry->size;
+
+    return EXIT_SUCCESS;
+}
+
+void ResourcePack::prefetch(const char *name) const
+{
+    const Entry *entry = find_entry(name);
+    if (entry) {
+        MappedFile::prefetch(&mapped_file, entry->offset, entry->size);
+    }
+}
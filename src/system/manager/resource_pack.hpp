@@ -0,0 +1,49 @@
+#ifndef SYSTEM_RESOURCE_PACK_HPP
+#define SYSTEM_RESOURCE_PACK_HPP
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "../../util/mapped_file.hpp"
+
+/**
+ * A single file holding many resource files, written by {pbr_pack}. It starts with a table of contents sorted by the
+ * hash of the entry names, followed by the entries, each aligned to {ALIGNMENT}. The pack is mapped into memory once,
+ * files in it are accessed through pointers into the mapping without reading or copying them. */
+struct ResourcePack {
+    /** Bumped whenever the layout changes, packs of other versions are not opened. */
+    static const uint32_t VERSION;
+
+    /** Alignment in bytes of the entries, a multiple of the page size such that entries can be prefetched alone. */
+    static const uint32_t ALIGNMENT;
+
+    /** Writes the files {names} into a pack, in which they are found by the same name. Missing files are skipped. */
+    static int write(const char *file_name, const std::vector<const char *> &names);
+
+    static int open(ResourcePack *pack, const char *file_name);
+
+    static void close(ResourcePack *pack);
+
+    /** Returns {EXIT_SUCCESS} and points {data} at the {size} bytes of the entry called {name} if the pack holds it. */
+    int find(const char *name, const uint8_t **data, size_t *size) const;
+
+    /** Starts reading the entry called {name} into memory in the background, if the pack holds it. */
+    void prefetch(const char *name) const;
+
+private:
+    struct Entry {
+        uint64_t name_hash;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    MappedFile mapped_file;
+    /** Points into {mapped_file}, {entry_count} entries sorted by {Entry::name_hash}. */
+    const Entry *entries = nullptr;
+    uint32_t entry_count = 0;
+
+    const Entry *find_entry(const char *name) const;
+};
+
+#endif //SYSTEM_RESOURCE_PACK_HPP
@@ -6,15 +6,15 @@ template<>
 inline Manager<ShaderProgram>::~Manager<ShaderProgram>() = default;
 
 const std::map<uint32_t, ShaderManager::ShaderResource> ShaderManager::SHADER_PROGRAM_RESOURCES = {
-        {SHADER_DEFAULT,             {default_vert,             &default_vert_len,             default_frag,             &default_frag_len}},
-        {SHADER_PHONG,               {phong_vert,               &phong_vert_len,               phong_frag,               &phong_frag_len}},
-        {SHADER_LINES,               {lines_vert,               &lines_vert_len,               lines_frag,               &lines_frag_len}},
-        {SHADER_PBR,                 {pbr_vert,                 &pbr_vert_len,                 pbr_frag,                 &pbr_frag_len}},
-        {SHADER_EQUIRECTANGULAR_MAP, {equirectangular_map_vert, &equirectangular_map_vert_len, equirectangular_map_frag, &equirectangular_map_frag_len}},
-        {SHADER_SKYBOX,              {skybox_vert,              &skybox_vert_len,              skybox_frag,              &skybox_frag_len}},
-        {SHADER_IRRADIANCE_MAP,      {irradiance_map_vert,      &irradiance_map_vert_len,      irradiance_map_frag,      &irradiance_map_frag_len}},
-        {SHADER_PRE_FILTER_MAP,      {pre_filter_map_vert,      &pre_filter_map_vert_len,      pre_filter_map_frag,      &pre_filter_map_frag_len}},
-        {SHADER_BRDF,                {brdf_vert,                &brdf_vert_len,                brdf_frag,                &brdf_frag_len}},
+        {SHADER_DEFAULT,             {default_vert,             &default_vert_len,             default_frag,             &default_frag_len,             nullptr,                nullptr,         nullptr}},
+        {SHADER_PHONG,               {phong_vert,               &phong_vert_len,               phong_frag,               &phong_frag_len,               nullptr,                nullptr,         nullptr}},
+        {SHADER_LINES,               {lines_vert,               &lines_vert_len,               lines_frag,               &lines_frag_len,               nullptr,                nullptr,         nullptr}},
+        {SHADER_PBR,                 {pbr_vert,                 &pbr_vert_len,                 pbr_frag,                 &pbr_frag_len,                 nullptr,                nullptr,         nullptr}},
+        {SHADER_EQUIRECTANGULAR_MAP, {equirectangular_map_vert, &equirectangular_map_vert_len, equirectangular_map_frag, &equirectangular_map_frag_len, nullptr,                nullptr,         nullptr}},
+        {SHADER_SKYBOX,              {skybox_vert,              &skybox_vert_len,              skybox_frag,              &skybox_frag_len,              nullptr,                nullptr,         nullptr}},
+        {SHADER_PRE_FILTER_MAP,      {pre_filter_map_vert,      &pre_filter_map_vert_len,      pre_filter_map_frag,      &pre_filter_map_frag_len,      nullptr,                nullptr,         nullptr}},
+        {SHADER_PBR_OCTAHEDRAL,      {pbr_vert,                 &pbr_vert_len,                 pbr_frag,                 &pbr_frag_len,                 "#define OCTAHEDRAL\n", octahedral_glsl, &octahedral_glsl_len}},
+        {SHADER_SKYBOX_OCTAHEDRAL,   {skybox_vert,              &skybox_vert_len,              skybox_frag,              &skybox_frag_len,              "#define OCTAHEDRAL\n", octahedral_glsl, &octahedral_glsl_len}},
 };
 
 int32_t ShaderManager::create_item(ShaderProgram **item, uint32_t id)
@@ -32,7 +32,10 @@ int32_t ShaderManager::create_item(ShaderProgram **item, uint32_t id)
     int32_t rval = ShaderProgram::create_shader_program(
             *item,
             entry->second.vert_text, *entry->second.vert_len,
-            entry->second.frag_text, *entry->second.frag_len);
+            nullptr, 0,
+            entry->second.frag_text, *entry->second.frag_len,
+            entry->second.defines,
+            entry->second.library_text, entry->second.library_text ? *entry->second.library_len : 0);
     if (rval == EXIT_FAILURE) {
         nm_log::log(LOG_ERROR, "failed to create shader program\n");
 
@@ -14,9 +14,10 @@ enum ShaderType {
     SHADER_PBR,
     SHADER_EQUIRECTANGULAR_MAP,
     SHADER_SKYBOX,
-    SHADER_IRRADIANCE_MAP,
     SHADER_PRE_FILTER_MAP,
-    SHADER_BRDF
+    /** Variants of {SHADER_PBR} and {SHADER_SKYBOX} for environments in the octahedral layout of {IblTier}. */
+    SHADER_PBR_OCTAHEDRAL,
+    SHADER_SKYBOX_OCTAHEDRAL
 };
 
 class ShaderManager : public Manager<ShaderProgram> {
@@ -27,6 +28,11 @@ private:
         const size_t *vert_len;
         const char *frag_text;
         const size_t *frag_len;
+        /** Preprocessor definitions the shaders are compiled with, null if none. */
+        const char *defines;
+        /** Functions inserted after {defines}, null if none. */
+        const char *library_text;
+        const size_t *library_len;
     };
 
     /** Array to obtain the desired data using an id. */
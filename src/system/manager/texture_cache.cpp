@@ -0,0 +1,250 @@
+#include "texture_cache.hpp"
+
+#include <atomic>
+#include <cinttypes>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#ifdef _WIN32
+
+#include <windows.h>
+#include <direct.h>
+#include <sys/utime.h>
+
+#else
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+#endif
+
+#include "../../util/nm_log.hpp"
+
+static const char MAGIC[4] = {'P', 'B', 'R', 'C'};
+
+/** Suffix of entries that are being written, which are neither loaded nor evicted. */
+static const char TEMPORARY_SUFFIX[] = ".tmp";
+
+/**
+ * Serialises the changes to the directory: moving entries into place, removing them, and eviction. Entries are written
+ * to a temporary file without it, such that threads storing different entries do not wait on each other's writes. */
+static std::mutex directory_mutex;
+
+/** Makes the temporary file names of concurrent stores of the same key differ. */
+static std::atomic<uint32_t> temporary_count{0};
+
+/** A file in the cache directory, with its last modification as a time that only needs to order the entries. */
+struct Entry {
+    std::string file_name;
+    uint64_t size;
+    uint64_t last_used;
+};
+
+/** Returns whether {file_name} is an entry that is still being written by a store. */
+static bool is_temporary(const std::string &file_name)
+{
+    size_t length = file_name.size();
+    return length >= strlen(TEMPORARY_SUFFIX) &&
+           file_name.compare(length - strlen(TEMPORARY_SUFFIX), std::string::npos, TEMPORARY_SUFFIX) == 0;
+}
+
+#ifdef _WIN32
+
+static void make_directory(const char *directory)
+{
+    _mkdir(directory);
+}
+
+static void touch_file(const char *file_name)
+{
+    _utime(file_name, nullptr);
+}
+
+/** Appends the complete entries of {directory} to {entries}, returns {EXIT_FAILURE} if it cannot be listed. */
+static int list_entries(const char *directory, std::vector<Entry> *entries)
+{
+    std::string pattern = std::string(directory) + "/*";
+    WIN32_FIND_DATAA find_data;
+    HANDLE find = FindFirstFileA(pattern.c_str(), &find_data);
+    if (find == INVALID_HANDLE_VALUE) {
+        return EXIT_FAILURE;
+    }
+
+    do {
+        if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+
+        std::string file_name = std::string(directory) + "/" + find_data.cFileName;
+        if (is_temporary(file_name)) continue;
+
+        uint64_t size = ((uint64_t) find_data.nFileSizeHigh << 32) | find_data.nFileSizeLow;
+        uint64_t last_used = ((uint64_t) find_data.ftLastWriteTime.dwHighDateTime << 32) |
+                             find_data.ftLastWriteTime.dwLowDateTime;
+        entries->push_back({file_name, size, last_used});
+    } while (FindNextFileA(find, &find_data));
+    FindClose(find);
+
+    return EXIT_SUCCESS;
+}
+
+#else
+
+static void make_directory(const char *directory)
+{
+    mkdir(directory, 0755);
+}
+
+static void touch_file(const char *file_name)
+{
+    utime(file_name, nullptr);
+}
+
+/** Appends the complete entries of {directory} to {entries}, returns {EXIT_FAILURE} if it cannot be listed. */
+static int list_entries(const char *directory, std::vector<Entry> *entries)
+{
+    DIR *dir = opendir(directory);
+    if (!dir) {
+        return EXIT_FAILURE;
+    }
+
+    for (dirent *ent = readdir(dir); ent != nullptr; ent = readdir(dir)) {
+        std::string file_name = std::string(directory) + "/" + ent->d_name;
+        struct stat st{};
+        if (stat(file_name.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+
+        // entries being written by another store are not complete yet
+        if (is_temporary(file_name)) continue;
+
+        entries->push_back({file_name, (uint64_t) st.st_size, (uint64_t) st.st_mtime});
+    }
+    closedir(dir);
+
+    return EXIT_SUCCESS;
+}
+
+#endif
+
+const char *const TextureCache::DIRECTORY = "texture_cache";
+const uint64_t TextureCache::MAX_SIZE = 256ull * 1024ull * 1024ull;
+const uint32_t TextureCache::VERSION = 1;
+
+int TextureCache::load(uint64_t key, TextureData *data)
+{
+    char file_name[256];
+    get_file_name(file_name, sizeof(file_name), key);
+
+    FILE *file = fopen(file_name, "rb");
+    if (!file) {
+        nm_log::log(LOG_INFO, "texture cache miss for %016" PRIx64 "\n", key);
+
+        return EXIT_FAILURE;
+    }
+
+    char magic[4];
+    uint32_t version;
+    uint64_t stored_key;
+    if (fread(magic, sizeof(magic), 1, file) != 1 ||
+        fread(&version, sizeof(version), 1, file) != 1 ||
+        fread(&stored_key, sizeof(stored_key), 1, file) != 1 ||
+        memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION || stored_key != key ||
+        TextureData::read(data, file) == EXIT_FAILURE) {
+        nm_log::log(LOG_WARN, "texture cache entry %016" PRIx64 " is invalid, removing it\n", key);
+        fclose(file);
+        std::unique_lock<std::mutex> lock(directory_mutex);
+        remove(file_name);
+
+        return EXIT_FAILURE;
+    }
+    fclose(file);
+
+    // touch the entry so eviction sees it as recently used
+    touch_file(file_name);
+
+    nm_log::log(LOG_INFO, "texture cache hit for %016" PRIx64 "\n", key);
+
+    return EXIT_SUCCESS;
+}
+
+int TextureCache::store(uint64_t key, const TextureData *data)
+{
+    make_directory(DIRECTORY);
+
+    char file_name[256];
+    get_file_name(file_name, sizeof(file_name), key);
+
+    // written under another name and moved into place, such that a concurrent {load} never reads a partial entry
+    char temporary_name[288];
+    snprintf(temporary_name, sizeof(temporary_name), "%s.%u%s", file_name, temporary_count++, TEMPORARY_SUFFIX);
+
+    FILE *file = fopen(temporary_name, "wb");
+    if (!file) {
+        nm_log::log(LOG_WARN, "failed to open texture cache entry \"%s\" for writing\n", temporary_name);
+
+        return EXIT_FAILURE;
+    }
+
+    // closing flushes the last of the entry, which may fail as well
+    bool written = fwrite(MAGIC, sizeof(MAGIC), 1, file) == 1 &&
+                   fwrite(&VERSION, sizeof(VERSION), 1, file) == 1 &&
+                   fwrite(&key, sizeof(key), 1, file) == 1 &&
+                   TextureData::write(data, file) == EXIT_SUCCESS;
+    if (fclose(file) != 0 || !written) {
+        nm_log::log(LOG_WARN, "failed to write texture cache entry \"%s\"\n", temporary_name);
+        remove(temporary_name);
+
+        return EXIT_FAILURE;
+    }
+
+    std::unique_lock<std::mutex> lock(directory_mutex);
+#ifdef _WIN32
+    // rename does not replace an existing file on windows
+    remove(file_name);
+#endif
+    if (rename(temporary_name, file_name) != 0) {
+        nm_log::log(LOG_WARN, "failed to move texture cache entry \"%s\" into place\n", temporary_name);
+        remove(temporary_name);
+
+        return EXIT_FAILURE;
+    }
+
+    nm_log::log(LOG_INFO, "stored texture cache entry %016" PRIx64 " (%" PRIu64 " bytes)\n", key,
+                (uint64_t) data->data.size());
+
+    evict();
+
+    return EXIT_SUCCESS;
+}
+
+void TextureCache::get_file_name(char *buffer, size_t buffer_size, uint64_t key)
+{
+    snprintf(buffer, buffer_size, "%s/%016" PRIx64 ".tex", DIRECTORY, key);
+}
+
+void TextureCache::evict()
+{
+    std::vector<Entry> entries;
+    if (list_entries(DIRECTORY, &entries) == EXIT_FAILURE) return;
+
+    uint64_t total_size = 0;
+    for (auto &entry : entries) {
+        total_size += entry.size;
+    }
+
+    if (total_size <= MAX_SIZE) return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.last_used < b.last_used;
+    });
+
+    for (auto &entry : entries) {
+        if (total_size <= MAX_SIZE) break;
+
+        if (remove(entry.file_name.c_str()) == 0) {
+            total_size -= entry.size;
+            nm_log::log(LOG_INFO, "evicted texture cache entry \"%s\"\n", entry.file_name.c_str());
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef SYSTEM_TEXTURE_CACHE_HPP
+#define SYSTEM_TEXTURE_CACHE_HPP
+
+#include <cstdint>
+
+#include "../opengl/texture_data.hpp"
+
+/**
+ * Content-addressed disk cache for generated textures. Entries are keyed by a hash of everything the texture is
+ * derived from, so a changed source, shader or parameter simply results in a different key. Unused entries are
+ * evicted least recently used first once the cache grows beyond {MAX_SIZE}. */
+struct TextureCache {
+    /** Directory the entries are stored in, relative to the working directory. */
+    static const char *const DIRECTORY;
+
+    /** Maximum size in bytes of all entries together. */
+    static const uint64_t MAX_SIZE;
+
+    /** Bumped whenever the entry layout changes, entries of other versions are treated as misses and removed. */
+    static const uint32_t VERSION;
+
+    /** Returns {EXIT_SUCCESS} and fills in {data} if an entry with {key} exists. */
+    static int load(uint64_t key, TextureData *data);
+
+    /**
+     * Stores {data} under {key}, evicting old entries if needed. May be called from any thread, concurrently with
+     * {load} and other stores. */
+    static int store(uint64_t key, const TextureData *data);
+
+private:
+    static void get_file_name(char *buffer, size_t buffer_size, uint64_t key);
+
+    /** Deletes least recently used entries until the cache is within {MAX_SIZE}, the directory mutex must be held. */
+    static void evict();
+};
+
+#endif //SYSTEM_TEXTURE_CACHE_HPP
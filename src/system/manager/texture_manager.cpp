@@ -1,211 +1,1843 @@
 #include "texture_manager.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
 #include "embedded.hpp"
+#include "texture_cache.hpp"
+#include "../opengl/cubemap_converter.hpp"
 #include "../opengl/texture.hpp"
+#include "../opengl/texture_file.hpp"
+#include "../../util/util.hpp"
+
+// provide a default destructor for the base class
+template<>
+inline Manager<Texture>::~Manager<Texture>() = default;
+
+TextureManager::TextureResource::TextureResource(Semantic semantic, uint32_t texture_unit, WrapType wrap_type) :
+        semantic(semantic), texture_unit(texture_unit), wrap_type(wrap_type)
+{}
+
+bool TextureManager::TextureResource::can_decode() const
+{
+    return false;
+}
+
+int TextureManager::TextureResource::decode(TextureData *) const
+{
+    nm_log::log(LOG_ERROR, "texture resource cannot be decoded\n");
+
+    return EXIT_FAILURE;
+}
+
+void TextureManager::TextureResource::prefetch_file() const
+{}
+
+int TextureManager::TextureResource::project_irradiance(SphericalHarmonics *) const
+{
+    nm_log::log(LOG_ERROR, "texture resource is not an environment cubemap\n");
+
+    return EXIT_FAILURE;
+}
+
+int TextureManager::TextureResource::extract_dominant_light(DominantLight *) const
+{
+    nm_log::log(LOG_ERROR, "texture resource is not an environment cubemap\n");
+
+    return EXIT_FAILURE;
+}
+
+int TextureManager::TextureResource::generate(TextureData *) const
+{
+    nm_log::log(LOG_ERROR, "texture resource cannot be generated without OpenGL\n");
+
+    return EXIT_FAILURE;
+}
+
+uint64_t TextureManager::TextureResource::get_hash() const
+{
+    // resources are shared by the render thread, the loader thread and the workers of {decode_pool}
+    std::call_once(hashed, [this] { hash = compute_hash(); });
+
+    return hash;
+}
+
+uint64_t TextureManager::TextureResource::hash_parameters(uint64_t p_hash) const
+{
+    p_hash = Util::hash(&semantic, sizeof(semantic), p_hash);
+    p_hash = Util::hash(&wrap_type, sizeof(wrap_type), p_hash);
+
+    return p_hash;
+}
+
+TextureManager::TextureResourceFromMemory::TextureResourceFromMemory(
+        Semantic semantic, uint32_t texture_unit, WrapType wrap_type, const char *text, const size_t *len
+) : TextureResource(semantic, texture_unit, wrap_type), text(text), len(len)
+{}
+
+int TextureManager::TextureResourceFromMemory::create_texture(TextureManager *, Texture *texture) const
+{
+    return Texture::create_tex_from_mem(texture, text, *len, semantic, texture_unit, wrap_type);
+}
+
+bool TextureManager::TextureResourceFromMemory::can_decode() const
+{
+    return true;
+}
+
+int TextureManager::TextureResourceFromMemory::decode(TextureData *data) const
+{
+    return Texture::decode_tex(data, text, *len, semantic);
+}
+
+uint64_t TextureManager::TextureResourceFromMemory::compute_hash() const
+{
+    return Util::hash(text, *len, hash_parameters(Util::HASH_SEED));
+}
+
+TextureManager::TextureResourceFromFile::TextureResourceFromFile(
+        Semantic semantic, uint32_t texture_unit, WrapType wrap_type, const char *file_name
+) : TextureResource(semantic, texture_unit, wrap_type), file_name(file_name)
+{}
+
+int TextureManager::TextureResourceFromFile::create_texture(TextureManager *, Texture *texture) const
+{
+    TextureData data{};
+    if (decode(&data) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    return Texture::upload_tex(texture, &data, texture_unit, wrap_type);
+}
+
+bool TextureManager::TextureResourceFromFile::can_decode() const
+{
+    return true;
+}
+
+int TextureManager::TextureResourceFromFile::decode(TextureData *data) const
+{
+    const uint8_t *packed;
+    size_t packed_size;
+    if (pack.find(file_name, &packed, &packed_size) == EXIT_SUCCESS) {
+        return Texture::decode_tex(data, (const char *) packed, packed_size, semantic);
+    }
+
+    char *buffer = nullptr;
+    size_t size;
+    if (Util::read_file(&buffer, &size, file_name) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    int rval = Texture::decode_tex(data, buffer, size, semantic);
+
+    delete[] buffer;
+
+    return rval;
+}
+
+void TextureManager::TextureResourceFromFile::prefetch_file() const
+{
+    pack.prefetch(file_name);
+}
+
+uint64_t TextureManager::TextureResourceFromFile::compute_hash() const
+{
+    uint64_t file_hash = hash_parameters(Util::HASH_SEED);
+
+    const uint8_t *packed;
+    size_t packed_size;
+    if (pack.find(file_name, &packed, &packed_size) == EXIT_SUCCESS) {
+        return Util::hash(packed, packed_size, file_hash);
+    }
+
+    char *buffer = nullptr;
+    size_t size;
+    if (Util::read_file(&buffer, &size, file_name) == EXIT_SUCCESS) {
+        file_hash = Util::hash(buffer, size, file_hash);
+    } else {
+        // hash the name instead, the texture itself will fail to load
+        file_hash = Util::hash(file_name, strlen(file_name), file_hash);
+    }
+    delete[] buffer;
+
+    return file_hash;
+}
+
+TextureManager::TextureResourceFromTextureResource::TextureResourceFromTextureResource(
+        TextureType texture_type, uint32_t texture_unit, int (*create_function)(Texture *, Texture *, uint32_t)
+) :
+        TextureResource(static_cast<Semantic>(0), texture_unit, static_cast<WrapType>(0)),
+        texture_type(texture_type), create_function(create_function)
+{}
+
+int TextureManager::TextureResourceFromTextureResource::create_texture(TextureManager *manager, Texture *texture) const
+{
+    Texture::GeneratorInfo info{};
+    if (Texture::get_generator_info(create_function, &info) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    // try the cache first, this skips creating the resource texture altogether
+    uint64_t key = get_hash();
+    TextureData data{};
+    if (TextureCache::load(key, &data) == EXIT_SUCCESS) {
+        return Texture::create_tex_from_data(texture, &data, texture_unit, CLAMP);
+    }
+
+    // obtain the resource texture through the manager, textures derived from the same resource share it
+    Texture *resource_texture = manager->get_intermediate(texture_type);
+    if (!resource_texture) {
+        nm_log::log(LOG_ERROR, "failed to create resource texture with id \"%d\"\n", texture_type);
+
+        return EXIT_FAILURE;
+    }
+
+    // create the desired texture using obtained texture
+    int rval = create_function(texture, resource_texture, texture_unit);
+
+    if (rval == EXIT_SUCCESS && Texture::read_tex(texture, &data, info.level_count) == EXIT_SUCCESS) {
+        TextureCache::store(key, &data);
+    }
+
+    return rval;
+}
+
+int TextureManager::TextureResourceFromTextureResource::generate(TextureData *data) const
+{
+    return TextureCache::load(get_hash(), data);
+}
+
+uint64_t TextureManager::TextureResourceFromTextureResource::compute_hash() const
+{
+    auto resource = TEXTURE_RESOURCES.find(texture_type);
+    if (resource == TEXTURE_RESOURCES.end()) {
+        nm_log::log(LOG_ERROR, "texture type cannot be found in defined texture resources\n");
+
+        return 0;
+    }
+
+    Texture::GeneratorInfo info{};
+    Texture::get_generator_info(create_function, &info);
+
+    uint64_t source_hash = resource->second->get_hash();
+    uint64_t p_hash = Util::hash(&source_hash, sizeof(source_hash));
+    p_hash = Util::hash(info.name, strlen(info.name), p_hash);
+    p_hash = Util::hash(&info.resolution, sizeof(info.resolution), p_hash);
+    p_hash = Util::hash(&info.internal_format, sizeof(info.internal_format), p_hash);
+    p_hash = Util::hash(&info.level_count, sizeof(info.level_count), p_hash);
+    p_hash = Util::hash(&info.max_sample_count, sizeof(info.max_sample_count), p_hash);
+    p_hash = Util::hash(&info.version, sizeof(info.version), p_hash);
+    p_hash = Util::hash(info.vert_text, *info.vert_len, p_hash);
+    if (info.geom_text) {
+        p_hash = Util::hash(info.geom_text, *info.geom_len, p_hash);
+    }
+    p_hash = Util::hash(info.frag_text, *info.frag_len, p_hash);
+    if (info.defines) {
+        p_hash = Util::hash(info.defines, strlen(info.defines), p_hash);
+    }
+    if (info.library_text) {
+        p_hash = Util::hash(info.library_text, *info.library_len, p_hash);
+    }
+
+    return p_hash;
+}
+
+TextureManager::TextureResourceFromEquirectangular::TextureResourceFromEquirectangular(
+        TextureType texture_type, uint32_t texture_unit
+) :
+        TextureResource(RADIANCE, texture_unit, CLAMP), texture_type(texture_type)
+{}
+
+int TextureManager::TextureResourceFromEquirectangular::create_texture(TextureManager *, Texture *texture) const
+{
+    TextureData data{};
+    if (convert(&data) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    return Texture::create_tex_from_data(texture, &data, texture_unit, CLAMP);
+}
+
+int TextureManager::TextureResourceFromEquirectangular::project_irradiance(SphericalHarmonics *irradiance) const
+{
+    const char *name = "irradiance";
+    uint64_t key = get_hash();
+    key = Util::hash(name, strlen(name), key);
+    key = Util::hash(&SphericalHarmonics::VERSION, sizeof(SphericalHarmonics::VERSION), key);
+
+    TextureData data{};
+    if (TextureCache::load(key, &data) == EXIT_SUCCESS &&
+        SphericalHarmonics::read_texture_data(irradiance, &data) == EXIT_SUCCESS) {
+        return EXIT_SUCCESS;
+    }
+
+    TextureData cubemap{};
+    if (convert(&cubemap) == EXIT_FAILURE ||
+        SphericalHarmonics::project_irradiance(irradiance, &cubemap) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    SphericalHarmonics::write_texture_data(irradiance, &data);
+    TextureCache::store(key, &data);
+
+    return EXIT_SUCCESS;
+}
+
+int TextureManager::TextureResourceFromEquirectangular::extract_dominant_light(DominantLight *light) const
+{
+    TextureData data{};
+    if (TextureCache::load(get_dominant_light_key(), &data) == EXIT_SUCCESS &&
+        DominantLight::read_texture_data(light, &data) == EXIT_SUCCESS) {
+        return EXIT_SUCCESS;
+    }
+
+    TextureData equirectangular{};
+
+    return decode_without_light(&equirectangular, light);
+}
+
+int TextureManager::TextureResourceFromEquirectangular::generate(TextureData *data) const
+{
+    return convert(data);
+}
+
+/**
+ * Workers shared by all conversions, which run on the workers of {decode_pool} or on the loader thread and therefore
+ * cannot wait on that pool. Started on first use, as cached conversions never need it. */
+static ThreadPool *get_conversion_pool()
+{
+    static ThreadPool pool;
+
+    return &pool;
+}
+
+int TextureManager::TextureResourceFromEquirectangular::convert(TextureData *data) const
+{
+    uint64_t key = get_hash();
+    if (TextureCache::load(key, data) == EXIT_SUCCESS) {
+        return EXIT_SUCCESS;
+    }
+
+    // the image is only decoded, the source is never uploaded
+    TextureData equirectangular{};
+    DominantLight light{};
+    const IblTier *tier = IblTier::get();
+    if (decode_without_light(&equirectangular, &light) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    if (IblTier::get_layout() == IblTier::OCTAHEDRAL) {
+        uint32_t resolution = IblTier::get_layout_resolution(tier->cubemap_resolution);
+        if (CubemapConverter::convert_octahedral(data, &equirectangular, resolution, get_conversion_pool()) ==
+            EXIT_FAILURE) {
+            return EXIT_FAILURE;
+        }
+    } else if (CubemapConverter::convert(data, &equirectangular, tier->cubemap_resolution, get_conversion_pool()) ==
+               EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    if (TextureData::convert_rgb(data, tier->cubemap_format) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    TextureCache::store(key, data);
+
+    return EXIT_SUCCESS;
+}
+
+int TextureManager::TextureResourceFromEquirectangular::decode_without_light(
+        TextureData *equirectangular, DominantLight *light) const
+{
+    auto resource = TEXTURE_RESOURCES.find(texture_type);
+    if (resource == TEXTURE_RESOURCES.end() || !resource->second->can_decode()) {
+        nm_log::log(LOG_ERROR, "texture with id \"%d\" cannot be decoded as equirectangular image\n", texture_type);
+
+        return EXIT_FAILURE;
+    }
+
+    if (resource->second->decode(equirectangular) == EXIT_FAILURE ||
+        DominantLight::extract(light, equirectangular) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    // stored right away, such that the light is found without decoding the image again once the cubemap is cached
+    TextureData data{};
+    DominantLight::write_texture_data(light, &data);
+    TextureCache::store(get_dominant_light_key(), &data);
+
+    return EXIT_SUCCESS;
+}
+
+uint64_t TextureManager::TextureResourceFromEquirectangular::get_dominant_light_key() const
+{
+    const char *name = "dominant light";
+    uint64_t key = get_hash();
+
+    return Util::hash(name, strlen(name), key);
+}
+
+uint64_t TextureManager::TextureResourceFromEquirectangular::compute_hash() const
+{
+    auto resource = TEXTURE_RESOURCES.find(texture_type);
+    if (resource == TEXTURE_RESOURCES.end()) {
+        nm_log::log(LOG_ERROR, "texture type cannot be found in defined texture resources\n");
+
+        return 0;
+    }
+
+    const char *name = IblTier::LAYOUT_NAMES[IblTier::get_layout()];
+    uint32_t resolution = IblTier::get_layout_resolution(IblTier::get()->cubemap_resolution);
+    GLenum internal_format = IblTier::get()->cubemap_format;
+    uint64_t source_hash = resource->second->get_hash();
+    uint64_t p_hash = Util::hash(&source_hash, sizeof(source_hash));
+    p_hash = Util::hash(name, strlen(name), p_hash);
+    p_hash = Util::hash(&resolution, sizeof(resolution), p_hash);
+    p_hash = Util::hash(&internal_format, sizeof(internal_format), p_hash);
+    p_hash = Util::hash(&CubemapConverter::VERSION, sizeof(CubemapConverter::VERSION), p_hash);
+    p_hash = Util::hash(&DominantLight::VERSION, sizeof(DominantLight::VERSION), p_hash);
+
+    return p_hash;
+}
+
+TextureManager::TextureResourceFromBundle::TextureResourceFromBundle(
+        const char *file_name, EnvironmentBundle::Entry entry, uint32_t texture_unit, TextureResource *fallback
+) :
+        TextureResource(static_cast<Semantic>(0), texture_unit, static_cast<WrapType>(0)),
+        file_name(file_name), entry(entry), fallback(fallback)
+{}
+
+int TextureManager::TextureResourceFromBundle::create_texture(TextureManager *manager, Texture *texture) const
+{
+    TextureData data{};
+    if (read(&data) == EXIT_SUCCESS) {
+        return Texture::create_tex_from_data(texture, &data, texture_unit, CLAMP);
+    }
+
+    nm_log::log(LOG_INFO, "generating entry %d of \"%s\" at run time\n", entry, file_name);
+
+    return fallback->create_texture(manager, texture);
+}
+
+int TextureManager::TextureResourceFromBundle::project_irradiance(SphericalHarmonics *irradiance) const
+{
+    TextureData data{};
+    if (EnvironmentBundle::read(file_name, EnvironmentBundle::IRRADIANCE, &data) == EXIT_SUCCESS &&
+        SphericalHarmonics::read_texture_data(irradiance, &data) == EXIT_SUCCESS) {
+        return EXIT_SUCCESS;
+    }
+
+    nm_log::log(LOG_INFO, "projecting irradiance of \"%s\" at run time\n", file_name);
+
+    return fallback->project_irradiance(irradiance);
+}
+
+int TextureManager::TextureResourceFromBundle::extract_dominant_light(DominantLight *light) const
+{
+    TextureData data{};
+    if (EnvironmentBundle::read(file_name, EnvironmentBundle::DOMINANT_LIGHT, &data) == EXIT_SUCCESS &&
+        DominantLight::read_texture_data(light, &data) == EXIT_SUCCESS) {
+        return EXIT_SUCCESS;
+    }
+
+    nm_log::log(LOG_INFO, "extracting dominant light of \"%s\" at run time\n", file_name);
+
+    return fallback->extract_dominant_light(light);
+}
+
+int TextureManager::TextureResourceFromBundle::generate(TextureData *data) const
+{
+    if (read(data) == EXIT_SUCCESS) {
+        return EXIT_SUCCESS;
+    }
+
+    return fallback->generate(data);
+}
+
+int TextureManager::TextureResourceFromBundle::read(TextureData *data) const
+{
+    if (EnvironmentBundle::read(file_name, entry, data) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    // the irradiance and dominant light do not depend on the tier, nor on the layout
+    const IblTier *tier = IblTier::get();
+    bool is_texture = entry == EnvironmentBundle::CUBEMAP || entry == EnvironmentBundle::PRE_FILTER;
+    if ((is_texture && data->texture_type != IblTier::get_texture_type()) ||
+        (entry == EnvironmentBundle::CUBEMAP &&
+         (data->width != IblTier::get_layout_resolution(tier->cubemap_resolution) ||
+          data->internal_format != tier->cubemap_format)) ||
+        (entry == EnvironmentBundle::PRE_FILTER &&
+         (data->width != IblTier::get_layout_resolution(tier->pre_filter_resolution) ||
+          data->internal_format != tier->pre_filter_format))) {
+        nm_log::log(LOG_INFO, "\"%s\" was baked for another IBL tier or layout than \"%s\" %s\n", file_name,
+                    tier->name, IblTier::LAYOUT_NAMES[IblTier::get_layout()]);
+        *data = TextureData{};
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+uint64_t TextureManager::TextureResourceFromBundle::compute_hash() const
+{
+    return fallback->get_hash();
+}
+
+TextureManager::TextureResourceFromChannels::TextureResourceFromChannels(
+        uint32_t texture_unit, WrapType wrap_type,
+        TextureResource *red, TextureResource *green
+) :
+        TextureResource(SCALAR, texture_unit, wrap_type), sources{red, green}
+{}
+
+int TextureManager::TextureResourceFromChannels::create_texture(TextureManager *, Texture *texture) const
+{
+    TextureData data{};
+    if (decode(&data) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    return Texture::upload_tex(texture, &data, texture_unit, wrap_type);
+}
+
+bool TextureManager::TextureResourceFromChannels::can_decode() const
+{
+    return true;
+}
+
+int TextureManager::TextureResourceFromChannels::decode(TextureData *data) const
+{
+    TextureData channels[2];
+    const TextureData *channel_pointers[2] = {};
+    for (uint32_t i = 0; i < 2; i++) {
+        if (!sources[i]) {
+            continue;
+        }
+        if (sources[i]->decode(&channels[i]) == EXIT_FAILURE) {
+            return EXIT_FAILURE;
+        }
+        channel_pointers[i] = &channels[i];
+    }
+
+    return TextureData::pack_channels(data, channel_pointers, 2);
+}
+
+void TextureManager::TextureResourceFromChannels::prefetch_file() const
+{
+    for (auto source : sources) {
+        if (source) {
+            source->prefetch_file();
+        }
+    }
+}
+
+uint64_t TextureManager::TextureResourceFromChannels::compute_hash() const
+{
+    uint64_t p_hash = hash_parameters(Util::HASH_SEED);
+    for (auto source : sources) {
+        uint64_t source_hash = source ? source->get_hash() : 0;
+        p_hash = Util::hash(&source_hash, sizeof(source_hash), p_hash);
+    }
+
+    return p_hash;
+}
+
+TextureManager::TextureResourceFromPrepared::TextureResourceFromPrepared(
+        const char *file_name, uint32_t texture_unit, WrapType wrap_type, TextureResource *fallback
+) :
+        TextureResource(fallback->semantic, texture_unit, wrap_type), file_name(file_name), fallback(fallback)
+{}
+
+int TextureManager::TextureResourceFromPrepared::create_texture(TextureManager *, Texture *texture) const
+{
+    TextureData data{};
+    if (decode(&data) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    return Texture::upload_tex(texture, &data, texture_unit, wrap_type);
+}
+
+bool TextureManager::TextureResourceFromPrepared::can_decode() const
+{
+    return true;
+}
+
+int TextureManager::TextureResourceFromPrepared::decode(TextureData *data) const
+{
+    const uint8_t *packed;
+    size_t packed_size;
+    bool read = pack.find(file_name, &packed, &packed_size) == EXIT_SUCCESS &&
+                TextureFile::read_from_memory(packed, packed_size, data) == EXIT_SUCCESS;
+
+    // only try the prepared texture if it exists, preparing is optional
+    if (!read) {
+        FILE *file = fopen(file_name, "rb");
+        if (file) {
+            fclose(file);
+            read = TextureFile::read(file_name, data) == EXIT_SUCCESS;
+        }
+    }
+
+    if (!read) {
+        nm_log::log(LOG_INFO, "prepared texture \"%s\" not found, decoding the image instead\n", file_name);
+
+        return fallback->decode(data);
+    }
+
+    // the block compressed formats of extensions may be missing, the image is uncompressed
+    if (!Texture::is_format_supported(data->internal_format)) {
+        nm_log::log(LOG_INFO, "format of prepared texture \"%s\" is not supported, decoding the image instead\n",
+                    file_name);
+        *data = TextureData{};
+
+        return fallback->decode(data);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+void TextureManager::TextureResourceFromPrepared::prefetch_file() const
+{
+    pack.prefetch(file_name);
+    fallback->prefetch_file();
+}
+
+uint64_t TextureManager::TextureResourceFromPrepared::compute_hash() const
+{
+    return fallback->get_hash();
+}
+
+TextureManager::TextureResourceFromTextureFile::TextureResourceFromTextureFile(
+        uint32_t texture_unit, WrapType wrap_type, const char *text, const size_t *len
+) :
+        TextureResource(static_cast<Semantic>(0), texture_unit, wrap_type), text(text), len(len)
+{}
+
+int TextureManager::TextureResourceFromTextureFile::create_texture(TextureManager *, Texture *texture) const
+{
+    TextureData data{};
+    if (TextureFile::read_from_memory((const uint8_t *) text, *len, &data) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    return Texture::create_tex_from_data(texture, &data, texture_unit, wrap_type);
+}
+
+uint64_t TextureManager::TextureResourceFromTextureFile::compute_hash() const
+{
+    return Util::hash(text, *len, hash_parameters(Util::HASH_SEED));
+}
+
+const char *const TextureManager::RESOURCE_PACK = "resources.pack";
+
+ResourcePack TextureManager::pack;
+
+const std::map<uint32_t, TextureManager::TextureResource *> TextureManager::TEXTURE_RESOURCES = {
+        {TEXTURE_TEST,
+                new TextureResourceFromMemory(DIFFUSE, 0, REPEAT, test_png, &test_png_len)},
+
+        {BRDF_LUT,
+                new TextureResourceFromTextureFile(8, CLAMP, brdf_lut_tex, &brdf_lut_tex_len)},
+
+        {TEXTURE_STUDIO_HDR,
+                new TextureResourceFromMemory(RADIANCE, 0, CLAMP, studio_hdr, &studio_hdr_len)},
+        {CUBEMAP_STUDIO,
+                new TextureResourceFromBundle(
+                        "../res/env/studio_small_03.env", EnvironmentBundle::CUBEMAP, 0,
+                        new TextureResourceFromEquirectangular(TEXTURE_STUDIO_HDR, 0))},
+        {CUBEMAP_STUDIO_PRE_FILTER,
+                new TextureResourceFromBundle(
+                        "../res/env/studio_small_03.env", EnvironmentBundle::PRE_FILTER, 7,
+                        new TextureResourceFromTextureResource(
+                                CUBEMAP_STUDIO, 7, &Texture::create_pre_filtered_cubemap_from_cubemap))},
+
+        {TEXTURE_MOONLESS_GOLF_HDR,
+                new TextureResourceFromMemory(RADIANCE, 0, CLAMP, moonless_golf_hdr, &moonless_golf_hdr_len)},
+        {CUBEMAP_MOONLESS_GOLF,
+                new TextureResourceFromBundle(
+                        "../res/env/moonless_golf.env", EnvironmentBundle::CUBEMAP, 0,
+                        new TextureResourceFromEquirectangular(TEXTURE_MOONLESS_GOLF_HDR, 0))},
+        {CUBEMAP_MOONLESS_GOLF_PRE_FILTER,
+                new TextureResourceFromBundle(
+                        "../res/env/moonless_golf.env", EnvironmentBundle::PRE_FILTER, 7,
+                        new TextureResourceFromTextureResource(
+                                CUBEMAP_MOONLESS_GOLF, 7, &Texture::create_pre_filtered_cubemap_from_cubemap))},
+
+        {TEXTURE_NOON_GRASS_HDR,
+                new TextureResourceFromMemory(RADIANCE, 0, CLAMP, noon_grass_hdr, &noon_grass_hdr_len)},
+        {CUBEMAP_NOON_GRASS,
+                new TextureResourceFromBundle(
+                        "../res/env/noon_grass.env", EnvironmentBundle::CUBEMAP, 0,
+                        new TextureResourceFromEquirectangular(TEXTURE_NOON_GRASS_HDR, 0))},
+        {CUBEMAP_NOON_GRASS_PRE_FILTER,
+                new TextureResourceFromBundle(
+                        "../res/env/noon_grass.env", EnvironmentBundle::PRE_FILTER, 7,
+                        new TextureResourceFromTextureResource(
+                                CUBEMAP_NOON_GRASS, 7, &Texture::create_pre_filtered_cubemap_from_cubemap))},
+
+        {TEXTURE_BRICK_1_DIFF,
+                new TextureResourceFromPrepared(
+                        "prepared/brick_diff.tex", 0, REPEAT,
+                        new TextureResourceFromMemory(DIFFUSE, 0, REPEAT, brick_diff_png, &brick_diff_png_len))},
+        {TEXTURE_BRICK_1_NORM,
+                new TextureResourceFromPrepared(
+                        "prepared/brick_norm.tex", 1, REPEAT,
+                        new TextureResourceFromMemory(NORMAL, 1, REPEAT, brick_norm_png, &brick_norm_png_len))},
+        {TEXTURE_BRICK_1_ROUGH_METAL,
+                new TextureResourceFromPrepared(
+                        "prepared/brick_rough_metal.tex", 2, REPEAT,
+                        new TextureResourceFromChannels(
+                                2, REPEAT,
+                                new TextureResourceFromMemory(SCALAR, 2, REPEAT, brick_rough_png, &brick_rough_png_len),
+                                nullptr))},
+        {TEXTURE_BRICK_1_AO_DISP,
+                new TextureResourceFromPrepared(
+                        "prepared/brick_ao_disp.tex", 3, REPEAT,
+                        new TextureResourceFromChannels(
+                                3, REPEAT,
+                                new TextureResourceFromMemory(SCALAR, 3, REPEAT, brick_ao_png, &brick_ao_png_len),
+                                new TextureResourceFromMemory(
+                                        SCALAR, 3, REPEAT, brick_disp_png, &brick_disp_png_len)))},
+
+        {TEXTURE_BRICK_2_DIFF,
+                new TextureResourceFromPrepared(
+                        "../res/tex/pbr/castle_brick_07/castle_brick_07_2k_png/castle_brick_07_diff_2k.tex", 0, REPEAT,
+                        new TextureResourceFromFile(DIFFUSE, 0, REPEAT,
+                                                    "../res/tex/pbr/castle_brick_07/castle_brick_07_2k_png/castle_brick_07_diff_2k.png"))},
+        {TEXTURE_BRICK_2_NORM,
+                new TextureResourceFromPrepared(
+                        "../res/tex/pbr/castle_brick_07/castle_brick_07_2k_png/castle_brick_07_nor_2k.tex", 1, REPEAT,
+                        new TextureResourceFromFile(NORMAL, 1, REPEAT,
+                                                    "../res/tex/pbr/castle_brick_07/castle_brick_07_2k_png/castle_brick_07_nor_2k.png"))},
+        {TEXTURE_BRICK_2_ROUGH_METAL,
+                new TextureResourceFromPrepared(
+                        "../res/tex/pbr/castle_brick_07/castle_brick_07_2k_png/castle_brick_07_rough_metal_2k.tex",
+                        2, REPEAT,
+                        new TextureResourceFromChannels(
+                                2, REPEAT,
+                                new TextureResourceFromFile(
+                                        SCALAR, 2, REPEAT,
+                                        "../res/tex/pbr/castle_brick_07/castle_brick_07_2k_png/castle_brick_07_rough_2k.png"),
+                                nullptr))},
+        {TEXTURE_BRICK_2_AO_DISP,
+                new TextureResourceFromPrepared(
+                        "../res/tex/pbr/castle_brick_07/castle_brick_07_2k_png/castle_brick_07_ao_disp_2k.tex",
+                        3, REPEAT,
+                        new TextureResourceFromChannels(
+                                3, REPEAT,
+                                new TextureResourceFromFile(
+                                        SCALAR, 3, REPEAT,
+                                        "../res/tex/pbr/castle_brick_07/castle_brick_07_2k_png/castle_brick_07_ao_2k.png"),
+                                new TextureResourceFromFile(
+                                        SCALAR, 3, REPEAT,
+                                        "../res/tex/pbr/castle_brick_07/castle_brick_07_2k_png/castle_brick_07_disp_2k.png")))},
+
+        {TEXTURE_BRICK_4_DIFF,
+                new TextureResourceFromPrepared(
+                        "../res/tex/pbr/castle_brick_07/castle_brick_07_4k_png/castle_brick_07_diff_4k.tex", 0, REPEAT,
+                        new TextureResourceFromFile(DIFFUSE, 0, REPEAT,
+                                                    "../res/tex/pbr/castle_brick_07/castle_brick_07_4k_png/castle_brick_07_diff_4k.png"))},
+        {TEXTURE_BRICK_4_NORM,
+                new TextureResourceFromPrepared(
+                        "../res/tex/pbr/castle_brick_07/castle_brick_07_4k_png/castle_brick_07_nor_4k.tex", 1, REPEAT,
+                        new TextureResourceFromFile(NORMAL, 1, REPEAT,
+                                                    "../res/tex/pbr/castle_brick_07/castle_brick_07_4k_png/castle_brick_07_nor_4k.png"))},
+        {TEXTURE_BRICK_4_ROUGH_METAL,
+                new TextureResourceFromPrepared(
+                        "../res/tex/pbr/castle_brick_07/castle_brick_07_4k_png/castle_brick_07_rough_metal_4k.tex",
+                        2, REPEAT,
+                        new TextureResourceFromChannels(
+                                2, REPEAT,
+                                new TextureResourceFromFile(
+                                        SCALAR, 2, REPEAT,
+                                        "../res/tex/pbr/castle_brick_07/castle_brick_07_4k_png/castle_brick_07_rough_4k.png"),
+                                nullptr))},
+        {TEXTURE_BRICK_4_AO_DISP,
+                new TextureResourceFromPrepared(
+                        "../res/tex/pbr/castle_brick_07/castle_brick_07_4k_png/castle_brick_07_ao_disp_4k.tex",
+                        3, REPEAT,
+                        new TextureResourceFromChannels(
+                                3, REPEAT,
+                                new TextureResourceFromFile(
+                                        SCALAR, 3, REPEAT,
+                                        "../res/tex/pbr/castle_brick_07/castle_brick_07_4k_png/castle_brick_07_ao_4k.png"),
+                                new TextureResourceFromFile(
+                                        SCALAR, 3, REPEAT,
+                                        "../res/tex/pbr/castle_brick_07/castle_brick_07_4k_png/castle_brick_07_disp_4k.png")))},
+
+        {TEXTURE_BRICK_8_DIFF,
+                new TextureResourceFromPrepared(
+                        "../res/tex/pbr/castle_brick_07/castle_brick_07_8k_png/castle_brick_07_diff_8k.tex", 0, REPEAT,
+                        new TextureResourceFromFile(DIFFUSE, 0, REPEAT,
+                                                    "../res/tex/pbr/castle_brick_07/castle_brick_07_8k_png/castle_brick_07_diff_8k.png"))},
+        {TEXTURE_BRICK_8_NORM,
+                new TextureResourceFromPrepared(
+                        "../res/tex/pbr/castle_brick_07/castle_brick_07_8k_png/castle_brick_07_nor_8k.tex", 1, REPEAT,
+                        new TextureResourceFromFile(NORMAL, 1, REPEAT,
+                                                    "../res/tex/pbr/castle_brick_07/castle_brick_07_8k_png/castle_brick_07_nor_8k.png"))},
+        {TEXTURE_BRICK_8_ROUGH_METAL,
+                new TextureResourceFromPrepared(
+                        "../res/tex/pbr/castle_brick_07/castle_brick_07_8k_png/castle_brick_07_rough_metal_8k.tex",
+                        2, REPEAT,
+                        new TextureResourceFromChannels(
+                                2, REPEAT,
+                                new TextureResourceFromFile(
+                                        SCALAR, 2, REPEAT,
+                                        "../res/tex/pbr/castle_brick_07/castle_brick_07_8k_png/castle_brick_07_rough_8k.png"),
+                                nullptr))},
+        {TEXTURE_BRICK_8_AO_DISP,
+                new TextureResourceFromPrepared(
+                        "../res/tex/pbr/castle_brick_07/castle_brick_07_8k_png/castle_brick_07_ao_disp_8k.tex",
+                        3, REPEAT,
+                        new TextureResourceFromChannels(
+                                3, REPEAT,
+                                new TextureResourceFromFile(
+                                        SCALAR, 3, REPEAT,
+                                        "../res/tex/pbr/castle_brick_07/castle_brick_07_8k_png/castle_brick_07_ao_8k.png"),
+                                new TextureResourceFromFile(
+                                        SCALAR, 3, REPEAT,
+                                        "../res/tex/pbr/castle_brick_07/castle_brick_07_8k_png/castle_brick_07_disp_8k.png")))},
+
+        {TEXTURE_METAL_1_DIFF,
+                new TextureResourceFromPrepared(
+                        "prepared/metal_diff.tex", 0, REPEAT,
+                        new TextureResourceFromMemory(DIFFUSE, 0, REPEAT, metal_diff_png, &metal_diff_png_len))},
+        {TEXTURE_METAL_1_NORM,
+                new TextureResourceFromPrepared(
+                        "prepared/metal_norm.tex", 1, REPEAT,
+                        new TextureResourceFromMemory(NORMAL, 1, REPEAT, metal_norm_png, &metal_norm_png_len))},
+        {TEXTURE_METAL_1_ROUGH_METAL,
+                new TextureResourceFromPrepared(
+                        "prepared/metal_rough_metal.tex", 2, REPEAT,
+                        new TextureResourceFromChannels(
+                                2, REPEAT,
+                                new TextureResourceFromMemory(SCALAR, 2, REPEAT, metal_rough_png, &metal_rough_png_len),
+                                new TextureResourceFromMemory(
+                                        SCALAR, 2, REPEAT, metal_spec_png, &metal_spec_png_len)))},
+        {TEXTURE_METAL_1_AO_DISP,
+                new TextureResourceFromPrepared(
+                        "prepared/metal_ao_disp.tex", 3, REPEAT,
+                        new TextureResourceFromChannels(
+                                3, REPEAT,
+                                new TextureResourceFromMemory(SCALAR, 3, REPEAT, metal_ao_png, &metal_ao_png_len),
+                                new TextureResourceFromMemory(
+                                        SCALAR, 3, REPEAT, metal_disp_png, &metal_disp_png_len)))},
+
+        {TEXTURE_MARBLE_1_DIFF,
+                new TextureResourceFromPrepared(
+                        "prepared/marble_diff.tex", 0, REPEAT,
+                        new TextureResourceFromMemory(DIFFUSE, 0, REPEAT, marble_diff_png, &marble_diff_png_len))},
+        {TEXTURE_MARBLE_1_NORM,
+                new TextureResourceFromPrepared(
+                        "prepared/marble_norm.tex", 1, REPEAT,
+                        new TextureResourceFromMemory(NORMAL, 1, REPEAT, marble_norm_png, &marble_norm_png_len))},
+        {TEXTURE_MARBLE_1_ROUGH_METAL,
+                new TextureResourceFromPrepared(
+                        "prepared/marble_rough_metal.tex", 2, REPEAT,
+                        new TextureResourceFromChannels(
+                                2, REPEAT,
+                                new TextureResourceFromMemory(
+                                        SCALAR, 2, REPEAT, marble_rough_png, &marble_rough_png_len),
+                                new TextureResourceFromMemory(
+                                        SCALAR, 2, REPEAT, marble_spec_png, &marble_spec_png_len)))},
+        {TEXTURE_MARBLE_1_AO_DISP,
+                new TextureResourceFromPrepared(
+                        "prepared/marble_ao_disp.tex", 3, REPEAT,
+                        new TextureResourceFromChannels(
+                                3, REPEAT,
+                                new TextureResourceFromMemory(SCALAR, 3, REPEAT, marble_ao_png, &marble_ao_png_len),
+                                new TextureResourceFromMemory(
+                                        SCALAR, 3, REPEAT, marble_disp_png, &marble_disp_png_len)))},
+
+        {TEXTURE_DENIM_1_DIFF,
+                new TextureResourceFromPrepared(
+                        "prepared/denim_diff.tex", 0, REPEAT,
+                        new TextureResourceFromMemory(DIFFUSE, 0, REPEAT, denim_diff_png, &denim_diff_png_len))},
+        {TEXTURE_DENIM_1_NORM,
+                new TextureResourceFromPrepared(
+                        "prepared/denim_norm.tex", 1, REPEAT,
+                        new TextureResourceFromMemory(NORMAL, 1, REPEAT, denim_norm_png, &denim_norm_png_len))},
+        {TEXTURE_DENIM_1_ROUGH_METAL,
+                new TextureResourceFromPrepared(
+                        "prepared/denim_rough_metal.tex", 2, REPEAT,
+                        new TextureResourceFromChannels(
+                                2, REPEAT,
+                                new TextureResourceFromMemory(SCALAR, 2, REPEAT, denim_rough_png, &denim_rough_png_len),
+                                nullptr))},
+        {TEXTURE_DENIM_1_AO_DISP,
+                new TextureResourceFromPrepared(
+                        "prepared/denim_ao_disp.tex", 3, REPEAT,
+                        new TextureResourceFromChannels(
+                                3, REPEAT,
+                                new TextureResourceFromMemory(SCALAR, 3, REPEAT, denim_ao_png, &denim_ao_png_len),
+                                new TextureResourceFromMemory(SCALAR, 3, REPEAT, denim_disp_png, &denim_disp_png_len)))}
+};
+
+const std::map<uint32_t, uint32_t> TextureManager::ENVIRONMENTS = {
+        {CUBEMAP_NOON_GRASS, CUBEMAP_NOON_GRASS_PRE_FILTER},
+        {CUBEMAP_STUDIO, CUBEMAP_STUDIO_PRE_FILTER},
+        {CUBEMAP_MOONLESS_GOLF, CUBEMAP_MOONLESS_GOLF_PRE_FILTER}};
+
+/** Returns the milliseconds passed since {start}. */
+static double get_elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** Guess of the upload speed (1 GB/s) until it is measured, and the size of uploads that it is measured from. */
+static const double INITIAL_UPLOAD_MS_PER_BYTE = 1e-6;
+static const size_t MEASURED_UPLOAD_SIZE = 256 * 1024;
+
+TextureManager::TextureManager() : decode_pool(0), upload_ms_per_byte(INITIAL_UPLOAD_MS_PER_BYTE)
+{
+    // the workers of {decode_pool} are idle until images are submitted to them, which happens after construction
+    Texture::initialize_decoding();
+    Texture::initialize_formats();
+
+    nm_log::log(LOG_INFO, "decoding textures on %d threads\n", decode_pool.get_thread_count());
+
+    // the pack is optional, without it all files are read separately
+    FILE *file = fopen(RESOURCE_PACK, "rb");
+    if (file) {
+        fclose(file);
+        ResourcePack::open(&pack, RESOURCE_PACK);
+    } else {
+        nm_log::log(LOG_INFO, "no resource pack \"%s\", reading files separately\n", RESOURCE_PACK);
+    }
+}
+
+void TextureManager::prefetch_files(const std::vector<uint32_t> &ids)
+{
+    for (uint32_t id : ids) {
+        auto entry = TEXTURE_RESOURCES.find(id);
+        if (entry == TEXTURE_RESOURCES.end() ||
+            std::find(prefetched_files.begin(), prefetched_files.end(), id) != prefetched_files.end()) {
+            continue;
+        }
+        entry->second->prefetch_file();
+        prefetched_files.push_back(id);
+    }
+}
+
+void TextureManager::prefetch(const std::vector<uint32_t> &ids)
+{
+    // streaming textures are not waited for, {get} starts decoding them
+    if (streaming) {
+        return;
+    }
+
+    // only decode images of textures that are not created yet, each only once
+    std::vector<uint32_t> decode_ids;
+    for (uint32_t id : ids) {
+        auto entry = TEXTURE_RESOURCES.find(id);
+        if (entry == TEXTURE_RESOURCES.end() || !entry->second->can_decode() ||
+            map.find(id) != map.end() || decoded.find(id) != decoded.end() ||
+            std::find(decode_ids.begin(), decode_ids.end(), id) != decode_ids.end()) {
+            continue;
+        }
+        decode_ids.push_back(id);
+    }
+
+    if (decode_ids.empty()) {
+        return;
+    }
+
+    // decode all images in parallel, every task only writes to its own slot
+    std::vector<TextureData> results(decode_ids.size());
+    std::vector<int> rvals(decode_ids.size());
+    std::vector<double> decode_times(decode_ids.size());
+    auto decode_start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < decode_ids.size(); i++) {
+        decode_pool.submit([&decode_ids, &results, &rvals, &decode_times, i] {
+            auto start = std::chrono::steady_clock::now();
+            rvals[i] = TEXTURE_RESOURCES.at(decode_ids[i])->decode(&results[i]);
+            decode_times[i] = get_elapsed_ms(start);
+        });
+    }
+    decode_pool.wait();
+    double decode_time = get_elapsed_ms(decode_start);
+
+    // log on this thread only, to not interleave messages
+    for (size_t i = 0; i < decode_ids.size(); i++) {
+        if (rvals[i] == EXIT_FAILURE) {
+            nm_log::log(LOG_ERROR, "failed to decode texture with id \"%d\"\n", decode_ids[i]);
+
+            continue;
+        }
+
+        nm_log::log(LOG_TRACE, "decoded texture with id \"%d\" in %.2f ms\n", decode_ids[i], decode_times[i]);
+        decoded[decode_ids[i]] = std::move(results[i]);
+    }
+    nm_log::log(LOG_INFO, "decoded %d textures in %.2f ms\n", (int) decode_ids.size(), decode_time);
+
+    // upload on the calling thread, which owns the context
+    auto upload_start = std::chrono::steady_clock::now();
+    for (uint32_t id : decode_ids) {
+        acquire(id, false);
+    }
+    nm_log::log(LOG_INFO, "uploaded %d textures in %.2f ms\n", (int) decode_ids.size(), get_elapsed_ms(upload_start));
+}
+
+/** Placeholder colors by texture unit, chosen to render as a plain, flat, rough, non-metallic surface. */
+static const uint8_t PLACEHOLDER_COLORS[][4] = {
+        {55, 55, 55, 255},    // diffuse, middle gray in linear space since placeholders are not sRGB
+        {128, 128, 255, 255}, // normal, pointing straight out of the surface
+        {255, 255, 0, 255}    // unoccluded, rough, non-metallic, and no parallax offset
+};
+
+void TextureManager::set_streaming(bool p_streaming, size_t p_upload_budget)
+{
+    streaming = p_streaming;
+    upload_budget = p_upload_budget;
+
+    nm_log::log(LOG_INFO, "texture streaming %s, uploading at most %d bytes per frame\n",
+                streaming ? "enabled" : "disabled", (int) upload_budget);
+}
+
+int TextureManager::get_irradiance(uint32_t id, SphericalHarmonics *irradiance)
+{
+    auto projected = irradiances.find(id);
+    if (projected != irradiances.end()) {
+        *irradiance = projected->second;
+
+        return EXIT_SUCCESS;
+    }
+
+    auto resource = TEXTURE_RESOURCES.find(id);
+    if (resource == TEXTURE_RESOURCES.end()) {
+        nm_log::log(LOG_ERROR, "\"%d\" is not a registered texture id\n", id);
+
+        return EXIT_FAILURE;
+    }
 
-// provide a default destructor for the base class
-template<>
-inline Manager<Texture>::~Manager<Texture>() = default;
+    auto start = std::chrono::steady_clock::now();
+    if (resource->second->project_irradiance(irradiance) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    irradiances.insert(std::make_pair(id, *irradiance));
 
-TextureManager::TextureResource::TextureResource(
-        uint32_t channels, uint32_t bit_depth, uint32_t texture_unit, ChannelType type, WrapType wrap_type
-) : channels(channels), bit_depth(bit_depth), texture_unit(texture_unit), type(type), wrap_type(wrap_type)
-{}
+    double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    nm_log::log(LOG_INFO, "obtained irradiance of texture \"%d\" in %.2f ms\n", id, time);
 
-TextureManager::TextureResourceFromMemory::TextureResourceFromMemory(
-        uint32_t channels, uint32_t bit_depth, uint32_t texture_unit, ChannelType type, WrapType wrap_type,
-        const char *text, const size_t *len
-) : TextureResource(channels, bit_depth, texture_unit, type, wrap_type), text(text), len(len)
-{}
+    return EXIT_SUCCESS;
+}
 
-int TextureManager::TextureResourceFromMemory::create_texture(Texture *texture) const
+int TextureManager::get_dominant_light(uint32_t id, DominantLight *light)
 {
-    return Texture::create_tex_from_mem(texture, text, *len, channels, bit_depth, texture_unit, type, wrap_type);
+    auto extracted = dominant_lights.find(id);
+    if (extracted != dominant_lights.end()) {
+        *light = extracted->second;
+
+        return EXIT_SUCCESS;
+    }
+
+    auto resource = TEXTURE_RESOURCES.find(id);
+    if (resource == TEXTURE_RESOURCES.end()) {
+        nm_log::log(LOG_ERROR, "\"%d\" is not a registered texture id\n", id);
+
+        return EXIT_FAILURE;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (resource->second->extract_dominant_light(light) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    dominant_lights.insert(std::make_pair(id, *light));
+
+    double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    nm_log::log(LOG_INFO, "obtained dominant light of texture \"%d\" in %.2f ms\n", id, time);
+
+    return EXIT_SUCCESS;
 }
 
-TextureManager::TextureResourceFromFile::TextureResourceFromFile(
-        uint32_t channels, uint32_t bit_depth, uint32_t texture_unit, ChannelType type, WrapType wrap_type,
-        const char *file_name
-) : TextureResource(channels, bit_depth, texture_unit, type, wrap_type), file_name(file_name)
-{}
+int TextureManager::create_streamed_texture(Texture *texture, uint32_t id, const TextureResource *resource)
+{
+    // create the placeholder for this texture unit if it does not exist yet
+    auto placeholder = placeholders.find(resource->texture_unit);
+    if (placeholder == placeholders.end()) {
+        auto *placeholder_texture = new Texture();
+        const uint32_t PLACEHOLDER_COUNT = sizeof(PLACEHOLDER_COLORS) / sizeof(PLACEHOLDER_COLORS[0]);
+        const uint8_t *color = PLACEHOLDER_COLORS[resource->texture_unit < PLACEHOLDER_COUNT ?
+                                                  resource->texture_unit : 0];
+        Texture::create_placeholder_tex(placeholder_texture, color, resource->texture_unit);
+        placeholder = placeholders.insert(std::make_pair(resource->texture_unit, placeholder_texture)).first;
+    }
+    *texture = *placeholder->second;
+
+    uint64_t ticket = next_ticket++;
+    streams[id] = Stream{ticket, false, TextureData{}, nullptr, 0, 0, 0, 0.};
+
+    decode_pool.submit([this, id, ticket, resource] {
+        DecodeResult result{id, ticket, EXIT_FAILURE, TextureData{}, 0.};
+        auto start = std::chrono::steady_clock::now();
+        result.rval = resource->decode(&result.data);
+        result.decode_time = get_elapsed_ms(start);
+
+        std::unique_lock<std::mutex> lock(decode_results_mutex);
+        decode_results.push_back(std::move(result));
+    });
 
-int TextureManager::TextureResourceFromFile::create_texture(Texture *texture) const
+    return EXIT_SUCCESS;
+}
+
+void TextureManager::cancel_stream(Texture *texture, uint32_t id)
 {
-    return Texture::create_tex_from_file(texture, file_name, channels, bit_depth, texture_unit, type, wrap_type);
+    auto stream = streams.find(id);
+    if (stream == streams.end()) {
+        return;
+    }
+
+    if (stream->second.staging) {
+        Texture::delete_tex(stream->second.staging);
+        delete stream->second.staging;
+    }
+    streams.erase(stream);
+    upload_queue.erase(std::remove(upload_queue.begin(), upload_queue.end(), id), upload_queue.end());
+
+    // the handle still refers to the shared placeholder, which deleting texture name 0 leaves alone
+    texture->tex_id = 0;
+
+    nm_log::log(LOG_INFO, "cancelled streaming texture with id \"%d\"\n", id);
 }
 
-TextureManager::TextureResourceFromTextureResource::TextureResourceFromTextureResource(
-        TextureType texture_type, uint32_t texture_unit, int (*create_function)(Texture *, Texture *, uint32_t)
-) :
-        TextureResource(0, 0, texture_unit, static_cast<ChannelType>(0), static_cast<WrapType>(0)),
-        texture_type(texture_type), create_function(create_function)
-{}
+void TextureManager::update_streaming()
+{
+    // collect the images decoded since the last call
+    std::vector<DecodeResult> results;
+    {
+        std::unique_lock<std::mutex> lock(decode_results_mutex);
+        results.swap(decode_results);
+    }
+
+    for (auto &result : results) {
+        // the texture may have been deleted while decoding
+        auto stream = streams.find(result.id);
+        if (stream == streams.end() || stream->second.ticket != result.ticket) {
+            continue;
+        }
 
-int TextureManager::TextureResourceFromTextureResource::create_texture(Texture *texture) const
+        if (result.rval == EXIT_FAILURE) {
+            // keep showing the placeholder, the stream is kept such that the placeholder is not deleted with the handle
+            nm_log::log(LOG_ERROR, "failed to decode streaming texture with id \"%d\"\n", result.id);
+
+            continue;
+        }
+
+        stream->second.decoded = true;
+        stream->second.data = std::move(result.data);
+        stream->second.decode_time = result.decode_time;
+        upload_queue.push_back(result.id);
+    }
+
+    // upload until the budget for this frame is spent or the ring is still in use by the GPU
+    size_t budget = upload_budget;
+    while (!upload_queue.empty() && budget > 0) {
+        size_t uploaded = upload_stream_rows(budget);
+        if (uploaded == 0) {
+            break;
+        }
+        budget -= uploaded < budget ? uploaded : budget;
+    }
+}
+
+size_t TextureManager::upload_stream_rows(size_t budget)
 {
-    // create resource texture without registering in the texture manager instance
-    Texture resource_texture{};
-    auto resource = TEXTURE_RESOURCES.find(texture_type);
-    if (resource == TEXTURE_RESOURCES.end()) {
-        nm_log::log(LOG_ERROR, "texture type cannot be found in defined texture resources\n");
+    uint32_t id = upload_queue.front();
+    Stream &stream = streams.at(id);
+    const TextureResource *resource = TEXTURE_RESOURCES.at(id);
+
+    if (!stream.staging) {
+        stream.staging = new Texture();
+        Texture::allocate_tex(stream.staging, &stream.data, resource->texture_unit, resource->wrap_type);
     }
-    resource->second->create_texture(&resource_texture);
 
-    // create the desired texture using obtained texture
-    int rval = create_function(texture, &resource_texture, texture_unit);
+    // make sure at least a single row of the largest level fits in a buffer
+    size_t buffer_size = stream.data.get_row_size(0);
+    if (buffer_size < upload_budget) {
+        buffer_size = upload_budget;
+    }
+    if (!has_upload_ring || upload_ring.buffer_size < buffer_size) {
+        if (has_upload_ring) {
+            PixelBufferRing::delete_ring(&upload_ring);
+        }
+        PixelBufferRing::create_ring(&upload_ring, buffer_size);
+        has_upload_ring = true;
+    }
 
-    // manually delete resource texture since it has not been registered in texture manager instance
-    Texture::delete_tex(&resource_texture);
+    // upload at least one row per frame, even if it exceeds the budget
+    bool first_upload_of_frame = budget == upload_budget;
+    size_t capacity = budget < upload_ring.buffer_size ? budget : upload_ring.buffer_size;
+    size_t row_size = stream.data.get_row_size(stream.uploaded_level);
+    if (row_size > capacity) {
+        if (!first_upload_of_frame) {
+            return 0;
+        }
+        capacity = row_size;
+    }
 
-    return rval;
+    uint8_t *pixels = PixelBufferRing::map_next(&upload_ring);
+    if (!pixels) {
+        return 0;
+    }
+
+    // fill the buffer with as many rows as fit, continuing with the next levels for small levels
+    struct RowUpload {
+        uint32_t level;
+        uint32_t first_row;
+        uint32_t row_count;
+        size_t offset;
+    };
+    std::vector<RowUpload> row_uploads;
+    size_t offset = 0;
+    while (stream.uploaded_level < stream.data.level_count) {
+        uint32_t level = stream.uploaded_level;
+        uint32_t level_row_count = stream.data.get_row_count(level);
+        row_size = stream.data.get_row_size(level);
+
+        uint32_t row_count = (capacity - offset) / row_size;
+        if (row_count == 0) {
+            break;
+        }
+        if (row_count > level_row_count - stream.uploaded_row_count) {
+            row_count = level_row_count - stream.uploaded_row_count;
+        }
+
+        memcpy(pixels + offset, stream.data.get_pixels(level, 0) + stream.uploaded_row_count * row_size,
+               row_count * row_size);
+        row_uploads.push_back(RowUpload{level, stream.uploaded_row_count, row_count, offset});
+        offset += row_count * row_size;
+
+        stream.uploaded_row_count += row_count;
+        if (stream.uploaded_row_count == level_row_count) {
+            stream.uploaded_level++;
+            stream.uploaded_row_count = 0;
+        }
+    }
+
+    PixelBufferRing::unmap(&upload_ring);
+    // the pixels are sourced from the bound buffer, the pointer is an offset into it
+    for (auto &row_upload : row_uploads) {
+        Texture::upload_tex_rows(
+                stream.staging, &stream.data, row_upload.level, row_upload.first_row, row_upload.row_count,
+                (const void *) row_upload.offset);
+    }
+    PixelBufferRing::fence(&upload_ring);
+
+    // count the frames rows were uploaded in, the first upload of a frame gets the full budget
+    if (stream.upload_frame_count == 0 || first_upload_of_frame) {
+        stream.upload_frame_count++;
+    }
+
+    if (stream.uploaded_level == stream.data.level_count) {
+        Texture::generate_mipmap_tex(stream.staging, &stream.data);
+
+        // swap the uploaded texture into the handle, which showed the placeholder until now
+        *map.at(id).item = *stream.staging;
+        nm_log::log(LOG_INFO, "streamed texture with id \"%d\", decoded in %.2f ms, uploaded over %d frames\n",
+                    id, stream.decode_time, stream.upload_frame_count);
+
+        delete stream.staging;
+        streams.erase(id);
+        upload_queue.pop_front();
+    }
+
+    return offset;
 }
 
-const std::map<uint32_t, TextureManager::TextureResource *> TextureManager::TEXTURE_RESOURCES = {
-        {TEXTURE_TEST,
-                new TextureResourceFromMemory(4, 8, 0, INTEGER, REPEAT, test_png, &test_png_len)},
+const double TextureManager::DEFAULT_ENVIRONMENT_BUDGET = 2.;
 
-        {BRDF_LUT,
-                new TextureResourceFromTextureResource( // NB: TextureType parameter is NOT used!
-                        TEXTURE_TEST, 8, &Texture::create_tex_from_tex)},
+void TextureManager::prepare_environment(uint32_t cubemap_id, uint32_t pre_filter_id)
+{
+    cancel_environment();
 
-        {TEXTURE_STUDIO_HDR,
-                new TextureResourceFromMemory(
-                        3, 32, 0, FLOATING_POINT, CLAMP, studio_hdr, &studio_hdr_len)},
-        {CUBEMAP_STUDIO,
-                new TextureResourceFromTextureResource(
-                        TEXTURE_STUDIO_HDR, 0, &Texture::create_cubemap_from_tex)},
-        {CUBEMAP_STUDIO_IRRADIANCE,
-                new TextureResourceFromTextureResource(
-                        CUBEMAP_STUDIO, 6, &Texture::create_irradiance_cubemap_from_cubemap)},
-        {CUBEMAP_STUDIO_PRE_FILTER,
-                new TextureResourceFromTextureResource(
-                        CUBEMAP_STUDIO, 7, &Texture::create_pre_filtered_cubemap_from_cubemap)},
+    environment = new Environment();
+    environment->cubemap_id = cubemap_id;
+    environment->pre_filter_id = pre_filter_id;
+    environment->ticket = next_ticket++;
+    environment->cubemap_rval = EXIT_FAILURE;
+    environment->pre_filter_rval = EXIT_FAILURE;
+    environment->irradiance_rval = EXIT_FAILURE;
+    environment->dominant_light_rval = EXIT_FAILURE;
+    environment->start = std::chrono::steady_clock::now();
 
-        {TEXTURE_MOONLESS_GOLF_HDR,
-                new TextureResourceFromMemory(
-                        3, 32, 0, FLOATING_POINT, CLAMP, moonless_golf_hdr, &moonless_golf_hdr_len)},
-        {CUBEMAP_MOONLESS_GOLF,
-                new TextureResourceFromTextureResource(
-                        TEXTURE_MOONLESS_GOLF_HDR, 0, &Texture::create_cubemap_from_tex)},
-        {CUBEMAP_MOONLESS_GOLF_IRRADIANCE,
-                new TextureResourceFromTextureResource(
-                        CUBEMAP_MOONLESS_GOLF, 6, &Texture::create_irradiance_cubemap_from_cubemap)},
-        {CUBEMAP_MOONLESS_GOLF_PRE_FILTER,
-                new TextureResourceFromTextureResource(
-                        CUBEMAP_MOONLESS_GOLF, 7, &Texture::create_pre_filtered_cubemap_from_cubemap)},
+    // an environment that is fully created is ready right away, for example when switching back before it is deleted
+    if (is_environment_created(cubemap_id, pre_filter_id)) {
+        environment->step = Environment::READY;
 
-        {TEXTURE_NOON_GRASS_HDR,
-                new TextureResourceFromMemory(
-                        3, 32, 0, FLOATING_POINT, CLAMP, noon_grass_hdr, &noon_grass_hdr_len)},
-        {CUBEMAP_NOON_GRASS,
-                new TextureResourceFromTextureResource(
-                        TEXTURE_NOON_GRASS_HDR, 0, &Texture::create_cubemap_from_tex)},
-        {CUBEMAP_NOON_GRASS_IRRADIANCE,
-                new TextureResourceFromTextureResource(
-                        CUBEMAP_NOON_GRASS, 6, &Texture::create_irradiance_cubemap_from_cubemap)},
-        {CUBEMAP_NOON_GRASS_PRE_FILTER,
-                new TextureResourceFromTextureResource(
-                        CUBEMAP_NOON_GRASS, 7, &Texture::create_pre_filtered_cubemap_from_cubemap)},
+        return;
+    }
 
-        {TEXTURE_BRICK_1_DIFF,
-                new TextureResourceFromMemory(4, 16, 0, INTEGER, REPEAT, brick_diff_png, &brick_diff_png_len)},
-        {TEXTURE_BRICK_1_NORM,
-                new TextureResourceFromMemory(4, 16, 1, INTEGER, REPEAT, brick_norm_png, &brick_norm_png_len)},
-        {TEXTURE_BRICK_1_AO,
-                new TextureResourceFromMemory(2, 16, 2, INTEGER, REPEAT, brick_ao_png, &brick_ao_png_len)},
-        {TEXTURE_BRICK_1_ROUGH,
-                new TextureResourceFromMemory(2, 16, 3, INTEGER, REPEAT, brick_rough_png, &brick_rough_png_len)},
-        {TEXTURE_BRICK_1_DISP,
-                new TextureResourceFromMemory(2, 16, 4, INTEGER, REPEAT, brick_disp_png, &brick_disp_png_len)},
+    auto cubemap = TEXTURE_RESOURCES.find(cubemap_id);
+    auto pre_filter = TEXTURE_RESOURCES.find(pre_filter_id);
+    if (cubemap == TEXTURE_RESOURCES.end() || pre_filter == TEXTURE_RESOURCES.end()) {
+        // let creating the textures report it
+        nm_log::log(LOG_ERROR, "\"%d\" or \"%d\" is not a registered texture id\n", cubemap_id, pre_filter_id);
+        environment->step = Environment::READY;
 
-        {TEXTURE_BRICK_2_DIFF,
-                new TextureResourceFromFile(4, 16, 0, INTEGER, REPEAT,
-                                            "../res/tex/pbr/castle_brick_07/castle_brick_07_2k_png/castle_brick_07_diff_2k.png")},
-        {TEXTURE_BRICK_2_NORM,
-                new TextureResourceFromFile(4, 16, 1, INTEGER, REPEAT,
-                                            "../res/tex/pbr/castle_brick_07/castle_brick_07_2k_png/castle_brick_07_nor_2k.png")},
-        {TEXTURE_BRICK_2_AO,
-                new TextureResourceFromFile(4, 16, 2, INTEGER,
-                                            REPEAT, // NB: intentional difference with {TEXTURE_BRICK_AO}
-                                            "../res/tex/pbr/castle_brick_07/castle_brick_07_2k_png/castle_brick_07_ao_2k.png")},
-        {TEXTURE_BRICK_2_ROUGH,
-                new TextureResourceFromFile(2, 16, 3, INTEGER, REPEAT,
-                                            "../res/tex/pbr/castle_brick_07/castle_brick_07_2k_png/castle_brick_07_rough_2k.png")},
-        {TEXTURE_BRICK_2_DISP,
-                new TextureResourceFromFile(2, 16, 4, INTEGER, REPEAT,
-                                            "../res/tex/pbr/castle_brick_07/castle_brick_07_2k_png/castle_brick_07_disp_2k.png")},
+        return;
+    }
 
-        {TEXTURE_BRICK_4_DIFF,
-                new TextureResourceFromFile(4, 16, 0, INTEGER, REPEAT,
-                                            "../res/tex/pbr/castle_brick_07/castle_brick_07_4k_png/castle_brick_07_diff_4k.png")},
-        {TEXTURE_BRICK_4_NORM,
-                new TextureResourceFromFile(4, 16, 1, INTEGER, REPEAT,
-                                            "../res/tex/pbr/castle_brick_07/castle_brick_07_4k_png/castle_brick_07_nor_4k.png")},
-        {TEXTURE_BRICK_4_AO,
-                new TextureResourceFromFile(4, 16, 2, INTEGER,
-                                            REPEAT, // NB: intentional difference with {TEXTURE_BRICK_AO}
-                                            "../res/tex/pbr/castle_brick_07/castle_brick_07_4k_png/castle_brick_07_ao_4k.png")},
-        {TEXTURE_BRICK_4_ROUGH,
-                new TextureResourceFromFile(2, 16, 3, INTEGER, REPEAT,
-                                            "../res/tex/pbr/castle_brick_07/castle_brick_07_4k_png/castle_brick_07_rough_4k.png")},
-        {TEXTURE_BRICK_4_DISP,
-                new TextureResourceFromFile(2, 16, 4, INTEGER, REPEAT,
-                                            "../res/tex/pbr/castle_brick_07/castle_brick_07_4k_png/castle_brick_07_disp_4k.png")},
+    // built by the loader thread already, waiting for it is cheaper than building it twice
+    if (std::find(preloading.begin(), preloading.end(), cubemap_id) != preloading.end()) {
+        environment->step = Environment::PRELOADING;
 
-        {TEXTURE_BRICK_8_DIFF,
-                new TextureResourceFromFile(4, 16, 0, INTEGER, REPEAT,
-                                            "../res/tex/pbr/castle_brick_07/castle_brick_07_8k_png/castle_brick_07_diff_8k.png")},
-        {TEXTURE_BRICK_8_NORM,
-                new TextureResourceFromFile(4, 16, 1, INTEGER, REPEAT,
-                                            "../res/tex/pbr/castle_brick_07/castle_brick_07_8k_png/castle_brick_07_nor_8k.png")},
-        {TEXTURE_BRICK_8_AO,
-                new TextureResourceFromFile(4, 16, 2, INTEGER,
-                                            REPEAT, // NB: intentional difference with {TEXTURE_BRICK_AO}
-                                            "../res/tex/pbr/castle_brick_07/castle_brick_07_8k_png/castle_brick_07_ao_8k.png")},
-        {TEXTURE_BRICK_8_ROUGH,
-                new TextureResourceFromFile(2, 16, 3, INTEGER, REPEAT,
-                                            "../res/tex/pbr/castle_brick_07/castle_brick_07_8k_png/castle_brick_07_rough_8k.png")},
-        {TEXTURE_BRICK_8_DISP,
-                new TextureResourceFromFile(2, 16, 4, INTEGER, REPEAT,
-                                            "../res/tex/pbr/castle_brick_07/castle_brick_07_8k_png/castle_brick_07_disp_8k.png")},
+        return;
+    }
 
-        {TEXTURE_METAL_1_DIFF,
-                new TextureResourceFromMemory(4, 16, 0, INTEGER, REPEAT, metal_diff_png, &metal_diff_png_len)},
-        {TEXTURE_METAL_1_NORM,
-                new TextureResourceFromMemory(4, 16, 1, INTEGER, REPEAT, metal_norm_png, &metal_norm_png_len)},
-        {TEXTURE_METAL_1_AO,
-                new TextureResourceFromMemory(2, 16, 2, INTEGER, REPEAT, metal_ao_png, &metal_ao_png_len)},
-        {TEXTURE_METAL_1_ROUGH,
-                new TextureResourceFromMemory(2, 16, 3, INTEGER, REPEAT, metal_rough_png, &metal_rough_png_len)},
-        {TEXTURE_METAL_1_DISP,
-                new TextureResourceFromMemory(2, 16, 4, INTEGER, REPEAT, metal_disp_png, &metal_disp_png_len)},
-        {TEXTURE_METAL_1_SPEC,
-                new TextureResourceFromMemory(2, 16, 5, INTEGER, REPEAT, metal_spec_png, &metal_spec_png_len)},
+    generate_environment();
+}
 
-        {TEXTURE_MARBLE_1_DIFF,
-                new TextureResourceFromMemory(4, 16, 0, INTEGER, REPEAT, marble_diff_png, &marble_diff_png_len)},
-        {TEXTURE_MARBLE_1_NORM,
-                new TextureResourceFromMemory(4, 16, 1, INTEGER, REPEAT, marble_norm_png, &marble_norm_png_len)},
-        {TEXTURE_MARBLE_1_AO,
-                new TextureResourceFromMemory(2, 16, 2, INTEGER, REPEAT, marble_ao_png, &marble_ao_png_len)},
-        {TEXTURE_MARBLE_1_ROUGH,
-                new TextureResourceFromMemory(2, 16, 3, INTEGER, REPEAT, marble_rough_png, &marble_rough_png_len)},
-        {TEXTURE_MARBLE_1_DISP,
-                new TextureResourceFromMemory(2, 16, 4, INTEGER, REPEAT, marble_disp_png, &marble_disp_png_len)},
-        {TEXTURE_MARBLE_1_SPEC,
-                new TextureResourceFromMemory(2, 16, 5, INTEGER, REPEAT, marble_spec_png, &marble_spec_png_len)},
+bool TextureManager::is_environment_created(uint32_t cubemap_id, uint32_t pre_filter_id) const
+{
+    return map.find(cubemap_id) != map.end() && map.find(pre_filter_id) != map.end() &&
+           irradiances.find(cubemap_id) != irradiances.end() &&
+           dominant_lights.find(cubemap_id) != dominant_lights.end();
+}
 
-        {TEXTURE_DENIM_1_DIFF,
-                new TextureResourceFromMemory(4, 16, 0, INTEGER, REPEAT, denim_diff_png, &denim_diff_png_len)},
-        {TEXTURE_DENIM_1_NORM,
-                new TextureResourceFromMemory(4, 16, 1, INTEGER, REPEAT, denim_norm_png, &denim_norm_png_len)},
-        {TEXTURE_DENIM_1_AO,
-                new TextureResourceFromMemory(2, 16, 2, INTEGER, REPEAT, denim_ao_png, &denim_ao_png_len)},
-        {TEXTURE_DENIM_1_ROUGH,
-                new TextureResourceFromMemory(2, 16, 3, INTEGER, REPEAT, denim_rough_png, &denim_rough_png_len)},
-        {TEXTURE_DENIM_1_DISP,
-                new TextureResourceFromMemory(2, 16, 4, INTEGER, REPEAT, denim_disp_png, &denim_disp_png_len)}
-};
+void TextureManager::generate_environment()
+{
+    bool has_irradiance = irradiances.find(environment->cubemap_id) != irradiances.end();
+    bool has_dominant_light = dominant_lights.find(environment->cubemap_id) != dominant_lights.end();
+
+    environment->step = Environment::GENERATING;
+    uint64_t ticket = environment->ticket;
+    const TextureResource *cubemap_resource = TEXTURE_RESOURCES.at(environment->cubemap_id);
+    const TextureResource *pre_filter_resource = TEXTURE_RESOURCES.at(environment->pre_filter_id);
+    decode_pool.submit([this, ticket, cubemap_resource, pre_filter_resource, has_irradiance, has_dominant_light] {
+        EnvironmentResult result{
+                ticket, EXIT_FAILURE, TextureData{}, EXIT_FAILURE, TextureData{}, EXIT_FAILURE, SphericalHarmonics{},
+                EXIT_FAILURE, DominantLight{}};
+        // the cubemap first, such that projecting the irradiance and extracting the dominant light find them in the
+        // cache if it was converted
+        result.cubemap_rval = cubemap_resource->generate(&result.cubemap_data);
+        if (!has_irradiance) {
+            result.irradiance_rval = cubemap_resource->project_irradiance(&result.irradiance);
+        }
+        if (!has_dominant_light) {
+            result.dominant_light_rval = cubemap_resource->extract_dominant_light(&result.dominant_light);
+        }
+        // fails if the pre-filter cubemap is neither baked nor cached, it is rendered instead
+        result.pre_filter_rval = pre_filter_resource->generate(&result.pre_filter_data);
+
+        std::unique_lock<std::mutex> lock(decode_results_mutex);
+        environment_results.push_back(std::move(result));
+    });
+}
+
+bool TextureManager::update_environment(double budget_ms)
+{
+    // read the timings of rendered levels that are available without waiting, queries complete in order
+    while (!pre_filter_queries.empty()) {
+        GLint available;
+        glGetQueryObjectiv(pre_filter_queries.front().first, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            break;
+        }
+        GLuint64 time;
+        glGetQueryObjectui64v(pre_filter_queries.front().first, GL_QUERY_RESULT, &time);
+        pre_filter_level_ms[pre_filter_queries.front().second] = (double) time * 1e-6;
+        glDeleteQueries(1, &pre_filter_queries.front().first);
+        pre_filter_queries.pop_front();
+    }
+
+    if (!environment) {
+        return true;
+    }
+
+    if (environment->step == Environment::PRELOADING) {
+        if (std::find(preloading.begin(), preloading.end(), environment->cubemap_id) != preloading.end()) {
+            environment->frame_count++;
+
+            return false;
+        }
+
+        // delivered by {update_preloading}, unless the loader thread failed to build it
+        if (is_environment_created(environment->cubemap_id, environment->pre_filter_id)) {
+            environment->step = Environment::READY;
+        } else {
+            generate_environment();
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    // collect the results of the worker
+    std::vector<EnvironmentResult> results;
+    {
+        std::unique_lock<std::mutex> lock(decode_results_mutex);
+        results.swap(environment_results);
+    }
+    for (auto &result : results) {
+        // the environment may have been replaced while generating
+        if (result.ticket != environment->ticket) {
+            continue;
+        }
+
+        if (result.cubemap_rval == EXIT_FAILURE) {
+            // switch anyway, creating the textures reports the failure
+            nm_log::log(LOG_ERROR, "failed to prepare cubemap with id \"%d\"\n", environment->cubemap_id);
+            cancel_environment();
+
+            return true;
+        }
+
+        environment->cubemap_rval = result.cubemap_rval;
+        environment->cubemap_data = std::move(result.cubemap_data);
+        environment->pre_filter_rval = result.pre_filter_rval;
+        environment->pre_filter_data = std::move(result.pre_filter_data);
+        environment->irradiance_rval = result.irradiance_rval;
+        environment->irradiance = result.irradiance;
+        environment->dominant_light_rval = result.dominant_light_rval;
+        environment->dominant_light = result.dominant_light;
+        environment->step = Environment::UPLOADING_CUBEMAP;
+    }
+
+    // perform at least one step, then only those that are estimated to fit in what remains of the budget
+    double gpu_ms = 0.;
+    bool first = true;
+    while (environment->step != Environment::READY) {
+        double estimate = estimate_environment_step(budget_ms);
+        if (!first && get_elapsed_ms(start) + gpu_ms + estimate > budget_ms) {
+            break;
+        }
+
+        // rendered levels are not part of the elapsed time, since they run on the GPU
+        bool rendering = environment->step == Environment::PRE_FILTERING &&
+                         environment->pre_filter_rval == EXIT_FAILURE;
+        if (!step_environment()) {
+            break;
+        }
+        if (rendering) {
+            gpu_ms += estimate;
+        }
+        first = false;
+    }
+    environment->frame_count++;
+
+    if (environment->step != Environment::READY) {
+        return false;
+    }
+
+    finish_environment();
+
+    return true;
+}
+
+double TextureManager::estimate_environment_step(double budget_ms) const
+{
+    const TextureData *data;
+    switch (environment->step) {
+        case Environment::UPLOADING_CUBEMAP:
+            data = &environment->cubemap_data;
+            break;
+        case Environment::PRE_FILTERING:
+            if (environment->pre_filter_rval == EXIT_SUCCESS) {
+                data = &environment->pre_filter_data;
+                break;
+            } else {
+                uint32_t level = Texture::PRE_FILTER_LEVEL_COUNT - 1 - environment->next_part;
+                auto level_ms = pre_filter_level_ms.find(level);
+
+                return level_ms == pre_filter_level_ms.end() ? budget_ms : level_ms->second;
+            }
+        case Environment::READING_BACK:
+            // reading back and caching is performed alone
+            return budget_ms;
+        default:
+            return 0.;
+    }
+
+    uint32_t level = data->level_count - 1 - environment->next_part / data->face_count;
+
+    return (double) data->get_level_size(level) * upload_ms_per_byte;
+}
+
+bool TextureManager::upload_environment_face(Texture *texture, const TextureData *data)
+{
+    uint32_t level = data->level_count - 1 - environment->next_part / data->face_count;
+    uint32_t face = environment->next_part % data->face_count;
+
+    auto start = std::chrono::steady_clock::now();
+    Texture::upload_tex_face(texture, data, level, face);
+
+    // small uploads are dominated by overhead, they would overestimate the time per byte
+    size_t size = data->get_level_size(level);
+    if (size >= MEASURED_UPLOAD_SIZE) {
+        upload_ms_per_byte = .5 * (upload_ms_per_byte + get_elapsed_ms(start) / (double) size);
+    }
+
+    environment->next_part++;
+
+    return environment->next_part == data->level_count * data->face_count;
+}
+
+bool TextureManager::step_environment()
+{
+    const uint32_t PRE_FILTER_LEVEL_COUNT = Texture::PRE_FILTER_LEVEL_COUNT;
+
+    switch (environment->step) {
+        case Environment::UPLOADING_CUBEMAP: {
+            if (!environment->cubemap) {
+                environment->cubemap = new Texture();
+                Texture::allocate_tex_from_data(
+                        environment->cubemap, &environment->cubemap_data,
+                        TEXTURE_RESOURCES.at(environment->cubemap_id)->texture_unit, CLAMP);
+            }
+            if (upload_environment_face(environment->cubemap, &environment->cubemap_data)) {
+                environment->cubemap_data = TextureData{};
+                environment->next_part = 0;
+                environment->step = Environment::PRE_FILTERING;
+            }
+
+            return true;
+        }
+        case Environment::PRE_FILTERING: {
+            uint32_t texture_unit = TEXTURE_RESOURCES.at(environment->pre_filter_id)->texture_unit;
+            if (environment->pre_filter_rval == EXIT_SUCCESS) {
+                // baked or cached, only uploaded
+                if (!environment->pre_filter) {
+                    environment->pre_filter = new Texture();
+                    Texture::allocate_tex_from_data(
+                            environment->pre_filter, &environment->pre_filter_data, texture_unit, CLAMP);
+                }
+                if (upload_environment_face(environment->pre_filter, &environment->pre_filter_data)) {
+                    environment->pre_filter_data = TextureData{};
+                    environment->step = Environment::READY;
+                }
+
+                return true;
+            }
+
+            // rendered from the uploaded cubemap, coarse levels first
+            if (!environment->pre_filter_pass) {
+                environment->pre_filter = new Texture();
+                environment->pre_filter_pass = new PreFilterPass();
+                Texture::begin_pre_filter(
+                        environment->pre_filter_pass, environment->pre_filter, environment->cubemap, texture_unit);
+            }
+            uint32_t level = PRE_FILTER_LEVEL_COUNT - 1 - environment->next_part;
+
+            GLuint query;
+            glGenQueries(1, &query);
+            glBeginQuery(GL_TIME_ELAPSED, query);
+            Texture::render_pre_filter_level(environment->pre_filter_pass, level);
+            glEndQuery(GL_TIME_ELAPSED);
+            pre_filter_queries.emplace_back(query, level);
+
+            environment->next_part++;
+            if (environment->next_part == PRE_FILTER_LEVEL_COUNT) {
+                Texture::end_pre_filter(environment->pre_filter_pass);
+                delete environment->pre_filter_pass;
+                environment->pre_filter_pass = nullptr;
+                environment->pre_filter_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                environment->step = Environment::READING_BACK;
+            }
+
+            return true;
+        }
+        case Environment::READING_BACK: {
+            // reading back before the GPU is done would wait for it
+            GLenum status = glClientWaitSync(environment->pre_filter_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            if (status == GL_TIMEOUT_EXPIRED) {
+                return false;
+            }
+            glDeleteSync(environment->pre_filter_fence);
+            environment->pre_filter_fence = nullptr;
+
+            // cache it like {TextureResourceFromTextureResource} does, the bundle or cache is used next time
+            TextureData data{};
+            if (Texture::read_tex(environment->pre_filter, &data, PRE_FILTER_LEVEL_COUNT) == EXIT_SUCCESS) {
+                TextureCache::store(TEXTURE_RESOURCES.at(environment->pre_filter_id)->get_hash(), &data);
+            }
+            environment->step = Environment::READY;
+
+            return true;
+        }
+        default:
+            // waiting for the worker
+            return false;
+    }
+}
+
+void TextureManager::finish_environment()
+{
+    if (environment->irradiance_rval == EXIT_SUCCESS) {
+        irradiances[environment->cubemap_id] = environment->irradiance;
+    }
+    if (environment->dominant_light_rval == EXIT_SUCCESS) {
+        dominant_lights[environment->cubemap_id] = environment->dominant_light;
+    }
+
+    if (environment->cubemap) {
+        replace_item(environment->cubemap_id, environment->cubemap);
+        environment->cubemap = nullptr;
+    }
+    if (environment->pre_filter) {
+        replace_item(environment->pre_filter_id, environment->pre_filter);
+        environment->pre_filter = nullptr;
+    }
+
+    nm_log::log(LOG_INFO, "prepared environment with cubemap \"%d\" over %d frames in %.2f ms\n",
+                environment->cubemap_id, environment->frame_count, get_elapsed_ms(environment->start));
+
+    cancel_environment();
+}
+
+void TextureManager::replace_item(uint32_t id, Texture *texture)
+{
+    auto item = map.find(id);
+    if (item == map.end()) {
+        insert(id, texture, true);
+
+        return;
+    }
+
+    cancel_stream(item->second.item, id);
+    Texture::delete_tex(item->second.item);
+    *item->second.item = *texture;
+    item->second.used = true;
+    delete texture;
+}
+
+void TextureManager::cancel_environment()
+{
+    if (!environment) {
+        return;
+    }
+
+    if (environment->step != Environment::READY) {
+        nm_log::log(LOG_INFO, "cancelled preparing environment with cubemap \"%d\"\n", environment->cubemap_id);
+    }
+
+    if (environment->pre_filter_pass) {
+        Texture::end_pre_filter(environment->pre_filter_pass);
+        delete environment->pre_filter_pass;
+    }
+    if (environment->pre_filter_fence) {
+        glDeleteSync(environment->pre_filter_fence);
+    }
+    for (Texture *texture : {environment->cubemap, environment->pre_filter}) {
+        if (texture) {
+            Texture::delete_tex(texture);
+            delete texture;
+        }
+    }
+
+    delete environment;
+    environment = nullptr;
+}
+
+void TextureManager::start_preloading(const std::function<void(bool)> &set_context_current, uint32_t bound_cubemap_id)
+{
+    if (preload_thread.joinable()) {
+        return;
+    }
+
+    for (auto &environment : ENVIRONMENTS) {
+        // environments created already are made resident as they are, instead of being built again
+        if (is_environment_created(environment.first, environment.second)) {
+            make_resident(environment.first);
+            make_resident(environment.second);
+            continue;
+        }
+        if (environment.first == bound_cubemap_id) {
+            preload_skipped.push_back(environment.first);
+            continue;
+        }
+        preloading.push_back(environment.first);
+    }
+
+    const IblTier *tier = IblTier::get();
+    size_t size = (tier->get_cubemap_size() + tier->get_pre_filter_size()) * ENVIRONMENTS.size();
+    nm_log::log(LOG_INFO, "preloading %d environments, %.2f MiB resident at IBL tier \"%s\"\n",
+                (int) ENVIRONMENTS.size(), (double) size / (1024. * 1024.), tier->name);
+
+    std::vector<uint32_t> ids = preloading;
+    preload_stopping = false;
+    preload_thread = std::thread([this, set_context_current, ids] {
+        set_context_current(true);
+        preload(ids);
+        set_context_current(false);
+    });
+}
+
+void TextureManager::preload(const std::vector<uint32_t> &cubemap_ids)
+{
+    // state is per context, the pre-filter pass samples across cubemap faces
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t count = 0;
+    for (uint32_t cubemap_id : cubemap_ids) {
+        if (preload_stopping) {
+            break;
+        }
+
+        uint32_t pre_filter_id = ENVIRONMENTS.at(cubemap_id);
+        const TextureResource *cubemap_resource = TEXTURE_RESOURCES.at(cubemap_id);
+        const TextureResource *pre_filter_resource = TEXTURE_RESOURCES.at(pre_filter_id);
+        PreloadResult result{
+                cubemap_id, pre_filter_id, new Texture(), new Texture(), EXIT_FAILURE, SphericalHarmonics{},
+                EXIT_FAILURE, DominantLight{}, nullptr};
+
+        // the cubemap first, such that projecting the irradiance and extracting the dominant light find them in the
+        // cache if it was converted
+        TextureData data{};
+        int rval = cubemap_resource->generate(&data);
+        if (rval == EXIT_SUCCESS) {
+            rval = Texture::create_tex_from_data(result.cubemap, &data, cubemap_resource->texture_unit, CLAMP);
+        }
+        data = TextureData{};
+        result.irradiance_rval = cubemap_resource->project_irradiance(&result.irradiance);
+        result.dominant_light_rval = cubemap_resource->extract_dominant_light(&result.dominant_light);
+
+        // rendered and cached like {TextureResourceFromTextureResource} does if it is neither baked nor cached
+        if (rval == EXIT_SUCCESS && pre_filter_resource->generate(&data) == EXIT_SUCCESS) {
+            rval = Texture::create_tex_from_data(result.pre_filter, &data, pre_filter_resource->texture_unit, CLAMP);
+        } else if (rval == EXIT_SUCCESS) {
+            rval = Texture::create_pre_filtered_cubemap_from_cubemap(
+                    result.pre_filter, result.cubemap, pre_filter_resource->texture_unit);
+            if (rval == EXIT_SUCCESS &&
+                Texture::read_tex(result.pre_filter, &data, Texture::PRE_FILTER_LEVEL_COUNT) == EXIT_SUCCESS) {
+                TextureCache::store(pre_filter_resource->get_hash(), &data);
+            }
+        }
+
+        if (rval == EXIT_SUCCESS) {
+            // flushed, such that the render thread waiting on it does not wait forever
+            result.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            glFlush();
+            count++;
+        } else {
+            nm_log::log(LOG_ERROR, "failed to preload environment with cubemap \"%d\"\n", cubemap_id);
+            Texture::delete_tex(result.cubemap);
+            Texture::delete_tex(result.pre_filter);
+            delete result.cubemap;
+            delete result.pre_filter;
+            result.cubemap = nullptr;
+            result.pre_filter = nullptr;
+        }
+
+        std::unique_lock<std::mutex> lock(decode_results_mutex);
+        preload_results.push_back(result);
+    }
+
+    nm_log::log(LOG_INFO, "preloaded %d environments in %.2f ms\n", count, get_elapsed_ms(start));
+}
+
+void TextureManager::update_preloading()
+{
+    {
+        std::unique_lock<std::mutex> lock(decode_results_mutex);
+        preload_pending.insert(preload_pending.end(), preload_results.begin(), preload_results.end());
+        preload_results.clear();
+    }
+
+    for (auto it = preload_pending.begin(); it != preload_pending.end() /* not hoisted */; /* no increment */) {
+        if (it->fence) {
+            // the loader context flushed the fence, polling it does not have to
+            GLenum status = glClientWaitSync(it->fence, 0, 0);
+            if (status == GL_TIMEOUT_EXPIRED) {
+                ++it;
+                continue;
+            }
+            glDeleteSync(it->fence);
+        }
+
+        // the render thread may have created the environment while it was being built, which is kept since its
+        // textures may be bound already
+        bool created = map.find(it->cubemap_id) != map.end() && map.find(it->pre_filter_id) != map.end();
+        if (it->cubemap && created) {
+            for (Texture *texture : {it->cubemap, it->pre_filter}) {
+                Texture::delete_tex(texture);
+                delete texture;
+            }
+        } else if (it->cubemap) {
+            replace_item(it->cubemap_id, it->cubemap);
+            replace_item(it->pre_filter_id, it->pre_filter);
+        }
+        if (it->cubemap || created) {
+            make_resident(it->cubemap_id);
+            make_resident(it->pre_filter_id);
+        }
+        if (it->irradiance_rval == EXIT_SUCCESS) {
+            irradiances[it->cubemap_id] = it->irradiance;
+        }
+        if (it->dominant_light_rval == EXIT_SUCCESS) {
+            dominant_lights[it->cubemap_id] = it->dominant_light;
+        }
+        preloading.erase(std::find(preloading.begin(), preloading.end(), it->cubemap_id));
+
+        it = preload_pending.erase(it);
+    }
+
+    for (auto it = preload_skipped.begin(); it != preload_skipped.end() /* not hoisted */; /* no increment */) {
+        uint32_t pre_filter_id = ENVIRONMENTS.at(*it);
+        if (map.find(*it) == map.end() || map.find(pre_filter_id) == map.end()) {
+            ++it;
+            continue;
+        }
+        make_resident(*it);
+        make_resident(pre_filter_id);
+        it = preload_skipped.erase(it);
+    }
+}
+
+void TextureManager::stop_preloading()
+{
+    if (!preload_thread.joinable()) {
+        return;
+    }
+
+    preload_stopping = true;
+    preload_thread.join();
+
+    // textures are shared, they are deleted from this context
+    preload_pending.insert(preload_pending.end(), preload_results.begin(), preload_results.end());
+    preload_results.clear();
+    for (auto &result : preload_pending) {
+        if (result.fence) {
+            glDeleteSync(result.fence);
+        }
+        for (Texture *texture : {result.cubemap, result.pre_filter}) {
+            if (texture) {
+                Texture::delete_tex(texture);
+                delete texture;
+            }
+        }
+    }
+    preload_pending.clear();
+    preloading.clear();
+    preload_skipped.clear();
+}
+
+Texture *TextureManager::get_intermediate(uint32_t id)
+{
+    return acquire(id, false);
+}
+
+int TextureManager::create_decoded_texture(Texture *texture, uint32_t id, const TextureResource *resource)
+{
+    TextureData data{};
+    auto prefetched = decoded.find(id);
+    if (prefetched != decoded.end()) {
+        data = std::move(prefetched->second);
+        decoded.erase(prefetched);
+    } else {
+        auto decode_start = std::chrono::steady_clock::now();
+        if (resource->decode(&data) == EXIT_FAILURE) {
+            return EXIT_FAILURE;
+        }
+        nm_log::log(LOG_TRACE, "decoded texture with id \"%d\" in %.2f ms\n", id, get_elapsed_ms(decode_start));
+    }
+
+    auto upload_start = std::chrono::steady_clock::now();
+    int rval = Texture::upload_tex(texture, &data, resource->texture_unit, resource->wrap_type);
+    nm_log::log(LOG_TRACE, "uploaded texture with id \"%d\" in %.2f ms\n", id, get_elapsed_ms(upload_start));
+
+    return rval;
+}
 
 int32_t TextureManager::create_item(Texture **item, uint32_t id)
 {
@@ -217,9 +1849,26 @@ int32_t TextureManager::create_item(Texture **item, uint32_t id)
         return EXIT_FAILURE;
     }
 
-    // else, create from function pointer
+    // a texture that is (indirectly) derived from itself can never be created
+    if (std::find(creating.begin(), creating.end(), id) != creating.end()) {
+        nm_log::log(LOG_ERROR, "texture with id \"%d\" depends on itself\n", id);
+
+        return EXIT_FAILURE;
+    }
+
+    // else, create from function pointer, creating the textures it depends on through this manager
     *item = new Texture();
-    int32_t rval = entry->second->create_texture(*item);
+    int32_t rval;
+    if (entry->second->can_decode() && streaming && creating.empty()) {
+        // only stream textures that are requested directly, those derived from need the actual image
+        rval = create_streamed_texture(*item, id, entry->second);
+    } else if (entry->second->can_decode()) {
+        rval = create_decoded_texture(*item, id, entry->second);
+    } else {
+        creating.push_back(id);
+        rval = entry->second->create_texture(this, *item);
+        creating.pop_back();
+    }
     if (rval == EXIT_FAILURE) {
         nm_log::log(LOG_ERROR, "failed to create texture\n");
 
@@ -235,6 +1884,7 @@ int32_t TextureManager::create_item(Texture **item, uint32_t id)
 
 void TextureManager::delete_item(Texture **item, uint32_t id)
 {
+    cancel_stream(*item, id);
     delete_item_self(item, id);
 }
 
@@ -248,7 +1898,29 @@ void TextureManager::delete_item_self(Texture **item, uint32_t id)
 
 TextureManager::~TextureManager()
 {
+    stop_preloading();
+
+    // workers may still write decoded images of streaming textures
+    decode_pool.wait();
+
+    cancel_environment();
+    for (auto &query : pre_filter_queries) {
+        glDeleteQueries(1, &query.first);
+    }
+
     for (auto &item : map) {
+        cancel_stream(item.second.item, item.first);
         delete_item_self(&item.second.item, item.first);
     }
+
+    for (auto &placeholder : placeholders) {
+        Texture::delete_tex(placeholder.second);
+        delete placeholder.second;
+    }
+
+    if (has_upload_ring) {
+        PixelBufferRing::delete_ring(&upload_ring);
+    }
+
+    ResourcePack::close(&pack);
 }
\ No newline at end of file
@@ -1,9 +1,24 @@
 #ifndef SYSTEM_TEXTURE_MANAGER_HPP
 #define SYSTEM_TEXTURE_MANAGER_HPP
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "manager.hpp"
+#include "resource_pack.hpp"
+#include "../opengl/dominant_light.hpp"
+#include "../opengl/environment_bundle.hpp"
+#include "../opengl/pixel_buffer_ring.hpp"
+#include "../opengl/spherical_harmonics.hpp"
+#include "../opengl/texture_data.hpp"
+#include "../../util/thread_pool.hpp"
 
 enum TextureType {
     TEXTURE_TEST,
@@ -12,86 +27,119 @@ enum TextureType {
 
     TEXTURE_STUDIO_HDR,
     CUBEMAP_STUDIO,
-    CUBEMAP_STUDIO_IRRADIANCE,
     CUBEMAP_STUDIO_PRE_FILTER,
 
     TEXTURE_MOONLESS_GOLF_HDR,
     CUBEMAP_MOONLESS_GOLF,
-    CUBEMAP_MOONLESS_GOLF_IRRADIANCE,
     CUBEMAP_MOONLESS_GOLF_PRE_FILTER,
 
     TEXTURE_NOON_GRASS_HDR,
     CUBEMAP_NOON_GRASS,
-    CUBEMAP_NOON_GRASS_IRRADIANCE,
     CUBEMAP_NOON_GRASS_PRE_FILTER,
 
     TEXTURE_BRICK_1_DIFF,
     TEXTURE_BRICK_1_NORM,
-    TEXTURE_BRICK_1_AO,
-    TEXTURE_BRICK_1_ROUGH,
-    TEXTURE_BRICK_1_DISP,
+    TEXTURE_BRICK_1_ROUGH_METAL,
+    TEXTURE_BRICK_1_AO_DISP,
 
     TEXTURE_BRICK_2_DIFF,
     TEXTURE_BRICK_2_NORM,
-    TEXTURE_BRICK_2_AO,
-    TEXTURE_BRICK_2_ROUGH,
-    TEXTURE_BRICK_2_DISP,
+    TEXTURE_BRICK_2_ROUGH_METAL,
+    TEXTURE_BRICK_2_AO_DISP,
 
     TEXTURE_BRICK_4_DIFF,
     TEXTURE_BRICK_4_NORM,
-    TEXTURE_BRICK_4_AO,
-    TEXTURE_BRICK_4_ROUGH,
-    TEXTURE_BRICK_4_DISP,
+    TEXTURE_BRICK_4_ROUGH_METAL,
+    TEXTURE_BRICK_4_AO_DISP,
 
     TEXTURE_BRICK_8_DIFF,
     TEXTURE_BRICK_8_NORM,
-    TEXTURE_BRICK_8_AO,
-    TEXTURE_BRICK_8_ROUGH,
-    TEXTURE_BRICK_8_DISP,
+    TEXTURE_BRICK_8_ROUGH_METAL,
+    TEXTURE_BRICK_8_AO_DISP,
 
     TEXTURE_METAL_1_DIFF,
     TEXTURE_METAL_1_NORM,
-    TEXTURE_METAL_1_AO,
-    TEXTURE_METAL_1_ROUGH,
-    TEXTURE_METAL_1_DISP,
-    TEXTURE_METAL_1_SPEC,
+    TEXTURE_METAL_1_ROUGH_METAL,
+    TEXTURE_METAL_1_AO_DISP,
 
     TEXTURE_MARBLE_1_DIFF,
     TEXTURE_MARBLE_1_NORM,
-    TEXTURE_MARBLE_1_AO,
-    TEXTURE_MARBLE_1_ROUGH,
-    TEXTURE_MARBLE_1_DISP,
-    TEXTURE_MARBLE_1_SPEC,
+    TEXTURE_MARBLE_1_ROUGH_METAL,
+    TEXTURE_MARBLE_1_AO_DISP,
 
     TEXTURE_DENIM_1_DIFF,
     TEXTURE_DENIM_1_NORM,
-    TEXTURE_DENIM_1_AO,
-    TEXTURE_DENIM_1_ROUGH,
-    TEXTURE_DENIM_1_DISP
+    TEXTURE_DENIM_1_ROUGH_METAL,
+    TEXTURE_DENIM_1_AO_DISP
 };
 
 class Texture;
 
+struct PreFilterPass;
+
 class TextureManager : public Manager<Texture> {
 public:
-    enum ChannelType {
-        INTEGER, FLOATING_POINT
+    /** What an image holds, which determines the channels it is decoded to and the format it is stored in. */
+    enum Semantic {
+        /** sRGB encoded color with alpha, stored as {GL_SRGB8_ALPHA8} such that sampling decodes it for free. */
+        DIFFUSE,
+        /** Tangent space normal of which only X and Y are kept as {GL_RG8}, Z is rebuilt when sampled. */
+        NORMAL,
+        /** Single linear value such as roughness, stored as {GL_R8} or as {GL_R16} if the image has 16 bits. */
+        SCALAR,
+        /** High dynamic range color, stored as {GL_RGB16F}. */
+        RADIANCE
     };
     enum WrapType {
         CLAMP, REPEAT
     };
 private:
     struct TextureResource {
-        uint32_t channels;     // number of channels in the image (for example 3 if RGB)
-        uint32_t bit_depth;    // number of bits per channel (8 bits is common)
+        Semantic semantic;     // what the image holds
         uint32_t texture_unit; // to which opengl texture unit it maps
-        ChannelType type;      // what the type of the channel data is
         WrapType wrap_type;    // texture parameter
 
-        TextureResource(
-                uint32_t channels, uint32_t bit_depth, uint32_t texture_unit, ChannelType type, WrapType wrap_type);
+        TextureResource(Semantic semantic, uint32_t texture_unit, WrapType wrap_type);
+
+        /** {manager} is used to obtain textures this texture is derived from. */
+        virtual int create_texture(TextureManager *manager, Texture *texture) const = 0;
+
+        /** Whether {decode} is supported, which is the case for textures that are decoded from an image. */
+        virtual bool can_decode() const;
+
+        /**
+         * Decodes the image into {data} without touching OpenGL state, such that it can run on a worker thread.
+         * The texture is created from it using {Texture::upload_tex}. */
+        virtual int decode(TextureData *data) const;
+
+        /** Starts reading the files the texture is created from into memory in the background, if they are packed. */
+        virtual void prefetch_file() const;
+
+        /** Projects the irradiance of the environment cubemap this resource creates, see {get_irradiance}. */
+        virtual int project_irradiance(SphericalHarmonics *irradiance) const;
+
+        /** Extracts the dominant light of the environment cubemap this resource creates, see {get_dominant_light}. */
+        virtual int extract_dominant_light(DominantLight *light) const;
+
+        /**
+         * Creates the pixels of a texture that is not decoded from an image without touching OpenGL state, such that
+         * it can run on a worker thread. Fails for textures that can only be rendered, see {prepare_environment}. */
+        virtual int generate(TextureData *data) const;
 
-        virtual int create_texture(Texture *texture) const = 0;
+        /**
+         * Returns a hash of everything the created texture depends on, used as key in the {TextureCache}.
+         * Computed once since it may require hashing the full source data, by whichever thread asks first. */
+        uint64_t get_hash() const;
+
+    protected:
+        virtual uint64_t compute_hash() const = 0;
+
+        /** Hashes the parameters of this base. */
+        uint64_t hash_parameters(uint64_t hash) const;
+
+    private:
+        mutable uint64_t hash = 0;
+        mutable std::once_flag hashed;
     };
 
     struct TextureResourceFromMemory : public TextureResource {
@@ -100,10 +148,16 @@ private:
         const size_t *len;
 
         TextureResourceFromMemory(
-                uint32_t channels, uint32_t bit_depth, uint32_t texture_unit, ChannelType type, WrapType wrap_type,
-                const char *text, const size_t *len);
+                Semantic semantic, uint32_t texture_unit, WrapType wrap_type, const char *text, const size_t *len);
+
+        int create_texture(TextureManager *manager, Texture *texture) const override;
 
-        int create_texture(Texture *texture) const override;
+        bool can_decode() const override;
+
+        int decode(TextureData *data) const override;
+
+    protected:
+        uint64_t compute_hash() const override;
     };
 
     struct TextureResourceFromFile : public TextureResource {
@@ -111,10 +165,19 @@ private:
         const char *file_name;
 
         TextureResourceFromFile(
-                uint32_t channels, uint32_t bit_depth, uint32_t texture_unit, ChannelType type, WrapType wrap_type,
-                const char *file_name);
+                Semantic semantic, uint32_t texture_unit, WrapType wrap_type, const char *file_name);
+
+        int create_texture(TextureManager *manager, Texture *texture) const override;
 
-        int create_texture(Texture *texture) const override;
+        bool can_decode() const override;
+
+        /** Decodes the image straight from the {pack} if it holds it, otherwise reads the file. */
+        int decode(TextureData *data) const override;
+
+        void prefetch_file() const override;
+
+    protected:
+        uint64_t compute_hash() const override;
     };
 
     struct TextureResourceFromTextureResource : public TextureResource {
@@ -127,12 +190,373 @@ private:
                 TextureType texture_type, uint32_t texture_unit,
                 int (*create_function)(Texture *, Texture *, uint32_t));
 
-        int create_texture(Texture *texture) const override;
+        /**
+         * Loads the texture from the {TextureCache} if present, otherwise generates and stores it.
+         * The resource texture is obtained through {manager}, such that it is shared with other textures derived from
+         * it. */
+        int create_texture(TextureManager *manager, Texture *texture) const override;
+
+        /** Only loads the texture from the {TextureCache}, generating it requires rendering. */
+        int generate(TextureData *data) const override;
+
+    protected:
+        uint64_t compute_hash() const override;
+    };
+
+    struct TextureResourceFromEquirectangular : public TextureResource {
+        /** Equirectangular environment image, of which the image is decoded without creating its texture. */
+        TextureType texture_type;
+
+        TextureResourceFromEquirectangular(TextureType texture_type, uint32_t texture_unit);
+
+        int create_texture(TextureManager *manager, Texture *texture) const override;
+
+        /** Cached like the cubemap, projecting it requires the cubemap but not its texture. */
+        int project_irradiance(SphericalHarmonics *irradiance) const override;
+
+        /** Cached like the irradiance, extracting it requires decoding the image but not converting it. */
+        int extract_dominant_light(DominantLight *light) const override;
+
+        int generate(TextureData *data) const override;
+
+    protected:
+        uint64_t compute_hash() const override;
+
+    private:
+        /**
+         * Loads the cubemap from the {TextureCache} if present, otherwise converts the decoded image on the CPU using
+         * {CubemapConverter}, after removing its dominant light, and stores it. */
+        int convert(TextureData *data) const;
+
+        /** Decodes the image into {equirectangular} and extracts {light} from it, which is stored in the cache. */
+        int decode_without_light(TextureData *equirectangular, DominantLight *light) const;
+
+        /** Key of the dominant light in the {TextureCache}. */
+        uint64_t get_dominant_light_key() const;
+    };
+
+    struct TextureResourceFromBundle : public TextureResource {
+        /** File name of the bundle written by {pbr_bake}. */
+        const char *file_name;
+        EnvironmentBundle::Entry entry;
+        /** Used to generate the texture when the bundle is missing or outdated. */
+        TextureResource *fallback;
+
+        TextureResourceFromBundle(
+                const char *file_name, EnvironmentBundle::Entry entry, uint32_t texture_unit,
+                TextureResource *fallback);
+
+        int create_texture(TextureManager *manager, Texture *texture) const override;
+
+        /** Reads the {IRRADIANCE} entry of the bundle, which is the same for all entries of an environment. */
+        int project_irradiance(SphericalHarmonics *irradiance) const override;
+
+        /** Reads the {DOMINANT_LIGHT} entry of the bundle, like {project_irradiance}. */
+        int extract_dominant_light(DominantLight *light) const override;
+
+        int generate(TextureData *data) const override;
+
+        /** Reads {entry} from the bundle, failing if it was baked for another {IblTier} than the selected one. */
+        int read(TextureData *data) const;
+
+    protected:
+        /** A bundle entry is a baked copy of what {fallback} creates. */
+        uint64_t compute_hash() const override;
+    };
+
+    struct TextureResourceFromChannels : public TextureResource {
+        /**
+         * Each channel of the two channel texture is the first channel of the image of a source, or zero if it is
+         * null. Two channels are compressed without their values affecting each other, see {BlockCompression::BC5}. */
+        TextureResource *sources[2];
+
+        TextureResourceFromChannels(
+                uint32_t texture_unit, WrapType wrap_type, TextureResource *red, TextureResource *green);
+
+        int create_texture(TextureManager *manager, Texture *texture) const override;
+
+        bool can_decode() const override;
+
+        /** Decodes all sources and packs them into a single image, the sources must have equal dimensions. */
+        int decode(TextureData *data) const override;
+
+        void prefetch_file() const override;
+
+    protected:
+        uint64_t compute_hash() const override;
+    };
+
+    struct TextureResourceFromPrepared : public TextureResource {
+        /** File name of the texture written by {pbr_texture}, holding the full mip chain. */
+        const char *file_name;
+        /** Used to decode the image when the prepared texture is missing or outdated. */
+        TextureResource *fallback;
+
+        TextureResourceFromPrepared(
+                const char *file_name, uint32_t texture_unit, WrapType wrap_type, TextureResource *fallback);
+
+        int create_texture(TextureManager *manager, Texture *texture) const override;
+
+        bool can_decode() const override;
+
+        int decode(TextureData *data) const override;
+
+        void prefetch_file() const override;
+
+    protected:
+        /** A prepared texture is a copy of the image of {fallback} with its mip chain. */
+        uint64_t compute_hash() const override;
+    };
+
+    struct TextureResourceFromTextureFile : public TextureResource {
+        /** Pointers to an extern embedded texture file, generated during the build like {brdf_lut_tex}. */
+        const char *text;
+        const size_t *len;
+
+        TextureResourceFromTextureFile(uint32_t texture_unit, WrapType wrap_type, const char *text, const size_t *len);
+
+        /** Uploads the texture as-is, including the levels the file holds. */
+        int create_texture(TextureManager *manager, Texture *texture) const override;
+
+    protected:
+        uint64_t compute_hash() const override;
     };
 
     /** Array to obtain the desired data using an id. */
     static const std::map<uint32_t, TextureResource *> TEXTURE_RESOURCES;
 
+    /** Pre-filter cubemap of every environment, indexed by the id of its cubemap. */
+    static const std::map<uint32_t, uint32_t> ENVIRONMENTS;
+
+    /** Resource files are read from this pack if it holds them, opened for the lifetime of the manager. */
+    static ResourcePack pack;
+
+    /** Irradiance of environment cubemaps, kept once projected since it is only a few floats. */
+    std::map<uint32_t, SphericalHarmonics> irradiances;
+
+    /** Dominant light of environment cubemaps, kept like {irradiances}. */
+    std::map<uint32_t, DominantLight> dominant_lights;
+
+    /** Textures of which the files were prefetched by {prefetch_files}. */
+    std::vector<uint32_t> prefetched_files;
+
+    /** Decodes images in parallel for {prefetch}, one worker per hardware thread. */
+    ThreadPool decode_pool;
+
+    /** Images decoded by {prefetch}, waiting to be uploaded when their texture is created. */
+    std::map<uint32_t, TextureData> decoded;
+
+    /** Whether textures are streamed in, see {set_streaming}. */
+    bool streaming = false;
+
+    /** Maximum number of bytes uploaded by {update_streaming} per call. */
+    size_t upload_budget = DEFAULT_UPLOAD_BUDGET;
+
+    /** A texture that is streaming in, its handle shows a placeholder in the meantime. */
+    struct Stream {
+        /** Identifies this stream, such that a decoded image of a deleted and recreated texture is not used. */
+        uint64_t ticket;
+        /** Set once decoding finished, after which {data} holds the image. */
+        bool decoded;
+        TextureData data;
+        /** Texture being uploaded, nullptr until the upload started. */
+        Texture *staging;
+        /** Level of {data} being uploaded, and the number of its rows uploaded so far. */
+        uint32_t uploaded_level;
+        uint32_t uploaded_row_count;
+        /** Number of calls to {update_streaming} spent uploading. */
+        uint32_t upload_frame_count;
+        double decode_time;
+    };
+
+    /** Textures that are streaming in, indexed by id. */
+    std::map<uint32_t, Stream> streams;
+
+    /** Ids of decoded streams, in the order they are uploaded. */
+    std::deque<uint32_t> upload_queue;
+
+    uint64_t next_ticket = 0;
+
+    /** Image decoded on a worker thread, handed to {update_streaming}. */
+    struct DecodeResult {
+        uint32_t id;
+        uint64_t ticket;
+        int rval;
+        TextureData data;
+        double decode_time;
+    };
+
+    /** Guards {decode_results}, which is written by the workers of {decode_pool}. */
+    std::mutex decode_results_mutex;
+    std::vector<DecodeResult> decode_results;
+
+    /** Placeholders shown by streaming textures, one per texture unit since the unit determines the texture's role. */
+    std::map<uint32_t, Texture *> placeholders;
+
+    /** Created on the first upload, grown if a single row does not fit. */
+    PixelBufferRing upload_ring{};
+    bool has_upload_ring = false;
+
+    /** An environment that is prepared over multiple frames, see {prepare_environment}. */
+    struct Environment {
+        enum Step {
+            /** Waiting for {preload_thread}, which is building this environment already. */
+            PRELOADING,
+            /** Waiting for the worker to read or convert the textures and the irradiance. */
+            GENERATING,
+            UPLOADING_CUBEMAP,
+            /** Uploading the pre-filter cubemap if the worker obtained it, otherwise rendering it. */
+            PRE_FILTERING,
+            /** Waiting for the GPU to finish the rendered pre-filter cubemap, after which it is cached. */
+            READING_BACK,
+            READY
+        };
+
+        uint32_t cubemap_id;
+        uint32_t pre_filter_id;
+        /** Identifies this environment, such that results of a replaced environment are not used. */
+        uint64_t ticket;
+        Step step;
+
+        /** Results of the worker. */
+        int cubemap_rval;
+        TextureData cubemap_data;
+        int pre_filter_rval;
+        TextureData pre_filter_data;
+        int irradiance_rval;
+        SphericalHarmonics irradiance;
+        int dominant_light_rval;
+        DominantLight dominant_light;
+
+        Texture *cubemap;
+        Texture *pre_filter;
+        /**
+         * Index of the next face to upload, counting the faces of all levels from the coarsest level, or of the next
+         * level to render counting from the coarsest level. */
+        uint32_t next_part;
+        PreFilterPass *pre_filter_pass;
+        GLsync pre_filter_fence;
+
+        uint32_t frame_count;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    /** Results of the worker of an environment, handed to {update_environment}. */
+    struct EnvironmentResult {
+        uint64_t ticket;
+        int cubemap_rval;
+        TextureData cubemap_data;
+        int pre_filter_rval;
+        TextureData pre_filter_data;
+        int irradiance_rval;
+        SphericalHarmonics irradiance;
+        int dominant_light_rval;
+        DominantLight dominant_light;
+    };
+
+    /** Environment being prepared, nullptr if none is. */
+    Environment *environment = nullptr;
+
+    /** Guarded by {decode_results_mutex}, like {decode_results}. */
+    std::vector<EnvironmentResult> environment_results;
+
+    /**
+     * Milliseconds it takes to upload a byte and to render each level of a pre-filter cubemap, measured while
+     * preparing environments to fit the work in the budget of {update_environment}. Levels are absent until measured. */
+    double upload_ms_per_byte;
+    std::map<uint32_t, double> pre_filter_level_ms;
+
+    /** Timer queries of rendered pre-filter levels and the levels, in order, read once available. */
+    std::deque<std::pair<GLuint, uint32_t>> pre_filter_queries;
+
+    /** Environment built by {preload_thread}, handed to {update_preloading}. */
+    struct PreloadResult {
+        uint32_t cubemap_id;
+        uint32_t pre_filter_id;
+        /** Both nullptr if building failed, after which the environment is prepared when switched to. */
+        Texture *cubemap;
+        Texture *pre_filter;
+        int irradiance_rval;
+        SphericalHarmonics irradiance;
+        int dominant_light_rval;
+        DominantLight dominant_light;
+        /** Signalled once the GPU finished the commands of the loader context that create the textures. */
+        GLsync fence;
+    };
+
+    /** Builds {ENVIRONMENTS} on a shared context, see {start_preloading}. */
+    std::thread preload_thread;
+    std::atomic<bool> preload_stopping{false};
+
+    /** Guarded by {decode_results_mutex}, like {decode_results}. */
+    std::vector<PreloadResult> preload_results;
+
+    /** Results of which the fence has not been signalled yet, only accessed by the render thread. */
+    std::vector<PreloadResult> preload_pending;
+
+    /** Cubemap ids of environments that {preload_thread} has yet to deliver, only accessed by the render thread. */
+    std::vector<uint32_t> preloading;
+
+    /**
+     * Cubemap ids of environments left to the render thread by {start_preloading}, made resident by
+     * {update_preloading} once the render thread created them. */
+    std::vector<uint32_t> preload_skipped;
+
+    /** Body of {preload_thread}, builds the environments with {cubemap_ids} on the current, shared context. */
+    void preload(const std::vector<uint32_t> &cubemap_ids);
+
+    /** Submits the worker that reads or converts the textures and irradiance of {environment}. */
+    void generate_environment();
+
+    /** Whether both textures, the irradiance and the dominant light of an environment are created. */
+    bool is_environment_created(uint32_t cubemap_id, uint32_t pre_filter_id) const;
+
+    /**
+     * Moves {texture} into the manager as the item with {id}. If it exists, the texture replaces the old one in its
+     * handle like streamed textures do, such that handles obtained before remain valid. */
+    void replace_item(uint32_t id, Texture *texture);
+
+    /** Performs the next step of {environment}, returns false if it has to wait for the worker or the GPU. */
+    bool step_environment();
+
+    /**
+     * Returns the estimated milliseconds of the next step of {environment}. Steps of which the duration is unknown
+     * are estimated to take the full {budget_ms}, such that they are performed alone. */
+    double estimate_environment_step(double budget_ms) const;
+
+    /**
+     * Uploads the next face of {data} to {texture}, counting the faces of all levels from the coarsest level.
+     * Returns true if it was the last face. */
+    bool upload_environment_face(Texture *texture, const TextureData *data);
+
+    /** Moves the textures of the ready {environment} into the manager, replacing existing ones. */
+    void finish_environment();
+
+    /** Deletes {environment} and everything created for it that was not moved into the manager. */
+    void cancel_environment();
+
+    /** Ids of textures currently being created, to detect cyclic dependencies between texture resources. */
+    std::vector<uint32_t> creating;
+
+    /**
+     * Returns the texture with {id} as intermediate for creating another texture. It is shared by all textures derived
+     * from it in the same frame, and is deleted by {make_space} unless it is also requested directly using {get}. */
+    Texture *get_intermediate(uint32_t id);
+
+    /** Creates {texture} from the decoded image of {resource}, decoding it first if it was not prefetched. */
+    int create_decoded_texture(Texture *texture, uint32_t id, const TextureResource *resource);
+
+    /** Points {texture} to the placeholder for {resource} and starts decoding it on {decode_pool}. */
+    int create_streamed_texture(Texture *texture, uint32_t id, const TextureResource *resource);
+
+    /** Stops streaming {id} if it is, after which {texture} no longer refers to the shared placeholder. */
+    void cancel_stream(Texture *texture, uint32_t id);
+
+    /**
+     * Uploads rows of the first texture in {upload_queue} within the remaining {budget} using a single buffer of
+     * {upload_ring}, returns the number of bytes uploaded. */
+    size_t upload_stream_rows(size_t budget);
+
     int32_t create_item(Texture **item, uint32_t id) override;
 
     void delete_item(Texture **item, uint32_t id) override;
@@ -141,7 +565,84 @@ private:
     static void delete_item_self(Texture **item, uint32_t id);
 
 public:
+    /** File name of the resource pack written by {pbr_pack}, relative to the working directory. */
+    static const char *const RESOURCE_PACK;
+
+    /** Default of the per frame upload budget of streaming textures. */
+    static const size_t DEFAULT_UPLOAD_BUDGET = 4 * 1024 * 1024;
+
+    /** Default of the per frame budget of preparing environments, in milliseconds. */
+    static const double DEFAULT_ENVIRONMENT_BUDGET;
+
+    TextureManager();
+
     ~TextureManager() override;
+
+    /**
+     * Creates all textures with {ids} which are not created yet. Images are decoded in parallel on {decode_pool} and
+     * only uploaded on the calling thread, after which the textures are shared like intermediates (see
+     * {get_intermediate}). Should be called with all textures needed for a frame before any of them are requested. */
+    void prefetch(const std::vector<uint32_t> &ids);
+
+    /**
+     * Hints the operating system to read the packed files of textures {ids} in the background, such that they are in
+     * memory by the time they are needed. Intended for textures that are needed soon, but not yet this frame. */
+    void prefetch_files(const std::vector<uint32_t> &ids);
+
+    /**
+     * In streaming mode, {get} returns textures decoded from an image immediately, showing a small placeholder until
+     * the image is decoded in the background and uploaded by {update_streaming}. At most {p_upload_budget} bytes are
+     * uploaded per frame. Textures that are used to derive other textures from are never streamed. */
+    void set_streaming(bool p_streaming, size_t p_upload_budget = DEFAULT_UPLOAD_BUDGET);
+
+    /**
+     * Returns the irradiance of the environment with cubemap {id} as spherical harmonics, which replace the irradiance
+     * cubemap. It is projected on the CPU, without creating the cubemap texture. */
+    int get_irradiance(uint32_t id, SphericalHarmonics *irradiance);
+
+    /**
+     * Returns the dominant light of the environment with cubemap {id}, which was removed from the cubemap and its
+     * irradiance and is shaded analytically instead. Obtained like {get_irradiance}. */
+    int get_dominant_light(uint32_t id, DominantLight *light);
+
+    /**
+     * Uploads decoded streaming textures through {upload_ring} without waiting on the GPU, and swaps textures that
+     * are fully uploaded into their handles. Should be called once per frame. */
+    void update_streaming();
+
+    /**
+     * Starts preparing the environment with cubemap {cubemap_id}, pre-filter cubemap {pre_filter_id} derived from it,
+     * and their irradiance, without blocking. The cubemap, the irradiance and cached or baked pre-filter cubemaps are
+     * read or converted on a worker, after which {update_environment} uploads the rest a face at a time and renders it
+     * a level at a time.
+     * Replaces the environment that was being prepared, if any. */
+    void prepare_environment(uint32_t cubemap_id, uint32_t pre_filter_id);
+
+    /**
+     * Performs steps of the environment being prepared until the work of this frame is estimated to exceed
+     * {budget_ms}, but at least a single step. Returns true once the environment is ready, after which its textures
+     * and irradiance are obtained without creating them. Should be called once per frame until it returns true. */
+    bool update_environment(double budget_ms);
+
+    /**
+     * Starts a loader thread that builds the textures and irradiance of every environment in the background, after
+     * which switching environments only swaps the textures that are bound. {set_context_current} is called on the
+     * loader thread to make a context that is shared with the calling thread current (true) or to release it (false).
+     * Preloaded environments are resident, {make_space} does not delete them. The environment with {bound_cubemap_id}
+     * is left out, the render thread creates it when it is first bound, which would otherwise build it twice at once.
+     * It is made resident once created. */
+    void start_preloading(const std::function<void(bool)> &set_context_current, uint32_t bound_cubemap_id);
+
+    /**
+     * Moves environments into the manager of which the loader thread finished the textures, which is known through
+     * their fences without waiting. An environment that the render thread created in the meantime is kept, and the
+     * textures of the loader thread are deleted. Should be called once per frame while preloading. */
+    void update_preloading();
+
+    /**
+     * Stops and joins the loader thread once it finishes the current environment, and deletes the environments it
+     * did not deliver. Should be called before the shared context is destroyed. */
+    void stop_preloading();
 };
 
 #endif //SYSTEM_TEXTURE_MANAGER_HPP
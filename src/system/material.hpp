@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <map>
+#include <vector>
 
 #include "opengl/shader.hpp"
 #include "manager/texture_manager.hpp"
@@ -20,11 +21,12 @@ struct Material {
 
     uint32_t diffuse;
     uint32_t normal;
-    uint32_t ambient_occlusion;
-    uint32_t roughness;
-    uint32_t displacement;
+    /** Roughness and metallic packed into the red and green channels. */
+    uint32_t rough_metal;
+    /** Ambient occlusion and displacement packed into the red and green channels. */
+    uint32_t ao_disp;
 
-    Material(uint32_t diffuse, uint32_t normal, uint32_t ambient_occlusion, uint32_t roughness, uint32_t displacement);
+    Material(uint32_t diffuse, uint32_t normal, uint32_t rough_metal, uint32_t ao_disp);
 
     static const std::map<uint32_t, Material *> MATERIALS;
 
@@ -35,19 +37,9 @@ struct Material {
     virtual void bind(TextureManager *manager);
 
     virtual void unbind(TextureManager *manager);
-};
-
-struct MaterialSpecular : public Material {
-    uint32_t specular;
-
-    MaterialSpecular(uint32_t diffuse, uint32_t normal, uint32_t ambient_occlusion, uint32_t roughness,
-                     uint32_t displacement, uint32_t specular);
-
-    void set(ShaderProgram *program, TextureManager *manager) override;
-
-    void bind(TextureManager *manager) override;
 
-    void unbind(TextureManager *manager) override;
+    /** Appends the ids of all textures this material uses to {textures}. */
+    virtual void get_textures(std::vector<uint32_t> *textures) const;
 };
 
 #endif //PBR_MATERIAL_HPP
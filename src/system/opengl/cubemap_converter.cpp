@@ -0,0 +1,443 @@
+#include "cubemap_converter.hpp"
+
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64)
+
+#include <xmmintrin.h>
+
+#define CUBEMAP_CONVERTER_SSE
+
+#endif
+
+#include "../../util/nm_log.hpp"
+
+const uint32_t CubemapConverter::VERSION = 1;
+
+const float CubemapConverter::FACE_AXES[6][3][3] = {
+        {{1.f,  0.f,  0.f},  {0.f,  0.f, -1.f}, {0.f, -1.f, 0.f}},
+        {{-1.f, 0.f,  0.f},  {0.f,  0.f, 1.f},  {0.f, -1.f, 0.f}},
+        {{0.f,  1.f,  0.f},  {1.f,  0.f, 0.f},  {0.f, 0.f,  1.f}},
+        {{0.f,  -1.f, 0.f},  {1.f,  0.f, 0.f},  {0.f, 0.f,  -1.f}},
+        {{0.f,  0.f,  1.f},  {1.f,  0.f, 0.f},  {0.f, -1.f, 0.f}},
+        {{0.f,  0.f,  -1.f}, {-1.f, 0.f, 0.f},  {0.f, -1.f, 0.f}}
+};
+
+void CubemapConverter::get_octahedral_direction(float s, float t, float *direction)
+{
+    direction[1] = 1.f - fabsf(s) - fabsf(t);
+    if (direction[1] < 0.f) {
+        // the corners mirror over the edges of the diamond
+        float folded_s = copysignf(1.f - fabsf(t), s);
+        t = copysignf(1.f - fabsf(s), t);
+        s = folded_s;
+    }
+    direction[0] = s;
+    direction[2] = t;
+}
+
+/** Writes the unnormalized direction of the texel at {s}, {t} of {face}, of an octahedral map if {face_count} is 1. */
+static inline void get_texel_direction(uint32_t face_count, uint32_t face, float s, float t, float *direction)
+{
+    if (face_count == 1) {
+        CubemapConverter::get_octahedral_direction(s, t, direction);
+
+        return;
+    }
+
+    const float (*axes)[3] = CubemapConverter::FACE_AXES[face];
+    for (int c = 0; c < 3; c++) {
+        direction[c] = axes[0][c] + s * axes[1][c] + t * axes[2][c];
+    }
+}
+
+/** Edge length of the tiles that faces are split into, one tile is resampled and reduced per task. */
+static const uint32_t TILE_SIZE = 32;
+
+/** Number of rows of the equirectangular image that are converted to floats per task. */
+static const uint32_t SOURCE_ROWS_PER_TASK = 32;
+
+// RGBA pixels of floats, the fourth value is padding such that a pixel is a single vector
+#ifdef CUBEMAP_CONVERTER_SSE
+
+typedef __m128 Pixel;
+
+static inline Pixel load_pixel(const float *values)
+{
+    return _mm_loadu_ps(values);
+}
+
+static inline void store_pixel(float *values, Pixel pixel)
+{
+    _mm_storeu_ps(values, pixel);
+}
+
+static inline Pixel lerp_pixels(Pixel a, Pixel b, float t)
+{
+    return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_set1_ps(t)));
+}
+
+static inline Pixel average_pixels(Pixel a, Pixel b, Pixel c, Pixel d)
+{
+    return _mm_mul_ps(_mm_add_ps(_mm_add_ps(a, b), _mm_add_ps(c, d)), _mm_set1_ps(.25f));
+}
+
+#else
+
+struct Pixel {
+    float values[4];
+};
+
+static inline Pixel load_pixel(const float *values)
+{
+    Pixel pixel{};
+    memcpy(pixel.values, values, sizeof(pixel.values));
+
+    return pixel;
+}
+
+static inline void store_pixel(float *values, Pixel pixel)
+{
+    memcpy(values, pixel.values, sizeof(pixel.values));
+}
+
+static inline Pixel lerp_pixels(Pixel a, Pixel b, float t)
+{
+    for (int i = 0; i < 4; i++) {
+        a.values[i] += (b.values[i] - a.values[i]) * t;
+    }
+
+    return a;
+}
+
+static inline Pixel average_pixels(Pixel a, Pixel b, Pixel c, Pixel d)
+{
+    for (int i = 0; i < 4; i++) {
+        a.values[i] = (a.values[i] + b.values[i] + c.values[i] + d.values[i]) * .25f;
+    }
+
+    return a;
+}
+
+#endif
+
+/**
+ * Coefficients of the odd polynomial approximating atan on [0, 1] to within 1e-5 radians, far below the 6e-3 radians
+ * a texel of a 1k equirectangular image spans. */
+static const float ATAN_COEFFICIENTS[6] = {
+        .99997726f, -.33262347f, .19354346f, -.11643287f, .05265332f, -.01172120f};
+
+/** Approximates atan2 from the ratio of the smaller to the larger magnitude, which is mirrored into place. */
+static inline float approximate_atan2(float y, float x)
+{
+    float abs_x = fabsf(x);
+    float abs_y = fabsf(y);
+    float larger = fmaxf(fmaxf(abs_x, abs_y), FLT_MIN);
+    float ratio = fminf(abs_x, abs_y) / larger;
+    float ratio_squared = ratio * ratio;
+
+    float polynomial = ATAN_COEFFICIENTS[5];
+    for (int i = 4; i >= 0; i--) {
+        polynomial = polynomial * ratio_squared + ATAN_COEFFICIENTS[i];
+    }
+    float angle = ratio * polynomial;
+
+    if (abs_y > abs_x) {
+        angle = (float) (.5 * M_PI) - angle;
+    }
+    if (x < 0.f) {
+        angle = (float) M_PI - angle;
+    }
+
+    return copysignf(angle, y);
+}
+
+#ifdef CUBEMAP_CONVERTER_SSE
+
+/** {approximate_atan2} of 4 values at once. */
+static inline __m128 approximate_atan2(__m128 y, __m128 x)
+{
+    const __m128 sign_mask = _mm_set1_ps(-0.f);
+    __m128 abs_x = _mm_andnot_ps(sign_mask, x);
+    __m128 abs_y = _mm_andnot_ps(sign_mask, y);
+    __m128 larger = _mm_max_ps(_mm_max_ps(abs_x, abs_y), _mm_set1_ps(FLT_MIN));
+    __m128 ratio = _mm_div_ps(_mm_min_ps(abs_x, abs_y), larger);
+    __m128 ratio_squared = _mm_mul_ps(ratio, ratio);
+
+    __m128 polynomial = _mm_set1_ps(ATAN_COEFFICIENTS[5]);
+    for (int i = 4; i >= 0; i--) {
+        polynomial = _mm_add_ps(_mm_mul_ps(polynomial, ratio_squared), _mm_set1_ps(ATAN_COEFFICIENTS[i]));
+    }
+    __m128 angle = _mm_mul_ps(ratio, polynomial);
+
+    __m128 swapped = _mm_cmpgt_ps(abs_y, abs_x);
+    angle = _mm_or_ps(
+            _mm_and_ps(swapped, _mm_sub_ps(_mm_set1_ps((float) (.5 * M_PI)), angle)), _mm_andnot_ps(swapped, angle));
+    __m128 negative_x = _mm_cmplt_ps(x, _mm_setzero_ps());
+    angle = _mm_or_ps(
+            _mm_and_ps(negative_x, _mm_sub_ps(_mm_set1_ps((float) M_PI), angle)), _mm_andnot_ps(negative_x, angle));
+
+    // the angle is positive, so the sign of y can be or-ed in
+    return _mm_or_ps(angle, _mm_and_ps(y, sign_mask));
+}
+
+#endif
+
+/** Samples RGBA {pixels} bilinearly at {u}, {v}. Longitude wraps around, latitude is clamped at the poles. */
+static Pixel sample_bilinear(const float *pixels, uint32_t width, uint32_t height, float u, float v)
+{
+    float x = u * (float) width - .5f;
+    float y = v * (float) height - .5f;
+    float x_floor = floorf(x);
+    float y_floor = floorf(y);
+
+    auto x0 = (int32_t) x_floor;
+    int32_t x1 = x0 + 1;
+    x0 = x0 < 0 ? x0 + (int32_t) width : x0 >= (int32_t) width ? x0 - (int32_t) width : x0;
+    x1 = x1 < 0 ? x1 + (int32_t) width : x1 >= (int32_t) width ? x1 - (int32_t) width : x1;
+
+    auto y0 = (int32_t) y_floor;
+    int32_t y1 = y0 + 1;
+    y0 = y0 < 0 ? 0 : y0 >= (int32_t) height ? (int32_t) height - 1 : y0;
+    y1 = y1 < 0 ? 0 : y1 >= (int32_t) height ? (int32_t) height - 1 : y1;
+
+    const float *row0 = pixels + (size_t) y0 * width * 4;
+    const float *row1 = pixels + (size_t) y1 * width * 4;
+    float t = x - x_floor;
+    Pixel bottom = lerp_pixels(load_pixel(row0 + x0 * 4), load_pixel(row0 + x1 * 4), t);
+    Pixel top = lerp_pixels(load_pixel(row1 + x0 * 4), load_pixel(row1 + x1 * 4), t);
+
+    return lerp_pixels(bottom, top, y - y_floor);
+}
+
+/** Halves {size} by {size} RGBA {pixels} in place with a box filter. */
+static void reduce_pixels(float *pixels, uint32_t size)
+{
+    uint32_t half_size = size / 2;
+    for (uint32_t y = 0; y < half_size; y++) {
+        for (uint32_t x = 0; x < half_size; x++) {
+            // NB: every output precedes the inputs of the outputs after it, so they are never overwritten early
+            const float *in = pixels + ((size_t) y * 2 * size + x * 2) * 4;
+            store_pixel(pixels + ((size_t) y * half_size + x) * 4, average_pixels(
+                    load_pixel(in), load_pixel(in + 4), load_pixel(in + size * 4), load_pixel(in + size * 4 + 4)));
+        }
+    }
+}
+
+/** Writes {size} by {size} RGBA {pixels} as RGB half floats to {face} of {level} at {x}, {y}. */
+static void write_pixels(
+        TextureData *data, uint32_t level, uint32_t face, uint32_t x, uint32_t y, uint32_t size, const float *pixels)
+{
+    uint8_t *level_pixels = data->get_pixels(level, face);
+    size_t row_size = data->get_row_size(level);
+    for (uint32_t j = 0; j < size; j++) {
+        auto *row = (uint16_t *) (level_pixels + (y + j) * row_size) + (size_t) x * 3;
+        for (uint32_t i = 0; i < size; i++) {
+            for (uint32_t c = 0; c < 3; c++) {
+                row[i * 3 + c] = TextureData::float_to_half(pixels[((size_t) j * size + i) * 4 + c]);
+            }
+        }
+    }
+}
+
+/**
+ * Resamples {equirectangular} into {data}, a cubemap if {face_count} is 6 or an octahedral map if it is 1, as described
+ * by {CubemapConverter::convert}. */
+static int resample(
+        TextureData *data, const TextureData *equirectangular, uint32_t resolution, uint32_t face_count,
+        ThreadPool *pool)
+{
+    if (equirectangular->texture_type != GL_TEXTURE_2D || equirectangular->face_count != 1 ||
+        equirectangular->format != GL_RGB ||
+        (equirectangular->type != GL_FLOAT && equirectangular->type != GL_HALF_FLOAT)) {
+        nm_log::log(LOG_ERROR, "equirectangular image must be a single RGB image of floats or half floats\n");
+
+        return EXIT_FAILURE;
+    }
+    if (resolution == 0 || (resolution & (resolution - 1)) != 0) {
+        nm_log::log(LOG_ERROR, "environment resolution %d is not a power of two\n", resolution);
+
+        return EXIT_FAILURE;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto run = [pool](std::function<void()> task) {
+        if (pool) {
+            pool->submit(std::move(task));
+        } else {
+            task();
+        }
+    };
+
+    // expand to RGBA floats, such that a sample is a single load of every neighbour
+    uint32_t width = equirectangular->width;
+    uint32_t height = equirectangular->height;
+    std::vector<float> source((size_t) width * height * 4);
+    for (uint32_t first_row = 0; first_row < height; first_row += SOURCE_ROWS_PER_TASK) {
+        run([equirectangular, &source, width, height, first_row] {
+            uint32_t last_row = first_row + SOURCE_ROWS_PER_TASK < height ? first_row + SOURCE_ROWS_PER_TASK : height;
+            for (size_t i = (size_t) first_row * width; i < (size_t) last_row * width; i++) {
+                for (uint32_t c = 0; c < 3; c++) {
+                    if (equirectangular->type == GL_HALF_FLOAT) {
+                        uint16_t half;
+                        memcpy(&half, &equirectangular->data[(i * 3 + c) * sizeof(half)], sizeof(half));
+                        source[i * 4 + c] = TextureData::half_to_float(half);
+                    } else {
+                        memcpy(&source[i * 4 + c], &equirectangular->data[(i * 3 + c) * sizeof(float)],
+                               sizeof(float));
+                    }
+                }
+                source[i * 4 + 3] = 0.f;
+            }
+        });
+    }
+    if (pool) {
+        pool->wait();
+    }
+
+    uint32_t level_count = 1;
+    while (resolution >> level_count) {
+        level_count++;
+    }
+    GLenum texture_type = face_count == 6 ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    *data = TextureData{
+            texture_type, GL_RGB16F, GL_RGB, GL_HALF_FLOAT, resolution, resolution, level_count, face_count, {}};
+    size_t size = 0;
+    for (uint32_t level = 0; level < level_count; level++) {
+        size += data->get_level_size(level) * face_count;
+    }
+    data->data.resize(size);
+
+    // every tile writes its part of the levels down to a single pixel, which it leaves in {tile_pixels}
+    uint32_t tile_size = resolution < TILE_SIZE ? resolution : TILE_SIZE;
+    uint32_t tile_count = resolution / tile_size;
+    std::vector<float> tile_pixels((size_t) face_count * tile_count * tile_count * 4);
+    for (uint32_t face = 0; face < face_count; face++) {
+        for (uint32_t tile_y = 0; tile_y < tile_count; tile_y++) {
+            for (uint32_t tile_x = 0; tile_x < tile_count; tile_x++) {
+                run([data, &source, &tile_pixels, width, height, resolution, tile_size, tile_count, face_count, face,
+                            tile_x, tile_y] {
+                    std::vector<float> pixels((size_t) tile_size * tile_size * 4);
+                    for (uint32_t j = 0; j < tile_size; j++) {
+                        float t = ((float) (tile_y * tile_size + j) + .5f) / (float) resolution * 2.f - 1.f;
+                        float *row = &pixels[(size_t) j * tile_size * 4];
+
+                        // same mapping as the render pass this replaces, asin(y) is expressed as an atan2 of y and
+                        // the horizontal length such that both coordinates share an approximation
+                        uint32_t i = 0;
+#ifdef CUBEMAP_CONVERTER_SSE
+                        for (; i + 4 <= tile_size; i += 4) {
+                            __m128 s = _mm_add_ps(_mm_set1_ps((float) (tile_x * tile_size + i) + .5f),
+                                                  _mm_set_ps(3.f, 2.f, 1.f, 0.f));
+                            s = _mm_sub_ps(_mm_mul_ps(s, _mm_set1_ps(2.f / (float) resolution)), _mm_set1_ps(1.f));
+                            __m128 direction[3];
+                            if (face_count == 6) {
+                                const float (*axes)[3] = CubemapConverter::FACE_AXES[face];
+                                for (int c = 0; c < 3; c++) {
+                                    direction[c] = _mm_add_ps(
+                                            _mm_set1_ps(axes[0][c] + t * axes[2][c]),
+                                            _mm_mul_ps(s, _mm_set1_ps(axes[1][c])));
+                                }
+                            } else {
+                                // the fold is a branch per texel, the directions are gathered into vectors
+                                float s_values[4];
+                                float directions[3][4];
+                                _mm_storeu_ps(s_values, s);
+                                for (uint32_t k = 0; k < 4; k++) {
+                                    float texel_direction[3];
+                                    CubemapConverter::get_octahedral_direction(s_values[k], t, texel_direction);
+                                    for (int c = 0; c < 3; c++) {
+                                        directions[c][k] = texel_direction[c];
+                                    }
+                                }
+                                for (int c = 0; c < 3; c++) {
+                                    direction[c] = _mm_loadu_ps(directions[c]);
+                                }
+                            }
+                            __m128 horizontal = _mm_sqrt_ps(_mm_add_ps(
+                                    _mm_mul_ps(direction[0], direction[0]), _mm_mul_ps(direction[2], direction[2])));
+
+                            float u[4];
+                            float v[4];
+                            _mm_storeu_ps(u, _mm_add_ps(
+                                    _mm_mul_ps(approximate_atan2(direction[2], direction[0]),
+                                               _mm_set1_ps((float) (.5 / M_PI))), _mm_set1_ps(.5f)));
+                            _mm_storeu_ps(v, _mm_add_ps(
+                                    _mm_mul_ps(approximate_atan2(direction[1], horizontal),
+                                               _mm_set1_ps((float) (1. / M_PI))), _mm_set1_ps(.5f)));
+                            for (uint32_t k = 0; k < 4; k++) {
+                                store_pixel(&row[(i + k) * 4],
+                                            sample_bilinear(source.data(), width, height, u[k], v[k]));
+                            }
+                        }
+#endif
+                        for (; i < tile_size; i++) {
+                            float s = ((float) (tile_x * tile_size + i) + .5f) / (float) resolution * 2.f - 1.f;
+                            float direction[3];
+                            get_texel_direction(face_count, face, s, t, direction);
+                            float horizontal = sqrtf(direction[0] * direction[0] + direction[2] * direction[2]);
+
+                            float u = approximate_atan2(direction[2], direction[0]) * (float) (.5 / M_PI) + .5f;
+                            float v = approximate_atan2(direction[1], horizontal) * (float) (1. / M_PI) + .5f;
+                            store_pixel(&row[i * 4], sample_bilinear(source.data(), width, height, u, v));
+                        }
+                    }
+
+                    uint32_t level = 0;
+                    uint32_t size = tile_size;
+                    write_pixels(data, level, face, tile_x * size, tile_y * size, size, pixels.data());
+                    while (size > 1) {
+                        reduce_pixels(pixels.data(), size);
+                        size /= 2;
+                        level++;
+                        write_pixels(data, level, face, tile_x * size, tile_y * size, size, pixels.data());
+                    }
+
+                    memcpy(&tile_pixels[(((size_t) face * tile_count + tile_y) * tile_count + tile_x) * 4],
+                           pixels.data(), 4 * sizeof(float));
+                });
+            }
+        }
+    }
+    if (pool) {
+        pool->wait();
+    }
+
+    // the remaining levels are reduced from the single pixels of the tiles
+    uint32_t tile_level = 0;
+    while (tile_size >> tile_level > 1) {
+        tile_level++;
+    }
+    for (uint32_t face = 0; face < face_count; face++) {
+        float *pixels = &tile_pixels[(size_t) face * tile_count * tile_count * 4];
+        uint32_t level = tile_level;
+        for (uint32_t size = tile_count; size > 1; size /= 2) {
+            reduce_pixels(pixels, size);
+            level++;
+            write_pixels(data, level, face, 0, 0, size / 2, pixels);
+        }
+    }
+
+    double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    nm_log::log(LOG_INFO, "converted %dx%d equirectangular image to %d levels of %dx%d %s in %.2f ms\n",
+                width, height, level_count, resolution, resolution,
+                face_count == 6 ? "cubemap faces" : "octahedral map", time);
+
+    return EXIT_SUCCESS;
+}
+
+int CubemapConverter::convert(
+        TextureData *cubemap, const TextureData *equirectangular, uint32_t resolution, ThreadPool *pool)
+{
+    return resample(cubemap, equirectangular, resolution, 6, pool);
+}
+
+int CubemapConverter::convert_octahedral(
+        TextureData *octahedral, const TextureData *equirectangular, uint32_t resolution, ThreadPool *pool)
+{
+    return resample(octahedral, equirectangular, resolution, 1, pool);
+}
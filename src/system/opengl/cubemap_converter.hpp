@@ -0,0 +1,42 @@
+#ifndef SYSTEM_CUBEMAP_CONVERTER_HPP
+#define SYSTEM_CUBEMAP_CONVERTER_HPP
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "texture_data.hpp"
+#include "../../util/thread_pool.hpp"
+
+/**
+ * Converts equirectangular environment images to cubemaps or octahedral maps on the CPU, replacing the render pass that
+ * required the image to be uploaded as 32 bit floats. Faces are split into tiles that are resampled in parallel, after
+ * which every tile reduces itself to its part of the smaller levels while it is still in cache. */
+struct CubemapConverter {
+    /** Bumped whenever the converted cubemaps change, such that cached conversions are regenerated. */
+    static const uint32_t VERSION;
+
+    /**
+     * Major axis, and the axes along which s and t increase, of each face in the order of {GL_TEXTURE_CUBE_MAP}.
+     * The direction of the texel at s, t in [-1, 1] is {major + s * s_axis + t * t_axis}, its first row is at t = -1. */
+    static const float FACE_AXES[6][3][3];
+
+    /**
+     * Writes the direction of the texel at s, t in [-1, 1] of an octahedral map to {direction}, its first row is at
+     * t = -1. The inner diamond |s| + |t| <= 1 holds the upper hemisphere with +Y at the center, the corners fold over
+     * to the lower hemisphere. The direction has an L1 norm of 1, it is not normalized. */
+    static void get_octahedral_direction(float s, float t, float *direction);
+
+    /**
+     * Resamples {equirectangular}, a single level RGB image of {GL_FLOAT} or {GL_HALF_FLOAT} of which the first row is
+     * the bottom one, into {cubemap} with faces of {resolution} by {resolution} {GL_RGB16F} pixels and the full mip
+     * chain. Pixels are sampled bilinearly, levels are box filtered. {resolution} must be a power of two.
+     * Tiles are resampled on {pool}, which is waited on and thus must not be the pool of the calling thread, or on the
+     * calling thread if it is null. Does not touch OpenGL state. */
+    static int convert(TextureData *cubemap, const TextureData *equirectangular, uint32_t resolution, ThreadPool *pool);
+
+    /** Like {convert}, but into a single {GL_TEXTURE_2D} octahedral map of {resolution} by {resolution} pixels. */
+    static int convert_octahedral(
+            TextureData *octahedral, const TextureData *equirectangular, uint32_t resolution, ThreadPool *pool);
+};
+
+#endif //SYSTEM_CUBEMAP_CONVERTER_HPP
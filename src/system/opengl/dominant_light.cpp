@@ -0,0 +1,191 @@
+#include "dominant_light.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#include "../../util/nm_log.hpp"
+
+const uint32_t DominantLight::VERSION = 1;
+
+/** A texel is part of the lobe if its luminance exceeds the average luminance of the environment this many times. */
+static const float LOBE_THRESHOLD = 32.f;
+
+/** Cosine of the angular radius around the brightest texel the lobe is searched in, ten degrees. */
+static const float LOBE_COS_RADIUS = .984808f;
+
+/** Number of {GL_RGB32F} pixels {DominantLight::write_texture_data} stores. */
+static const uint32_t PIXEL_COUNT = 3;
+
+static float get_luminance(const float *rgb)
+{
+    return .2126f * rgb[0] + .7152f * rgb[1] + .0722f * rgb[2];
+}
+
+/** Latitude of the center of row {j} of {height} rows, the first row being the bottom one. */
+static float get_latitude(uint32_t j, uint32_t height)
+{
+    return (float) ((((float) j + .5f) / (float) height - .5f) * M_PI);
+}
+
+/** Direction of the texel at longitude column {i} of {width} columns and {latitude}, as {CubemapConverter} maps it. */
+static glm::vec3 get_direction(uint32_t i, uint32_t width, float latitude)
+{
+    auto longitude = (float) ((((float) i + .5f) / (float) width - .5f) * 2. * M_PI);
+
+    return glm::vec3(cosf(longitude) * cosf(latitude), sinf(latitude), sinf(longitude) * cosf(latitude));
+}
+
+int DominantLight::extract(DominantLight *light, TextureData *equirectangular)
+{
+    if (equirectangular->texture_type != GL_TEXTURE_2D || equirectangular->face_count != 1 ||
+        equirectangular->format != GL_RGB ||
+        (equirectangular->type != GL_FLOAT && equirectangular->type != GL_HALF_FLOAT)) {
+        nm_log::log(LOG_ERROR, "dominant light can only be extracted from an RGB image of floats or half floats\n");
+
+        return EXIT_FAILURE;
+    }
+
+    *light = DominantLight{glm::vec3(0.f, 1.f, 0.f), glm::vec3(0.f), 0.f};
+
+    uint32_t width = equirectangular->width;
+    uint32_t height = equirectangular->height;
+    uint32_t pixel_size = TextureData::get_pixel_size(equirectangular->format, equirectangular->type);
+    size_t row_size = equirectangular->get_row_size(0);
+    uint8_t *pixels = equirectangular->get_pixels(0, 0);
+
+    // average the radiance over the sphere, texels are weighted by their solid angle which shrinks towards the poles
+    double radiance_sum[3] = {};
+    double weight_sum = 0.;
+    float peak = 0.f;
+    uint32_t peak_i = 0;
+    uint32_t peak_j = 0;
+    for (uint32_t j = 0; j < height; j++) {
+        float weight = cosf(get_latitude(j, height));
+        for (uint32_t i = 0; i < width; i++) {
+            float rgb[3];
+            TextureData::read_rgb(equirectangular->type, pixels + j * row_size + i * pixel_size, rgb);
+            for (uint32_t c = 0; c < 3; c++) {
+                radiance_sum[c] += (double) (rgb[c] * weight);
+            }
+
+            float luminance = get_luminance(rgb);
+            if (luminance > peak) {
+                peak = luminance;
+                peak_i = i;
+                peak_j = j;
+            }
+        }
+        weight_sum += (double) weight * width;
+    }
+    float average[3];
+    for (uint32_t c = 0; c < 3; c++) {
+        average[c] = (float) (radiance_sum[c] / weight_sum);
+    }
+
+    // an overcast sky or a studio has no texel that stands out, it is left to the image based lighting
+    float threshold = LOBE_THRESHOLD * get_luminance(average);
+    if (peak <= threshold) {
+        return EXIT_SUCCESS;
+    }
+
+    // only the rows within the search radius of the brightest texel are visited from here on
+    float peak_latitude = get_latitude(peak_j, height);
+    glm::vec3 peak_direction = get_direction(peak_i, width, peak_latitude);
+    float radius = acosf(LOBE_COS_RADIUS);
+    float first_v = fmaxf((peak_latitude - radius) / (float) M_PI + .5f, 0.f);
+    float last_v = fminf((peak_latitude + radius) / (float) M_PI + .5f, 1.f);
+    auto first_row = (uint32_t) (first_v * (float) height);
+    auto last_row = (uint32_t) fminf(last_v * (float) height + 1.f, (float) height);
+
+    // the radiance behind the lobe is estimated as that of the texels surrounding it
+    double background_sum[3] = {};
+    double background_weight = 0.;
+    for (uint32_t j = first_row; j < last_row; j++) {
+        float latitude = get_latitude(j, height);
+        float weight = cosf(latitude);
+        for (uint32_t i = 0; i < width; i++) {
+            if (glm::dot(get_direction(i, width, latitude), peak_direction) < LOBE_COS_RADIUS) {
+                continue;
+            }
+
+            float rgb[3];
+            TextureData::read_rgb(equirectangular->type, pixels + j * row_size + i * pixel_size, rgb);
+            if (get_luminance(rgb) <= threshold) {
+                for (uint32_t c = 0; c < 3; c++) {
+                    background_sum[c] += (double) (rgb[c] * weight);
+                }
+                background_weight += weight;
+            }
+        }
+    }
+    float background[3];
+    for (uint32_t c = 0; c < 3; c++) {
+        background[c] = background_weight > 0. ? (float) (background_sum[c] / background_weight) : average[c];
+    }
+
+    // move the radiance of the lobe above the background into the light
+    auto texel_solid_angle = (float) (2. * M_PI / width * M_PI / height);
+    glm::vec3 direction_sum(0.f);
+    for (uint32_t j = first_row; j < last_row; j++) {
+        float latitude = get_latitude(j, height);
+        float solid_angle = texel_solid_angle * cosf(latitude);
+        for (uint32_t i = 0; i < width; i++) {
+            glm::vec3 direction = get_direction(i, width, latitude);
+            if (glm::dot(direction, peak_direction) < LOBE_COS_RADIUS) {
+                continue;
+            }
+
+            uint8_t *pixel = pixels + j * row_size + i * pixel_size;
+            float rgb[3];
+            TextureData::read_rgb(equirectangular->type, pixel, rgb);
+            if (get_luminance(rgb) <= threshold) {
+                continue;
+            }
+
+            float excess[3];
+            for (uint32_t c = 0; c < 3; c++) {
+                excess[c] = fmaxf(rgb[c] - background[c], 0.f);
+            }
+            light->irradiance += glm::vec3(excess[0], excess[1], excess[2]) * solid_angle;
+            light->solid_angle += solid_angle;
+            direction_sum += direction * (get_luminance(excess) * solid_angle);
+            TextureData::write_rgb(equirectangular->type, background, pixel);
+        }
+    }
+    light->direction = glm::length(direction_sum) > 0.f ? glm::normalize(direction_sum) : peak_direction;
+
+    nm_log::log(LOG_INFO, "extracted dominant light of irradiance (%.2f, %.2f, %.2f) over %.2e sr\n",
+                (double) light->irradiance.x, (double) light->irradiance.y, (double) light->irradiance.z,
+                (double) light->solid_angle);
+
+    return EXIT_SUCCESS;
+}
+
+void DominantLight::write_texture_data(const DominantLight *light, TextureData *data)
+{
+    *data = TextureData{GL_TEXTURE_2D, GL_RGB32F, GL_RGB, GL_FLOAT, PIXEL_COUNT, 1, 1, 1, {}};
+    data->data.resize(PIXEL_COUNT * 3 * sizeof(float));
+    float values[PIXEL_COUNT * 3] = {
+            light->direction.x, light->direction.y, light->direction.z,
+            light->irradiance.x, light->irradiance.y, light->irradiance.z,
+            light->solid_angle, 0.f, 0.f};
+    memcpy(data->data.data(), values, sizeof(values));
+}
+
+int DominantLight::read_texture_data(DominantLight *light, const TextureData *data)
+{
+    if (data->internal_format != GL_RGB32F || data->width != PIXEL_COUNT || data->height != 1 ||
+        data->data.size() != PIXEL_COUNT * 3 * sizeof(float)) {
+        nm_log::log(LOG_ERROR, "texture data does not hold a dominant light\n");
+
+        return EXIT_FAILURE;
+    }
+
+    float values[PIXEL_COUNT * 3];
+    memcpy(values, data->data.data(), sizeof(values));
+    light->direction = glm::vec3(values[0], values[1], values[2]);
+    light->irradiance = glm::vec3(values[3], values[4], values[5]);
+    light->solid_angle = values[6];
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,39 @@
+#ifndef SYSTEM_DOMINANT_LIGHT_HPP
+#define SYSTEM_DOMINANT_LIGHT_HPP
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <glm/glm.hpp>
+
+#include "texture_data.hpp"
+
+/**
+ * The brightest lobe of an environment, like the sun of a clear sky, as an analytic directional light. It is removed
+ * from the environment before the cubemap is converted, such that the pre-filter cubemap and irradiance only hold the
+ * smooth residual, which few samples resolve. {pbr.frag} shades the light like its point lights, which keeps the
+ * highlight sharp, and {skybox.frag} draws it back as a disk. */
+struct DominantLight {
+    /** Bumped whenever the extraction changes, such that cached lights and cubemaps are regenerated. */
+    static const uint32_t VERSION;
+
+    /** Unit direction towards the light, in the frame of the environment. */
+    glm::vec3 direction;
+    /** Irradiance on a surface facing the light, zero if the environment has no dominant light. */
+    glm::vec3 irradiance;
+    /** Solid angle the lobe covered, in steradians. */
+    float solid_angle;
+
+    /**
+     * Finds the brightest lobe of {equirectangular}, as decoded by {Texture::decode_tex} and taken by
+     * {CubemapConverter::convert}, and replaces its texels by the radiance around it. {light} is left without
+     * irradiance if no texel stands out enough. Does not touch OpenGL state. */
+    static int extract(DominantLight *light, TextureData *equirectangular);
+
+    /** Stores {light} as a single row of 3 {GL_RGB32F} pixels, such that it is cached and baked like a texture. */
+    static void write_texture_data(const DominantLight *light, TextureData *data);
+
+    static int read_texture_data(DominantLight *light, const TextureData *data);
+};
+
+#endif //SYSTEM_DOMINANT_LIGHT_HPP
@@ -0,0 +1,88 @@
+#include "environment_bundle.hpp"
+
+#include <cstring>
+
+#include "../../util/nm_log.hpp"
+
+static const char MAGIC[4] = {'P', 'B', 'R', 'E'};
+
+const uint32_t EnvironmentBundle::VERSION = 4;
+
+int EnvironmentBundle::write(const char *file_name, const TextureData *entries)
+{
+    FILE *file = fopen(file_name, "wb");
+    if (!file) {
+        nm_log::log(LOG_ERROR, "failed to open file \"%s\" for writing\n", file_name);
+
+        return EXIT_FAILURE;
+    }
+
+    uint32_t entry_count = ENTRY_COUNT;
+    uint64_t offsets[ENTRY_COUNT] = {};
+
+    // write the table once to reserve its space, it is rewritten after the offsets are known
+    fwrite(MAGIC, sizeof(MAGIC), 1, file);
+    fwrite(&VERSION, sizeof(VERSION), 1, file);
+    fwrite(&entry_count, sizeof(entry_count), 1, file);
+    long table_offset = ftell(file);
+    fwrite(offsets, sizeof(offsets), 1, file);
+
+    for (uint32_t i = 0; i < ENTRY_COUNT; i++) {
+        offsets[i] = (uint64_t) ftell(file);
+        if (TextureData::write(&entries[i], file) == EXIT_FAILURE) {
+            nm_log::log(LOG_ERROR, "failed to write entry %d of \"%s\"\n", i, file_name);
+            fclose(file);
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    fseek(file, table_offset, SEEK_SET);
+    fwrite(offsets, sizeof(offsets), 1, file);
+    fclose(file);
+
+    return EXIT_SUCCESS;
+}
+
+int EnvironmentBundle::read(const char *file_name, Entry entry, TextureData *texture_data)
+{
+    FILE *file = fopen(file_name, "rb");
+    if (!file) {
+        // not an error, the caller may fall back to generating the entry
+        nm_log::log(LOG_INFO, "environment bundle \"%s\" not found\n", file_name);
+
+        return EXIT_FAILURE;
+    }
+
+    char magic[4];
+    uint32_t version, entry_count;
+    uint64_t offsets[ENTRY_COUNT];
+    if (fread(magic, sizeof(magic), 1, file) != 1 ||
+        fread(&version, sizeof(version), 1, file) != 1 ||
+        fread(&entry_count, sizeof(entry_count), 1, file) != 1 ||
+        memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION || entry_count != ENTRY_COUNT ||
+        fread(offsets, sizeof(offsets), 1, file) != 1) {
+        nm_log::log(LOG_WARN, "\"%s\" is not a valid version %d environment bundle\n", file_name, VERSION);
+        fclose(file);
+
+        return EXIT_FAILURE;
+    }
+
+    // entries follow the table in order, the offset of {entry} has to lie before that of the next or the end
+    long table_end = ftell(file);
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    uint64_t entry_end = entry + 1 < ENTRY_COUNT ? offsets[entry + 1] : (uint64_t) file_size;
+    if (table_end < 0 || file_size < 0 || offsets[entry] < (uint64_t) table_end || offsets[entry] >= entry_end ||
+        entry_end > (uint64_t) file_size || fseek(file, (long) offsets[entry], SEEK_SET) != 0) {
+        nm_log::log(LOG_WARN, "\"%s\" has an invalid offset for entry %d\n", file_name, entry);
+        fclose(file);
+
+        return EXIT_FAILURE;
+    }
+
+    int rval = TextureData::read(texture_data, file);
+    fclose(file);
+
+    return rval;
+}
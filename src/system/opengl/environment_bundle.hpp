@@ -0,0 +1,32 @@
+#ifndef SYSTEM_ENVIRONMENT_BUNDLE_HPP
+#define SYSTEM_ENVIRONMENT_BUNDLE_HPP
+
+#include <cstdint>
+
+#include "texture_data.hpp"
+
+/**
+ * Binary file holding every texture derived from one HDR environment, as written by {pbr_bake}.
+ * Layout: magic, version, entry count, a table with the file offset of each entry, then one {TextureData} per entry. */
+struct EnvironmentBundle {
+    enum Entry {
+        CUBEMAP,
+        /** Spherical harmonics coefficients, stored as written by {SphericalHarmonics::write_texture_data}. */
+        IRRADIANCE,
+        PRE_FILTER,
+        /** Light removed from the environment before converting it, stored as by {DominantLight::write_texture_data}. */
+        DOMINANT_LIGHT,
+        ENTRY_COUNT
+    };
+
+    /** Bumped whenever the layout or the generation of the entries changes, older bundles are rejected. */
+    static const uint32_t VERSION;
+
+    /** Writes all {ENTRY_COUNT} entries of {entries} to {file_name}. */
+    static int write(const char *file_name, const TextureData *entries);
+
+    /** Reads only {entry} from {file_name}, without reading the other entries. */
+    static int read(const char *file_name, Entry entry, TextureData *texture_data);
+};
+
+#endif //SYSTEM_ENVIRONMENT_BUNDLE_HPP
@@ -0,0 +1,124 @@
+#include "ibl_tier.hpp"
+
+#include <cstring>
+
+#include "texture.hpp"
+#include "texture_data.hpp"
+#include "../../util/nm_log.hpp"
+
+/**
+ * The packed formats take 4 bytes per texel instead of 6. {GL_RGB9_E5} keeps 9 bits of mantissa per channel, more
+ * than the 6 and 5 of {GL_R11F_G11F_B10F}, so it is used for the cubemap which is sharp and seen directly. */
+const IblTier IblTier::TIERS[LEVEL_COUNT] = {
+        {"low", 256, GL_RGB9_E5, 64, GL_R11F_G11F_B10F},
+        {"medium", 512, GL_RGB9_E5, 128, GL_R11F_G11F_B10F},
+        {"high", 1024, GL_RGB16F, 256, GL_RGB16F}};
+
+const char *const IblTier::LAYOUT_NAMES[LAYOUT_COUNT] = {"cubemap", "octahedral"};
+
+static IblTier::Level selected = IblTier::DEFAULT;
+
+static IblTier::Layout selected_layout = IblTier::DEFAULT_LAYOUT;
+
+/**
+ * Returns the number of bytes of an environment texture in the selected layout with faces of {face_resolution} and
+ * {level_count} levels, 0 for the full mip chain. */
+static size_t get_size(uint32_t face_resolution, GLenum internal_format, uint32_t level_count)
+{
+    uint32_t resolution = IblTier::get_layout_resolution(face_resolution);
+    GLenum texture_type = IblTier::get_texture_type();
+    uint32_t face_count = texture_type == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+    TextureData data{texture_type, internal_format, 0, 0, resolution, resolution, level_count, face_count, {}};
+    TextureData::get_transfer_format(internal_format, &data.format, &data.type);
+    if (level_count == 0) {
+        for (uint32_t size = resolution; size > 0; size >>= 1) {
+            data.level_count++;
+        }
+    }
+
+    size_t size = 0;
+    for (uint32_t level = 0; level < data.level_count; level++) {
+        size += data.get_level_size(level) * data.face_count;
+    }
+
+    return size;
+}
+
+void IblTier::select(Level level)
+{
+    selected = level;
+
+    const IblTier *tier = get();
+    uint32_t cubemap_resolution = get_layout_resolution(tier->cubemap_resolution);
+    uint32_t pre_filter_resolution = get_layout_resolution(tier->pre_filter_resolution);
+    nm_log::log(LOG_INFO, "IBL tier \"%s\" in %s layout: %dx%d cubemap of %.2f MiB, %dx%d pre-filter cubemap of "
+                          "%.2f MiB\n",
+                tier->name, LAYOUT_NAMES[selected_layout], cubemap_resolution, cubemap_resolution,
+                (double) tier->get_cubemap_size() / (1024. * 1024.), pre_filter_resolution, pre_filter_resolution,
+                (double) tier->get_pre_filter_size() / (1024. * 1024.));
+}
+
+const IblTier *IblTier::get()
+{
+    return &TIERS[selected];
+}
+
+int IblTier::find(const char *name, Level *level)
+{
+    for (uint32_t i = 0; i < LEVEL_COUNT; i++) {
+        if (strcmp(TIERS[i].name, name) == 0) {
+            *level = static_cast<Level>(i);
+
+            return EXIT_SUCCESS;
+        }
+    }
+
+    nm_log::log(LOG_ERROR, "\"%s\" is not an IBL tier, expected low, medium, or high\n", name);
+
+    return EXIT_FAILURE;
+}
+
+void IblTier::select_layout(Layout layout)
+{
+    selected_layout = layout;
+}
+
+IblTier::Layout IblTier::get_layout()
+{
+    return selected_layout;
+}
+
+int IblTier::find_layout(const char *name, Layout *layout)
+{
+    for (uint32_t i = 0; i < LAYOUT_COUNT; i++) {
+        if (strcmp(LAYOUT_NAMES[i], name) == 0) {
+            *layout = static_cast<Layout>(i);
+
+            return EXIT_SUCCESS;
+        }
+    }
+
+    nm_log::log(LOG_ERROR, "\"%s\" is not an IBL layout, expected cubemap or octahedral\n", name);
+
+    return EXIT_FAILURE;
+}
+
+GLenum IblTier::get_texture_type()
+{
+    return selected_layout == OCTAHEDRAL ? GL_TEXTURE_2D : GL_TEXTURE_CUBE_MAP;
+}
+
+uint32_t IblTier::get_layout_resolution(uint32_t face_resolution)
+{
+    return selected_layout == OCTAHEDRAL ? 2 * face_resolution : face_resolution;
+}
+
+size_t IblTier::get_cubemap_size() const
+{
+    return get_size(cubemap_resolution, cubemap_format, 0);
+}
+
+size_t IblTier::get_pre_filter_size() const
+{
+    return get_size(pre_filter_resolution, pre_filter_format, Texture::PRE_FILTER_LEVEL_COUNT);
+}
@@ -0,0 +1,78 @@
+#ifndef SYSTEM_IBL_TIER_HPP
+#define SYSTEM_IBL_TIER_HPP
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <glad/glad.h>
+
+/**
+ * Resolutions and storage formats of the environment textures. A single tier and layout are selected at startup, before
+ * any environment is created, since cached and baked textures only hold the tier and layout they were made for. */
+struct IblTier {
+    enum Level {
+        LOW,
+        MEDIUM,
+        HIGH,
+        LEVEL_COUNT
+    };
+
+    /** How the cubemap and pre-filter cubemap of an environment are stored, independent of the tier. */
+    enum Layout {
+        /** A {GL_TEXTURE_CUBE_MAP} with faces of the resolutions of the tier. */
+        CUBEMAP,
+        /**
+         * A {GL_TEXTURE_2D} holding the octahedral map of the sphere, of twice the face resolutions of the tier such
+         * that it has two thirds of the texels. A level is a single upload and a single attachment. The upper
+         * hemisphere (+Y) is mapped to the inner diamond, see {CubemapConverter::get_octahedral_direction}. */
+        OCTAHEDRAL,
+        LAYOUT_COUNT
+    };
+
+    const char *name;
+    /** Resolution per face of the cubemap converted from the equirectangular image, and its sized format. */
+    uint32_t cubemap_resolution;
+    GLenum cubemap_format;
+    /**
+     * Resolution per face of level 0 of the pre-filter cubemap, and its sized format. It is rendered to, so the
+     * format must be color-renderable, which {GL_RGB9_E5} is not. */
+    uint32_t pre_filter_resolution;
+    GLenum pre_filter_format;
+
+    static const IblTier TIERS[LEVEL_COUNT];
+
+    static const Level DEFAULT = MEDIUM;
+
+    static const char *const LAYOUT_NAMES[LAYOUT_COUNT];
+
+    static const Layout DEFAULT_LAYOUT = CUBEMAP;
+
+    /** Selects {level} for all environments created after, and logs its memory footprint. */
+    static void select(Level level);
+
+    static const IblTier *get();
+
+    /** Finds the level with {name}, as given on the command line. */
+    static int find(const char *name, Level *level);
+
+    /** Selects {layout} for all environments created after, should be called before {select} which logs it. */
+    static void select_layout(Layout layout);
+
+    static Layout get_layout();
+
+    /** Finds the layout with {name}, as given on the command line. */
+    static int find_layout(const char *name, Layout *layout);
+
+    /** Returns the texture type of environment textures in the selected layout. */
+    static GLenum get_texture_type();
+
+    /** Returns the width and height of level 0 of an environment texture with faces of {face_resolution}. */
+    static uint32_t get_layout_resolution(uint32_t face_resolution);
+
+    /** Returns the number of bytes of the cubemap with its full mip chain, and of the pre-filter cubemap. */
+    size_t get_cubemap_size() const;
+
+    size_t get_pre_filter_size() const;
+};
+
+#endif //SYSTEM_IBL_TIER_HPP
@@ -0,0 +1,76 @@
+#include "pixel_buffer_ring.hpp"
+
+#include "../../util/nm_log.hpp"
+
+int PixelBufferRing::create_ring(PixelBufferRing *ring, size_t buffer_size)
+{
+    ring->buffer_size = buffer_size;
+    ring->next = 0;
+
+    glGenBuffers(BUFFER_COUNT, ring->buffers);
+    for (uint32_t i = 0; i < BUFFER_COUNT; i++) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring->buffers[i]);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, buffer_size, nullptr, GL_STREAM_DRAW);
+        ring->fences[i] = nullptr;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    return EXIT_SUCCESS;
+}
+
+void PixelBufferRing::delete_ring(PixelBufferRing *ring)
+{
+    for (uint32_t i = 0; i < BUFFER_COUNT; i++) {
+        if (ring->fences[i]) {
+            glDeleteSync(ring->fences[i]);
+            ring->fences[i] = nullptr;
+        }
+    }
+
+    // deletion is deferred by the driver until pending uploads have completed
+    glDeleteBuffers(BUFFER_COUNT, ring->buffers);
+}
+
+uint8_t *PixelBufferRing::map_next(PixelBufferRing *ring)
+{
+    GLsync &fence = ring->fences[ring->next];
+    if (fence) {
+        // poll without waiting, the buffer is retried next frame
+        GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            return nullptr;
+        } else if (status == GL_WAIT_FAILED) {
+            nm_log::log(LOG_ERROR, "failed to wait for pixel buffer fence\n");
+
+            return nullptr;
+        }
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring->buffers[ring->next]);
+    void *pixels = glMapBufferRange(
+            GL_PIXEL_UNPACK_BUFFER, 0, ring->buffer_size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!pixels) {
+        nm_log::log(LOG_ERROR, "failed to map pixel buffer\n");
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        return nullptr;
+    }
+
+    return (uint8_t *) pixels;
+}
+
+void PixelBufferRing::unmap(PixelBufferRing *)
+{
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+}
+
+void PixelBufferRing::fence(PixelBufferRing *ring)
+{
+    ring->fences[ring->next] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    ring->next = (ring->next + 1) % BUFFER_COUNT;
+}
@@ -0,0 +1,39 @@
+#ifndef SYSTEM_PIXEL_BUFFER_RING_HPP
+#define SYSTEM_PIXEL_BUFFER_RING_HPP
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <glad/glad.h>
+
+/**
+ * Ring of pixel unpack buffers used to upload texture data without stalling on the GPU. Every buffer is guarded by a
+ * fence which is signaled once the GPU finished reading from it, a buffer is only written again after that. */
+struct PixelBufferRing {
+    static const uint32_t BUFFER_COUNT = 3;
+
+    GLuint buffers[BUFFER_COUNT];
+    /** Fence inserted after the last upload sourced from the buffer, nullptr if there is none. */
+    GLsync fences[BUFFER_COUNT];
+    /** Size in bytes of every buffer. */
+    size_t buffer_size;
+    /** Index of the buffer to use next. */
+    uint32_t next;
+
+    static int create_ring(PixelBufferRing *ring, size_t buffer_size);
+
+    static void delete_ring(PixelBufferRing *ring);
+
+    /**
+     * Binds the next buffer to {GL_PIXEL_UNPACK_BUFFER} and maps it for writing. Returns nullptr without binding if
+     * the GPU is still reading from it, this never waits. */
+    static uint8_t *map_next(PixelBufferRing *ring);
+
+    /** Unmaps the buffer returned by {map_next}, it stays bound such that the next upload sources from it. */
+    static void unmap(PixelBufferRing *ring);
+
+    /** Fences the uploads issued since {unmap} and unbinds the buffer, moving on to the next buffer. */
+    static void fence(PixelBufferRing *ring);
+};
+
+#endif //SYSTEM_PIXEL_BUFFER_RING_HPP
@@ -0,0 +1,375 @@
+#include "radiance_decoder.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+
+#include <emmintrin.h>
+
+#define RADIANCE_DECODER_SSE2
+
+#if defined(__GNUC__)
+
+#include <immintrin.h>
+
+// compiled for AVX2 and F16C regardless of the target, only called if the processor supports them
+#define RADIANCE_DECODER_AVX2
+
+#endif
+#endif
+
+#include "../../util/nm_log.hpp"
+
+/** Largest finite half float, larger values are clamped to it like {TextureData::float_to_half} does. */
+static const float HALF_MAX = 65504.f;
+
+/**
+ * A value is its 8 bit mantissa times 2 to the power of its exponent minus 128 + 8. Exponents below 10 only produce
+ * values below the smallest normal float, which are flushed to zero. */
+static const int32_t EXPONENT_BIAS = 128 + 8;
+static const int32_t MIN_EXPONENT = 10;
+
+/** Returns the scale of exponent {e}, building the float directly from its bits. */
+static float get_scale(uint8_t e)
+{
+    if (e < MIN_EXPONENT) {
+        return 0.f;
+    }
+
+    uint32_t bits = (uint32_t) (e - EXPONENT_BIAS + 127) << 23;
+    float scale;
+    memcpy(&scale, &bits, sizeof(scale));
+
+    return scale;
+}
+
+/** Converts pixels {first} up to {width} of the planar scanline {rgbe} to interleaved RGB {out} of {type}. */
+static void convert_pixels(const uint8_t *rgbe, uint32_t width, uint32_t first, GLenum type, uint8_t *out)
+{
+    for (uint32_t x = first; x < width; x++) {
+        float scale = get_scale(rgbe[3 * width + x]);
+        for (uint32_t c = 0; c < 3; c++) {
+            float value = (float) rgbe[c * width + x] * scale;
+            if (type == GL_HALF_FLOAT) {
+                uint16_t half = TextureData::float_to_half(value);
+                memcpy(out + ((size_t) x * 3 + c) * sizeof(half), &half, sizeof(half));
+            } else {
+                memcpy(out + ((size_t) x * 3 + c) * sizeof(value), &value, sizeof(value));
+            }
+        }
+    }
+}
+
+typedef uint32_t (*ConvertFunction)(const uint8_t *rgbe, uint32_t width, GLenum type, uint8_t *out);
+
+#ifdef RADIANCE_DECODER_SSE2
+
+/** Interleaves four pixels of planar {r}, {g} and {b} into {out}. */
+static inline void interleave_rgb(__m128 r, __m128 g, __m128 b, __m128 *out)
+{
+    __m128 rg_lo = _mm_unpacklo_ps(r, g);
+    __m128 rg_hi = _mm_unpackhi_ps(r, g);
+    out[0] = _mm_shuffle_ps(rg_lo, _mm_unpacklo_ps(b, r), _MM_SHUFFLE(3, 0, 1, 0));
+    out[1] = _mm_shuffle_ps(_mm_unpacklo_ps(g, b), rg_hi, _MM_SHUFFLE(1, 0, 3, 2));
+    __m128 b_rg = _mm_shuffle_ps(_mm_unpackhi_ps(b, r), rg_hi, _MM_SHUFFLE(3, 2, 2, 0));
+    out[2] = _mm_shuffle_ps(b_rg, b_rg, _MM_SHUFFLE(1, 3, 2, 0));
+}
+
+/** Loads four bytes as 32 bit integers. */
+static inline __m128i load_bytes(const uint8_t *bytes)
+{
+    int32_t packed;
+    memcpy(&packed, bytes, sizeof(packed));
+    __m128i zero = _mm_setzero_si128();
+
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+}
+
+/** Returns the scales of four exponents, see {get_scale}. */
+static inline __m128 get_scales(__m128i e)
+{
+    __m128i is_normal = _mm_cmpgt_epi32(e, _mm_set1_epi32(MIN_EXPONENT - 1));
+    __m128i bits = _mm_slli_epi32(_mm_add_epi32(e, _mm_set1_epi32(127 - EXPONENT_BIAS)), 23);
+
+    return _mm_castsi128_ps(_mm_and_si128(bits, is_normal));
+}
+
+/** Four non-negative values of {TextureData::float_to_half} in the low half of the result. */
+static inline __m128i to_halves(__m128 values)
+{
+    const __m128i DENORM_MAGIC_BITS = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+
+    values = _mm_min_ps(values, _mm_set1_ps(HALF_MAX));
+    __m128i bits = _mm_castps_si128(values);
+
+    __m128i mantissa_odd = _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(1));
+    __m128i normal = _mm_add_epi32(bits, _mm_set1_epi32((int32_t) ((uint32_t) (15 - 127) << 23) + 0xfff));
+    normal = _mm_srli_epi32(_mm_add_epi32(normal, mantissa_odd), 13);
+
+    __m128i subnormal = _mm_sub_epi32(
+            _mm_castps_si128(_mm_add_ps(values, _mm_castsi128_ps(DENORM_MAGIC_BITS))), DENORM_MAGIC_BITS);
+    __m128i is_subnormal = _mm_cmplt_epi32(bits, _mm_set1_epi32(113 << 23));
+
+    __m128i halves = _mm_or_si128(_mm_and_si128(is_subnormal, subnormal), _mm_andnot_si128(is_subnormal, normal));
+
+    // all halves are positive and fit a signed 16 bit integer
+    return _mm_packs_epi32(halves, halves);
+}
+
+/** Converts pixels in groups of four, returns the number of pixels converted. */
+static uint32_t convert_pixels_sse2(const uint8_t *rgbe, uint32_t width, GLenum type, uint8_t *out)
+{
+    uint32_t x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128 scale = get_scales(load_bytes(rgbe + 3 * width + x));
+        __m128 r = _mm_mul_ps(_mm_cvtepi32_ps(load_bytes(rgbe + x)), scale);
+        __m128 g = _mm_mul_ps(_mm_cvtepi32_ps(load_bytes(rgbe + width + x)), scale);
+        __m128 b = _mm_mul_ps(_mm_cvtepi32_ps(load_bytes(rgbe + 2 * width + x)), scale);
+
+        __m128 rgb[3];
+        interleave_rgb(r, g, b, rgb);
+        if (type == GL_HALF_FLOAT) {
+            for (int i = 0; i < 3; i++) {
+                _mm_storel_epi64((__m128i *) (out + ((size_t) x * 3 + i * 4) * 2), to_halves(rgb[i]));
+            }
+        } else {
+            for (int i = 0; i < 3; i++) {
+                _mm_storeu_ps((float *) (out + ((size_t) x * 3 + i * 4) * 4), rgb[i]);
+            }
+        }
+    }
+
+    return x;
+}
+
+#endif
+
+#ifdef RADIANCE_DECODER_AVX2
+
+/** Converts pixels in groups of eight, using the conversion instructions of F16C for half floats. */
+__attribute__((target("avx2,f16c")))
+static uint32_t convert_pixels_avx2(const uint8_t *rgbe, uint32_t width, GLenum type, uint8_t *out)
+{
+    uint32_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256i e = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) (rgbe + 3 * width + x)));
+        __m256i is_normal = _mm256_cmpgt_epi32(e, _mm256_set1_epi32(MIN_EXPONENT - 1));
+        __m256i bits = _mm256_slli_epi32(_mm256_add_epi32(e, _mm256_set1_epi32(127 - EXPONENT_BIAS)), 23);
+        __m256 scale = _mm256_castsi256_ps(_mm256_and_si256(bits, is_normal));
+
+        __m256 channels[3];
+        for (uint32_t c = 0; c < 3; c++) {
+            __m256i values = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) (rgbe + c * width + x)));
+            channels[c] = _mm256_mul_ps(_mm256_cvtepi32_ps(values), scale);
+        }
+
+        // interleave per four pixels, lanes of 256 bit shuffles do not cross
+        for (int half = 0; half < 2; half++) {
+            __m128 rgb[3];
+            if (half == 0) {
+                interleave_rgb(_mm256_castps256_ps128(channels[0]), _mm256_castps256_ps128(channels[1]),
+                               _mm256_castps256_ps128(channels[2]), rgb);
+            } else {
+                interleave_rgb(_mm256_extractf128_ps(channels[0], 1), _mm256_extractf128_ps(channels[1], 1),
+                               _mm256_extractf128_ps(channels[2], 1), rgb);
+            }
+
+            size_t offset = (size_t) (x + half * 4) * 3;
+            if (type == GL_HALF_FLOAT) {
+                for (int i = 0; i < 3; i++) {
+                    __m128 clamped = _mm_min_ps(rgb[i], _mm_set1_ps(HALF_MAX));
+                    _mm_storel_epi64((__m128i *) (out + (offset + i * 4) * 2),
+                                     _mm_cvtps_ph(clamped, _MM_FROUND_TO_NEAREST_INT));
+                }
+            } else {
+                for (int i = 0; i < 3; i++) {
+                    _mm_storeu_ps((float *) (out + (offset + i * 4) * 4), rgb[i]);
+                }
+            }
+        }
+    }
+
+    return x;
+}
+
+#endif
+
+/** Picks the widest conversion the processor supports. */
+static ConvertFunction get_convert_function()
+{
+#ifdef RADIANCE_DECODER_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c")) {
+        return &convert_pixels_avx2;
+    }
+#endif
+#ifdef RADIANCE_DECODER_SSE2
+    return &convert_pixels_sse2;
+#else
+    return nullptr;
+#endif
+}
+
+/** Reads a line of at most {max_length} characters into {line} and moves {position} past it. */
+static bool read_line(const char *memory, size_t size, size_t *position, char *line, size_t max_length)
+{
+    size_t length = 0;
+    while (*position < size && memory[*position] != '\n') {
+        if (length < max_length) {
+            line[length++] = memory[*position];
+        }
+        (*position)++;
+    }
+    line[length] = '\0';
+    if (*position >= size) {
+        return false;
+    }
+    (*position)++;
+
+    return true;
+}
+
+/**
+ * Decodes the run length encoded scanline at {position} into planar {rgbe}, which holds each channel of all pixels
+ * in turn. Runs are a count above 128 followed by the byte to repeat, other counts are followed by as many bytes. */
+static int decode_scanline(
+        const uint8_t *memory, size_t size, size_t *position, uint32_t width, uint8_t *rgbe)
+{
+    if (size - *position < 4 || memory[*position] != 2 || memory[*position + 1] != 2 ||
+        (uint32_t) (memory[*position + 2] << 8 | memory[*position + 3]) != width) {
+        nm_log::log(LOG_ERROR, "invalid run length encoded scanline\n");
+
+        return EXIT_FAILURE;
+    }
+    *position += 4;
+
+    for (uint32_t c = 0; c < 4; c++) {
+        uint8_t *channel = rgbe + (size_t) c * width;
+        uint32_t x = 0;
+        while (x < width) {
+            if (*position >= size) {
+                nm_log::log(LOG_ERROR, "run length encoded scanline is truncated\n");
+
+                return EXIT_FAILURE;
+            }
+            uint32_t count = memory[(*position)++];
+            bool is_run = count > 128;
+            if (is_run) {
+                count -= 128;
+            }
+            if (count == 0 || count > width - x || size - *position < (is_run ? 1 : count)) {
+                nm_log::log(LOG_ERROR, "invalid run in run length encoded scanline\n");
+
+                return EXIT_FAILURE;
+            }
+            if (is_run) {
+                memset(channel + x, memory[(*position)++], count);
+            } else {
+                memcpy(channel + x, memory + *position, count);
+                *position += count;
+            }
+            x += count;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+bool RadianceDecoder::is_radiance(const char *memory, size_t size)
+{
+    static const char *const SIGNATURES[] = {"#?RADIANCE\n", "#?RGBE\n"};
+    for (const char *signature : SIGNATURES) {
+        size_t length = strlen(signature);
+        if (size >= length && memcmp(memory, signature, length) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int RadianceDecoder::decode(TextureData *data, const char *memory, size_t size, GLenum type)
+{
+    if (!is_radiance(memory, size) || (type != GL_FLOAT && type != GL_HALF_FLOAT)) {
+        nm_log::log(LOG_ERROR, "not a Radiance HDR image or unsupported output type\n");
+
+        return EXIT_FAILURE;
+    }
+
+    // header lines up to an empty line, only the format matters
+    const size_t MAX_LINE_LENGTH = 127;
+    char line[MAX_LINE_LENGTH + 1];
+    size_t position = 0;
+    while (true) {
+        if (!read_line(memory, size, &position, line, MAX_LINE_LENGTH)) {
+            nm_log::log(LOG_ERROR, "Radiance HDR header is truncated\n");
+
+            return EXIT_FAILURE;
+        }
+        if (line[0] == '\0') {
+            break;
+        }
+        if (strncmp(line, "FORMAT=", 7) == 0 && strcmp(line, "FORMAT=32-bit_rle_rgbe") != 0) {
+            nm_log::log(LOG_ERROR, "unsupported Radiance HDR format \"%s\"\n", line + 7);
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    // only the standard orientation is supported, rows from top to bottom with pixels from left to right
+    int height, width;
+    if (!read_line(memory, size, &position, line, MAX_LINE_LENGTH) ||
+        sscanf(line, "-Y %d +X %d", &height, &width) != 2 || width <= 0 || height <= 0) {
+        nm_log::log(LOG_ERROR, "unsupported Radiance HDR resolution \"%s\"\n", line);
+
+        return EXIT_FAILURE;
+    }
+
+    data->texture_type = GL_TEXTURE_2D;
+    data->internal_format = GL_RGB;
+    data->format = GL_RGB;
+    data->type = type;
+    data->width = width;
+    data->height = height;
+    data->level_count = 1;
+    data->face_count = 1;
+    data->data.resize(data->get_level_size(0));
+
+    // scanlines are run length encoded unless they are too narrow or too wide, or the first one is not
+    const auto *bytes = (const uint8_t *) memory;
+    bool is_encoded = width >= 8 && width < 32768 && size - position >= 4 && bytes[position] == 2 &&
+                      bytes[position + 1] == 2 && !(bytes[position + 2] & 0x80);
+    if (!is_encoded && size - position < (size_t) width * height * 4) {
+        nm_log::log(LOG_ERROR, "Radiance HDR pixels are truncated\n");
+
+        return EXIT_FAILURE;
+    }
+
+    static const ConvertFunction CONVERT = get_convert_function();
+
+    std::vector<uint8_t> rgbe((size_t) width * 4);
+    size_t row_size = data->get_row_size(0);
+    for (uint32_t y = 0; y < (uint32_t) height; y++) {
+        if (is_encoded) {
+            if (decode_scanline(bytes, size, &position, width, rgbe.data()) == EXIT_FAILURE) {
+                return EXIT_FAILURE;
+            }
+        } else {
+            // deinterleave such that both layouts are converted alike
+            for (uint32_t x = 0; x < (uint32_t) width; x++) {
+                for (uint32_t c = 0; c < 4; c++) {
+                    rgbe[(size_t) c * width + x] = bytes[position++];
+                }
+            }
+        }
+
+        // NB: first row is the top one, flip it like stbi does on load
+        uint8_t *out = data->data.data() + (size_t) (height - 1 - y) * row_size;
+        uint32_t converted = CONVERT ? CONVERT(rgbe.data(), width, type, out) : 0;
+        convert_pixels(rgbe.data(), width, converted, type, out);
+    }
+
+    return EXIT_SUCCESS;
+}
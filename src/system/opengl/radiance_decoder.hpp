@@ -0,0 +1,25 @@
+#ifndef SYSTEM_RADIANCE_DECODER_HPP
+#define SYSTEM_RADIANCE_DECODER_HPP
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "texture_data.hpp"
+
+/**
+ * Decoder of Radiance HDR (RGBE) images, the format of the environment maps. Replaces the scalar conversion of stbi
+ * with one that expands the shared exponents of 4 (SSE2) or 8 (AVX2) pixels at once, and that can write half floats
+ * directly such that the decoded image and its upload are half the size. */
+struct RadianceDecoder {
+    /** Whether {size} bytes of {memory} start with the signature of a Radiance HDR image. */
+    static bool is_radiance(const char *memory, size_t size);
+
+    /**
+     * Decodes the image in {size} bytes of {memory} into a single level of {data} with RGB channels of {type}, which
+     * is {GL_FLOAT} or {GL_HALF_FLOAT}. Rows are flipped such that the first row is the bottom one, like images
+     * decoded by {Texture}. Half floats are clamped to the largest finite half float, and values too small to be a
+     * normal float are flushed to zero. Does not touch OpenGL state and may be called from any thread. */
+    static int decode(TextureData *data, const char *memory, size_t size, GLenum type);
+};
+
+#endif //SYSTEM_RADIANCE_DECODER_HPP
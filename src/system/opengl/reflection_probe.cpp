@@ -0,0 +1,88 @@
+#include "reflection_probe.hpp"
+
+#include "../../util/nm_log.hpp"
+
+/** Texture units of the capture and pre-filter, the same as those of the environment they stand in for. */
+static const uint32_t CAPTURE_TEXTURE_UNIT = 0;
+static const uint32_t PRE_FILTER_TEXTURE_UNIT = 7;
+
+int ReflectionProbe::create_probe(ReflectionProbe *probe, glm::vec3 position, float radius)
+{
+    probe->position = position;
+    probe->radius = radius;
+    probe->dirty = true;
+    probe->ready = false;
+    probe->next_step = STEP_COUNT;
+    probe->environment_version = 0;
+
+    /** setup cubemap to capture to, RGBA16F since RGB16F is not required to be renderable */
+    glGenTextures(1, &probe->capture.tex_id);
+    probe->capture.texture_type = GL_TEXTURE_CUBE_MAP;
+    probe->capture.texture_unit = GL_TEXTURE0 + CAPTURE_TEXTURE_UNIT;
+    glBindTexture(GL_TEXTURE_CUBE_MAP, probe->capture.tex_id);
+    for (uint32_t face = 0; face < 6; face++) {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA16F, CAPTURE_RESOLUTION, CAPTURE_RESOLUTION, 0,
+                     GL_RGBA, GL_FLOAT, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // allocate the mip chain, it is filled after every capture
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    /** setup framebuffer, the depth buffer is shared by all faces since they are captured one at a time */
+    glGenFramebuffers(1, &probe->capture_fbo);
+    glGenRenderbuffers(1, &probe->capture_depth);
+    glBindFramebuffer(GL_FRAMEBUFFER, probe->capture_fbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, probe->capture_depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, CAPTURE_RESOLUTION, CAPTURE_RESOLUTION);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, probe->capture_depth);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X,
+                           probe->capture.tex_id, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        nm_log::log(LOG_ERROR, "reflection probe framebuffer is not complete\n");
+        glDeleteRenderbuffers(1, &probe->capture_depth);
+        glDeleteFramebuffers(1, &probe->capture_fbo);
+        Texture::delete_tex(&probe->capture);
+
+        return EXIT_FAILURE;
+    }
+
+    // the pass is kept, such that recaptures do not build the sample table and shader again
+    if (Texture::begin_pre_filter(
+            &probe->pass, &probe->pre_filter, &probe->capture, PRE_FILTER_TEXTURE_UNIT, PRE_FILTER_RESOLUTION,
+            GL_R11F_G11F_B10F) == EXIT_FAILURE) {
+        glDeleteRenderbuffers(1, &probe->capture_depth);
+        glDeleteFramebuffers(1, &probe->capture_fbo);
+        Texture::delete_tex(&probe->capture);
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+void ReflectionProbe::delete_probe(ReflectionProbe *probe)
+{
+    Texture::end_pre_filter(&probe->pass);
+    Texture::delete_tex(&probe->pre_filter);
+    glDeleteRenderbuffers(1, &probe->capture_depth);
+    glDeleteFramebuffers(1, &probe->capture_fbo);
+    Texture::delete_tex(&probe->capture);
+}
+
+bool ReflectionProbe::contains(const ReflectionProbe *probe, glm::vec3 point)
+{
+    return glm::length(point - probe->position) <= probe->radius;
+}
+
+bool ReflectionProbe::overlaps(const ReflectionProbe *probe, glm::vec3 center, float radius)
+{
+    return glm::length(center - probe->position) <= probe->radius + radius;
+}
@@ -0,0 +1,59 @@
+#ifndef SYSTEM_REFLECTION_PROBE_HPP
+#define SYSTEM_REFLECTION_PROBE_HPP
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "texture.hpp"
+
+/**
+ * A point the scene is captured from into a small cubemap, which is pre-filtered like the environment such that objects
+ * within {radius} reflect their surroundings instead of only the distant environment. A capture is spread over
+ * {STEP_COUNT} frames by {Renderer::update_reflection_probes}: a face is captured per step, after which a level of
+ * {pre_filter} is rendered per step by the pass of {Texture::begin_pre_filter}, which is kept for the lifetime of the
+ * probe. */
+struct ReflectionProbe {
+    /** Resolution of the faces of {capture}, and of the first level of {pre_filter}. */
+    static const uint32_t CAPTURE_RESOLUTION = 128;
+    static const uint32_t PRE_FILTER_RESOLUTION = 64;
+
+    /** Steps of a capture: one per face, then one per level of {pre_filter}. */
+    static const uint32_t FACE_STEP_COUNT = 6;
+    static const uint32_t STEP_COUNT = FACE_STEP_COUNT + Texture::PRE_FILTER_LEVEL_COUNT;
+
+    glm::vec3 position;
+    float radius;
+
+    /** Linear radiance around {position}, mipmapped since the pre-filter samples coarser levels. */
+    Texture capture;
+    GLuint capture_fbo;
+    GLuint capture_depth;
+
+    Texture pre_filter;
+    PreFilterPass pass;
+
+    /** Whether something within {radius} changed since the current capture started, such that it is captured again. */
+    bool dirty;
+    /** Whether {pre_filter} has been completed at least once, objects reflect the environment until then. */
+    bool ready;
+    /** Next step of the capture in progress, {STEP_COUNT} if none is. */
+    uint32_t next_step;
+    /** {Renderer::environment_version} the capture in progress or last completed capture started with. */
+    uint32_t environment_version;
+
+    /** Creates {probe} at {position} without a capture, its first capture is scheduled right away. */
+    static int create_probe(ReflectionProbe *probe, glm::vec3 position, float radius);
+
+    static void delete_probe(ReflectionProbe *probe);
+
+    /** Whether {point} lies within the radius of {probe}. */
+    static bool contains(const ReflectionProbe *probe, glm::vec3 point);
+
+    /** Whether any part of the sphere at {center} with {radius} lies within the radius of {probe}. */
+    static bool overlaps(const ReflectionProbe *probe, glm::vec3 center, float radius);
+};
+
+#endif //SYSTEM_REFLECTION_PROBE_HPP
@@ -1,5 +1,9 @@
 #include "shader.hpp"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
 #include <glm/gtc/type_ptr.hpp>
 
 #include "../../util/nm_log.hpp"
@@ -10,32 +14,53 @@ int32_t ShaderProgram::create_shader_program(
         const char *frag_shader_text, size_t frag_shader_size
 )
 {
-    // shaders
-    Shader vert_shader{};
-    Shader frag_shader{};
-
-    // create vertex shader
-    if (Shader::create_shader(&vert_shader, vert_shader_text, vert_shader_size, true) == EXIT_FAILURE) {
-        nm_log::log(LOG_ERROR, "vert shader creation failed\n");
+    return create_shader_program(
+            shader_program, vert_shader_text, vert_shader_size, nullptr, 0, frag_shader_text, frag_shader_size,
+            nullptr, nullptr, 0);
+}
 
-        return EXIT_FAILURE;
-    }
+int32_t ShaderProgram::create_shader_program(
+        ShaderProgram *shader_program,
+        const char *vert_shader_text, size_t vert_shader_size,
+        const char *geom_shader_text, size_t geom_shader_size,
+        const char *frag_shader_text, size_t frag_shader_size,
+        const char *defines,
+        const char *library_text, size_t library_size
+)
+{
+    // shaders, the geometry shader is optional
+    const char *texts[3] = {vert_shader_text, geom_shader_text, frag_shader_text};
+    const size_t sizes[3] = {vert_shader_size, geom_shader_size, frag_shader_size};
+    const GLenum types[3] = {GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER};
+    const char *names[3] = {"vert", "geom", "frag"};
+    Shader shaders[3]{};
+    uint32_t shader_count = 0;
+    for (uint32_t i = 0; i < 3; i++) {
+        if (!texts[i]) {
+            continue;
+        }
 
-    // create fragment shader
-    if (Shader::create_shader(&frag_shader, frag_shader_text, frag_shader_size, false) == EXIT_FAILURE) {
-        nm_log::log(LOG_ERROR, "frag shader creation failed\n");
+        if (Shader::create_shader(
+                &shaders[shader_count], texts[i], (GLint) sizes[i], types[i], defines, library_text,
+                (GLint) library_size) == EXIT_FAILURE) {
+            nm_log::log(LOG_ERROR, "%s shader creation failed\n", names[i]);
 
-        // prevent leaking vertex shader
-        Shader::delete_shader(&vert_shader);
+            // prevent leaking the shaders created before
+            for (uint32_t j = 0; j < shader_count; j++) {
+                Shader::delete_shader(&shaders[j]);
+            }
 
-        return EXIT_FAILURE;
+            return EXIT_FAILURE;
+        }
+        shader_count++;
     }
 
     // create shader program
     shader_program->shader_program = glCreateProgram();
 
-    glAttachShader(shader_program->shader_program, vert_shader.shader);
-    glAttachShader(shader_program->shader_program, frag_shader.shader);
+    for (uint32_t i = 0; i < shader_count; i++) {
+        glAttachShader(shader_program->shader_program, shaders[i].shader);
+    }
 
     glLinkProgram(shader_program->shader_program);
 
@@ -48,34 +73,84 @@ int32_t ShaderProgram::create_shader_program(
 
         if (info_log == NULL) {
             nm_log::log(LOG_ERROR, "could not allocate memory for log info\n");
+        } else {
+            glGetProgramInfoLog(shader_program->shader_program, info_log_length, &info_log_length, info_log);
+            info_log[info_log_length - 1] = '\0'; // null terminate
+            nm_log::log(LOG_ERROR, "shader program linking failed: %s\n", info_log);
+            free(info_log);
+        }
 
-            glDeleteProgram(shader_program->shader_program);
-
-            Shader::delete_shader(&frag_shader);
-            Shader::delete_shader(&vert_shader);
+        glDeleteProgram(shader_program->shader_program);
 
-            return EXIT_FAILURE;
+        for (uint32_t i = 0; i < shader_count; i++) {
+            Shader::delete_shader(&shaders[i]);
         }
 
-        glGetProgramInfoLog(shader_program->shader_program, info_log_length, &info_log_length, info_log);
-        info_log[info_log_length - 1] = '\0'; // null terminate
-        nm_log::log(LOG_ERROR, "shader program linking failed: %s\n", info_log);
-        free(info_log);
+        return EXIT_FAILURE;
+    }
 
-        glDeleteProgram(shader_program->shader_program);
+    // detach shaders and delete shaders
+    for (uint32_t i = 0; i < shader_count; i++) {
+        glDetachShader(shader_program->shader_program, shaders[i].shader);
+        Shader::delete_shader(&shaders[i]);
+    }
 
-        Shader::delete_shader(&frag_shader);
-        Shader::delete_shader(&vert_shader);
+    if (reflect_uniforms(shader_program) == EXIT_FAILURE) {
+        glDeleteProgram(shader_program->shader_program);
 
         return EXIT_FAILURE;
     }
 
-    // detach shaders and delete shaders
-    glDetachShader(shader_program->shader_program, frag_shader.shader);
-    glDetachShader(shader_program->shader_program, vert_shader.shader);
+    return EXIT_SUCCESS;
+}
+
+int ShaderProgram::reflect_uniforms(ShaderProgram *p_shader_program)
+{
+    GLuint program = p_shader_program->shader_program;
+    GLint uniform_count = 0;
+    GLint max_name_length = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniform_count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+
+    // room for the longest name, and for the index of any element appended to it
+    std::vector<GLchar> name((size_t) max_name_length + 16);
+    p_shader_program->uniforms.clear();
+    for (GLint i = 0; i < uniform_count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type;
+        glGetActiveUniform(program, (GLuint) i, max_name_length, &length, &size, &type, name.data());
+        name[length] = '\0';
+
+        // an array is reported by its first element, its other elements may not follow it in location
+        char *bracket = strchr(name.data(), '[');
+        if (bracket) {
+            *bracket = '\0';
+        }
+        p_shader_program->uniforms.push_back(
+                {UniformName::hash_name(name.data()), glGetUniformLocation(program, name.data())});
+        if (!bracket) {
+            continue;
+        }
+        size_t base_length = strlen(name.data());
+        for (GLint element = 0; element < size; element++) {
+            snprintf(name.data() + base_length, name.size() - base_length, "[%d]", element);
+            p_shader_program->uniforms.push_back(
+                    {UniformName::hash_name(name.data()), glGetUniformLocation(program, name.data())});
+        }
+    }
 
-    Shader::delete_shader(&frag_shader);
-    Shader::delete_shader(&vert_shader);
+    std::sort(p_shader_program->uniforms.begin(), p_shader_program->uniforms.end(),
+              [](const UniformLocation &a, const UniformLocation &b) {
+                  return a.name_hash < b.name_hash;
+              });
+    for (size_t i = 1; i < p_shader_program->uniforms.size(); i++) {
+        if (p_shader_program->uniforms[i - 1].name_hash == p_shader_program->uniforms[i].name_hash) {
+            nm_log::log(LOG_ERROR, "names of uniforms of shader program collide, rename one of them\n");
+
+            return EXIT_FAILURE;
+        }
+    }
 
     return EXIT_SUCCESS;
 }
@@ -83,6 +158,7 @@ int32_t ShaderProgram::create_shader_program(
 void ShaderProgram::delete_shader_program(ShaderProgram *p_shader_program)
 {
     glDeleteProgram(p_shader_program->shader_program);
+    p_shader_program->uniforms.clear();
 }
 
 
@@ -96,46 +172,117 @@ void ShaderProgram::unuse_shader_program()
     glUseProgram(0);
 }
 
-void ShaderProgram::set_vec3(ShaderProgram *p_shader_program, const char *name, glm::vec3 val)
+GLint ShaderProgram::get_location(const ShaderProgram *p_shader_program, UniformName name)
+{
+    auto entry = std::lower_bound(
+            p_shader_program->uniforms.begin(), p_shader_program->uniforms.end(), name.hash,
+            [](const UniformLocation &uniform, uint32_t hash) {
+                return uniform.name_hash < hash;
+            });
+    if (entry == p_shader_program->uniforms.end() || entry->name_hash != name.hash) {
+        return -1;
+    }
+
+    return entry->location;
+}
+
+void ShaderProgram::set_vec3(ShaderProgram *p_shader_program, UniformName name, glm::vec3 val)
+{
+    set_vec3(get_location(p_shader_program, name), val);
+}
+
+void ShaderProgram::set_mat3(ShaderProgram *p_shader_program, UniformName name, glm::mat3 val)
+{
+    set_mat3(get_location(p_shader_program, name), val);
+}
+
+void ShaderProgram::set_mat4(ShaderProgram *p_shader_program, UniformName name, glm::mat4 val)
+{
+    set_mat4(get_location(p_shader_program, name), val);
+}
+
+void ShaderProgram::set_float(ShaderProgram *p_shader_program, UniformName name, float val)
+{
+    set_float(get_location(p_shader_program, name), val);
+}
+
+void ShaderProgram::set_int(ShaderProgram *p_shader_program, UniformName name, int val)
+{
+    set_int(get_location(p_shader_program, name), val);
+}
+
+void ShaderProgram::set_vec3_array(
+        ShaderProgram *p_shader_program, UniformName name, const std::vector<glm::vec3> &vals)
+{
+    set_vec3_array(get_location(p_shader_program, name), vals);
+}
+
+void ShaderProgram::set_vec3(GLint location, glm::vec3 val)
 {
-    GLint location = glGetUniformLocation(p_shader_program->shader_program, name);
     glUniform3fv(location, 1, glm::value_ptr(val));
 }
 
-void ShaderProgram::set_mat4(ShaderProgram *p_shader_program, const char *name, glm::mat4 val)
+void ShaderProgram::set_mat3(GLint location, glm::mat3 val)
+{
+    // GL_FALSE is passed since glm matrices are column major
+    glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(val));
+}
+
+void ShaderProgram::set_mat4(GLint location, glm::mat4 val)
 {
-    GLint location = glGetUniformLocation(p_shader_program->shader_program, name);
     // GL_FALSE is passed since glm matrices are column major
     glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(val));
 }
 
-void ShaderProgram::set_float(ShaderProgram *p_shader_program, const char *name, float val)
+void ShaderProgram::set_float(GLint location, float val)
 {
-    GLint location = glGetUniformLocation(p_shader_program->shader_program, name);
     glUniform1f(location, val);
 }
 
-void ShaderProgram::set_int(ShaderProgram *p_shader_program, const char *name, int val)
+void ShaderProgram::set_int(GLint location, int val)
 {
-    GLint location = glGetUniformLocation(p_shader_program->shader_program, name);
     glUniform1i(location, val);
 }
 
-void ShaderProgram::set_vec3_array(ShaderProgram *p_shader_program, const char *name, std::vector<glm::vec3> vals)
+void ShaderProgram::set_vec3_array(GLint location, const std::vector<glm::vec3> &vals)
 {
-    GLint location = glGetUniformLocation(p_shader_program->shader_program, name);
-    glUniform3fv(location, vals.size(), glm::value_ptr(vals.front()));
+    // a scene without lights passes no values, there is no first element to point to
+    if (vals.empty()) {
+        return;
+    }
+
+    glUniform3fv(location, (GLsizei) vals.size(), glm::value_ptr(vals.front()));
 }
 
-int32_t Shader::create_shader(Shader *p_shader, const char *shader_text, GLint shader_size, bool is_vertex)
+int32_t Shader::create_shader(
+        Shader *p_shader, const char *shader_text, GLint shader_size, GLenum type, const char *defines,
+        const char *library_text, GLint library_size)
 {
-    if (is_vertex) {
-        p_shader->shader = glCreateShader(GL_VERTEX_SHADER);
+    p_shader->shader = glCreateShader(type);
+
+    if (defines || library_text) {
+        // the source is passed in four parts, such that the definitions and the library follow the version line
+        // without a copy, either of which may be empty
+        // NB: embedded sources are not null terminated, so the version line is searched within {size}
+        const char version[] = "#version";
+        GLint size = shader_size ? shader_size : (GLint) strlen(shader_text);
+        GLint split = 0;
+        while (split + (GLint) strlen(version) <= size && memcmp(shader_text + split, version, strlen(version)) != 0) {
+            split++;
+        }
+        if (split + (GLint) strlen(version) > size) {
+            split = 0;
+        } else {
+            while (split < size && shader_text[split++] != '\n') {}
+        }
+        const char *parts[4] = {
+                shader_text, defines ? defines : "", library_text ? library_text : "", shader_text + split};
+        const GLint part_sizes[4] = {
+                split, defines ? (GLint) strlen(defines) : 0, library_text ? library_size : 0, size - split};
+        glShaderSource(p_shader->shader, 4, parts, part_sizes);
     } else {
-        p_shader->shader = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(p_shader->shader, 1, &shader_text, shader_size ? &shader_size : NULL);
     }
-
-    glShaderSource(p_shader->shader, 1, &shader_text, shader_size ? &shader_size : NULL);
     glCompileShader(p_shader->shader);
     GLint success = GL_FALSE;
     glGetShaderiv(p_shader->shader, GL_COMPILE_STATUS, &success);
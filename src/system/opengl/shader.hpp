@@ -1,15 +1,43 @@
 #ifndef SYSTEM_SHADER_HPP
 #define SYSTEM_SHADER_HPP
 
+#include <cstdint>
 #include <vector>
 
 #include <glad/glad.h>
 #include <glm/vec3.hpp>
 #include <glm/glm.hpp>
 
+/**
+ * Name of a uniform by its 32 bit FNV-1a hash. The hash is computed at compile time for {constexpr} names, such that
+ * setting a uniform through one does not touch a string. Names are converted implicitly, which hashes them at run time
+ * where that is not done per draw. */
+struct UniformName {
+    uint32_t hash;
+
+    constexpr UniformName(const char *name) : hash(hash_name(name))
+    {}
+
+    static constexpr uint32_t hash_name(const char *name, uint32_t hash = 0x811c9dc5u)
+    {
+        return *name ? hash_name(name + 1, (hash ^ (uint8_t) *name) * 0x01000193u) : hash;
+    }
+};
+
 struct ShaderProgram {
     GLuint shader_program;
 
+    /** Location of an active uniform, by the hash of its name. */
+    struct UniformLocation {
+        uint32_t name_hash;
+        GLint location;
+    };
+
+    /**
+     * Locations of all active uniforms sorted by the hashes of their names, reflected once the program is linked. An
+     * array is found by its name and by the names of its elements. */
+    std::vector<UniformLocation> uniforms;
+
     /**
      * Returns {EXIT_SUCCESS} on success, {EXIT_FAILURE} otherwise.
      * If {EXIT_SUCCESS} is returned, a call to {delete_shader} is required before the executable terminates. */
@@ -19,21 +47,59 @@ struct ShaderProgram {
             const char *frag_shader_text, size_t frag_shader_size
     );
 
+    /**
+     * Like above, with geometry shader {geom_shader_text} between the vertex and fragment shaders, which may be null.
+     * {defines}, if not null, are lines of preprocessor definitions inserted after the {#version} line of every shader,
+     * such that variants of a shader are compiled from the same source. {library_text}, if not null, is inserted
+     * after {defines}, functions shared by shaders which have no way to include them. */
+    static int32_t create_shader_program(
+            ShaderProgram *shader_program,
+            const char *vert_shader_text, size_t vert_shader_size,
+            const char *geom_shader_text, size_t geom_shader_size,
+            const char *frag_shader_text, size_t frag_shader_size,
+            const char *defines,
+            const char *library_text, size_t library_size
+    );
+
     static void delete_shader_program(ShaderProgram *p_shader_program);
 
     static void use_shader_program(ShaderProgram *p_shader_program);
 
     static void unuse_shader_program();
 
-    static void set_vec3(ShaderProgram *p_shader_program, const char *name, glm::vec3 val);
+    /**
+     * Returns the location of uniform {name}, -1 if it is not active, which the setters below silently ignore. The
+     * location may be kept as a handle and passed to the setters that take one, which skips the lookup. */
+    static GLint get_location(const ShaderProgram *p_shader_program, UniformName name);
+
+    static void set_vec3(ShaderProgram *p_shader_program, UniformName name, glm::vec3 val);
+
+    static void set_mat3(ShaderProgram *p_shader_program, UniformName name, glm::mat3 val);
+
+    static void set_mat4(ShaderProgram *p_shader_program, UniformName name, glm::mat4 val);
+
+    static void set_float(ShaderProgram *p_shader_program, UniformName name, float val);
+
+    static void set_int(ShaderProgram *p_shader_program, UniformName name, int val);
+
+    static void set_vec3_array(ShaderProgram *p_shader_program, UniformName name, const std::vector<glm::vec3> &vals);
+
+    /** Like above, with a {location} obtained from {get_location} of the program in use. */
+    static void set_vec3(GLint location, glm::vec3 val);
+
+    static void set_mat3(GLint location, glm::mat3 val);
+
+    static void set_mat4(GLint location, glm::mat4 val);
 
-    static void set_mat4(ShaderProgram *p_shader_program, const char *name, glm::mat4 val);
+    static void set_float(GLint location, float val);
 
-    static void set_float(ShaderProgram *p_shader_program, const char *name, float val);
+    static void set_int(GLint location, int val);
 
-    static void set_int(ShaderProgram *p_shader_program, const char *name, int val);
+    static void set_vec3_array(GLint location, const std::vector<glm::vec3> &vals);
 
-    static void set_vec3_array(ShaderProgram *p_shader_program, const char *name, std::vector<glm::vec3> vals);
+private:
+    /** Fills {uniforms} of the linked {p_shader_program}. */
+    static int reflect_uniforms(ShaderProgram *p_shader_program);
 };
 
 struct Shader {
@@ -42,9 +108,12 @@ struct Shader {
     /**
      * Returns {EXIT_SUCCESS} on success, {EXIT_FAILURE} otherwise.
      * If {EXIT_SUCCESS} is returned, a call to {delete_shader} is required before the executable terminates.
-     * If {is_vertex} is {true}, create vertex shader. Otherwise, create fragment shader.
-     * {shader_size} may be 0, consequence is reduced error checking. */
-    static int32_t create_shader(Shader *p_shader, const char *shader_text, GLint shader_size, bool is_vertex);
+     * {type} is {GL_VERTEX_SHADER}, {GL_GEOMETRY_SHADER}, or {GL_FRAGMENT_SHADER}.
+     * {shader_size} may be 0, consequence is reduced error checking. {defines} and {library_text} may be null, see
+     * {ShaderProgram::create_shader_program}. */
+    static int32_t create_shader(
+            Shader *p_shader, const char *shader_text, GLint shader_size, GLenum type, const char *defines,
+            const char *library_text, GLint library_size);
 
     static void delete_shader(Shader *p_shader);
 };
@@ -0,0 +1,172 @@
+#include "spherical_harmonics.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#include "cubemap_converter.hpp"
+#include "../../util/nm_log.hpp"
+
+const uint32_t SphericalHarmonics::VERSION = 1;
+
+/** Largest face resolution that is projected, finer levels add no detail to an order 2 expansion. */
+static const uint32_t PROJECTION_RESOLUTION = 64;
+
+/**
+ * Factors of the clamped cosine convolution per band (pi, 2pi/3, pi/4) divided by pi, for every coefficient.
+ * (https://cseweb.ucsd.edu/~ravir/papers/envmap/envmap.pdf) */
+static const float BAND_FACTORS[SphericalHarmonics::COEFFICIENT_COUNT] = {
+        1.f, 2.f / 3.f, 2.f / 3.f, 2.f / 3.f, .25f, .25f, .25f, .25f, .25f};
+
+/** Writes the real spherical harmonics basis functions up to band 2 in unit {direction} to {basis}. */
+static void get_basis(glm::vec3 direction, float *basis)
+{
+    float x = direction.x;
+    float y = direction.y;
+    float z = direction.z;
+
+    basis[0] = .282095f;
+    basis[1] = .488603f * y;
+    basis[2] = .488603f * z;
+    basis[3] = .488603f * x;
+    basis[4] = 1.092548f * x * y;
+    basis[5] = 1.092548f * y * z;
+    basis[6] = .315392f * (3.f * z * z - 1.f);
+    basis[7] = 1.092548f * x * z;
+    basis[8] = .546274f * (x * x - y * y);
+}
+
+int SphericalHarmonics::project_irradiance(SphericalHarmonics *irradiance, const TextureData *cubemap)
+{
+    if ((cubemap->texture_type != GL_TEXTURE_CUBE_MAP && cubemap->texture_type != GL_TEXTURE_2D) ||
+        cubemap->format != GL_RGB ||
+        (cubemap->type != GL_FLOAT && cubemap->type != GL_HALF_FLOAT &&
+         cubemap->type != GL_UNSIGNED_INT_5_9_9_9_REV)) {
+        nm_log::log(LOG_ERROR, "irradiance can only be projected from RGB environments of floats, halfs, or RGB9_E5\n");
+
+        return EXIT_FAILURE;
+    }
+
+    // an octahedral map has as many texels as two faces of the same width
+    bool octahedral = cubemap->texture_type == GL_TEXTURE_2D;
+    uint32_t face_count = octahedral ? 1 : 6;
+    uint32_t max_resolution = octahedral ? 2 * PROJECTION_RESOLUTION : PROJECTION_RESOLUTION;
+    uint32_t level = 0;
+    while (level + 1 < cubemap->level_count && cubemap->get_level_width(level) > max_resolution) {
+        level++;
+    }
+    uint32_t resolution = cubemap->get_level_width(level);
+    uint32_t pixel_size = TextureData::get_pixel_size(cubemap->format, cubemap->type);
+
+    // accumulate in double precision, the sum runs over tens of thousands of texels
+    double sums[COEFFICIENT_COUNT][3] = {};
+    double weight_sum = 0.;
+    for (uint32_t face = 0; face < face_count; face++) {
+        const uint8_t *pixels = cubemap->get_pixels(level, face);
+        const float (*axes)[3] = CubemapConverter::FACE_AXES[face];
+        for (uint32_t j = 0; j < resolution; j++) {
+            float t = ((float) j + .5f) / (float) resolution * 2.f - 1.f;
+            for (uint32_t i = 0; i < resolution; i++) {
+                float s = ((float) i + .5f) / (float) resolution * 2.f - 1.f;
+                glm::vec3 direction;
+                if (octahedral) {
+                    CubemapConverter::get_octahedral_direction(s, t, &direction[0]);
+                } else {
+                    for (int c = 0; c < 3; c++) {
+                        direction[c] = axes[0][c] + s * axes[1][c] + t * axes[2][c];
+                    }
+                }
+
+                // solid angle of the texel, relative to that of a texel at the center of the face, or at the center
+                // of the octahedral map since the same holds for directions of an L1 norm of 1
+                float length_squared = glm::dot(direction, direction);
+                float weight = 1.f / (length_squared * sqrtf(length_squared));
+
+                float radiance[3];
+                TextureData::read_rgb(cubemap->type, pixels + ((size_t) j * resolution + i) * pixel_size, radiance);
+
+                float basis[COEFFICIENT_COUNT];
+                get_basis(glm::normalize(direction), basis);
+                for (uint32_t k = 0; k < COEFFICIENT_COUNT; k++) {
+                    for (uint32_t c = 0; c < 3; c++) {
+                        sums[k][c] += (double) (radiance[c] * basis[k] * weight);
+                    }
+                }
+                weight_sum += weight;
+            }
+        }
+    }
+
+    // the weights of all texels cover the full sphere
+    auto normalization = (float) (4. * M_PI / weight_sum);
+    for (uint32_t k = 0; k < COEFFICIENT_COUNT; k++) {
+        for (uint32_t c = 0; c < 3; c++) {
+            irradiance->coefficients[k][c] = (float) sums[k][c] * normalization * BAND_FACTORS[k];
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+glm::vec3 SphericalHarmonics::evaluate(const SphericalHarmonics *irradiance, glm::vec3 direction)
+{
+    float basis[COEFFICIENT_COUNT];
+    get_basis(direction, basis);
+
+    glm::vec3 value(0.f);
+    for (uint32_t k = 0; k < COEFFICIENT_COUNT; k++) {
+        value += irradiance->coefficients[k] * basis[k];
+    }
+
+    return value;
+}
+
+void SphericalHarmonics::rotate_y(const SphericalHarmonics *irradiance, float yaw, SphericalHarmonics *result)
+{
+    const float s = sinf(yaw);
+    const float c = cosf(yaw);
+    const float sqrt_3 = sqrtf(3.f);
+    const glm::vec3 *in = irradiance->coefficients;
+
+    // written to a copy first, {result} may be {irradiance}
+    glm::vec3 out[COEFFICIENT_COUNT];
+    out[0] = in[0];
+
+    // band 1, y is unaffected and (z, x) rotates like a vector
+    out[1] = in[1];
+    out[2] = c * in[2] - s * in[3];
+    out[3] = s * in[2] + c * in[3];
+
+    // band 2, (xy, yz) rotates like a vector, 3z^2-1, xz, and x^2-y^2 mix through the double angle
+    out[4] = c * in[4] + s * in[5];
+    out[5] = -s * in[4] + c * in[5];
+    out[6] = (1.f - 1.5f * s * s) * in[6] - sqrt_3 * s * c * in[7] + .5f * sqrt_3 * s * s * in[8];
+    out[7] = sqrt_3 * s * c * in[6] + (c * c - s * s) * in[7] - s * c * in[8];
+    out[8] = .5f * sqrt_3 * s * s * in[6] + s * c * in[7] + (1.f - .5f * s * s) * in[8];
+
+    memcpy(result->coefficients, out, sizeof(out));
+}
+
+void SphericalHarmonics::write_texture_data(const SphericalHarmonics *irradiance, TextureData *data)
+{
+    *data = TextureData{GL_TEXTURE_2D, GL_RGB32F, GL_RGB, GL_FLOAT, COEFFICIENT_COUNT, 1, 1, 1, {}};
+    data->data.resize(COEFFICIENT_COUNT * 3 * sizeof(float));
+    for (uint32_t k = 0; k < COEFFICIENT_COUNT; k++) {
+        memcpy(&data->data[k * 3 * sizeof(float)], &irradiance->coefficients[k][0], 3 * sizeof(float));
+    }
+}
+
+int SphericalHarmonics::read_texture_data(SphericalHarmonics *irradiance, const TextureData *data)
+{
+    if (data->internal_format != GL_RGB32F || data->width != COEFFICIENT_COUNT || data->height != 1 ||
+        data->data.size() != COEFFICIENT_COUNT * 3 * sizeof(float)) {
+        nm_log::log(LOG_ERROR, "texture data does not hold spherical harmonics coefficients\n");
+
+        return EXIT_FAILURE;
+    }
+
+    for (uint32_t k = 0; k < COEFFICIENT_COUNT; k++) {
+        memcpy(&irradiance->coefficients[k][0], &data->data[k * 3 * sizeof(float)], 3 * sizeof(float));
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,49 @@
+#ifndef SYSTEM_SPHERICAL_HARMONICS_HPP
+#define SYSTEM_SPHERICAL_HARMONICS_HPP
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <glm/glm.hpp>
+
+#include "texture_data.hpp"
+
+/**
+ * Irradiance of an environment as the 9 coefficients of an order 2 (L2) spherical harmonics expansion, which is
+ * evaluated analytically in {pbr.frag} instead of sampling an irradiance cubemap. The expansion of radiance is
+ * convolved with the clamped cosine, under which the bands beyond 2 hardly contribute. */
+struct SphericalHarmonics {
+    static const uint32_t COEFFICIENT_COUNT = 9;
+
+    /** Bumped whenever the projection changes, such that cached coefficients are regenerated. */
+    static const uint32_t VERSION;
+
+    /**
+     * RGB coefficients in the order 00, 1-1, 10, 11, 2-2, 2-1, 20, 21, 22. These are scaled by the cosine convolution
+     * and by 1/pi, such that evaluating them gives the value the irradiance cubemap held. */
+    glm::vec3 coefficients[COEFFICIENT_COUNT];
+
+    /**
+     * Projects the radiance of {cubemap}, a cubemap or octahedral map as converted by {CubemapConverter} and optionally
+     * packed by {TextureData::convert_rgb}, into {irradiance}. The first level of at most 64 by 64 pixels per face is
+     * projected, since its box filtered texels integrate to the same coefficients. */
+    static int project_irradiance(SphericalHarmonics *irradiance, const TextureData *cubemap);
+
+    /** Evaluates {irradiance} in unit {direction}, like {pbr.frag} does. */
+    static glm::vec3 evaluate(const SphericalHarmonics *irradiance, glm::vec3 direction);
+
+    /**
+     * Writes {irradiance} rotated by {yaw} radians around the Y-axis to {result}, such that evaluating {result} in a
+     * direction gives what {irradiance} gives in that direction rotated back. Bands do not mix under rotation, so this
+     * is exact and costs a handful of multiplications. */
+    static void rotate_y(const SphericalHarmonics *irradiance, float yaw, SphericalHarmonics *result);
+
+    /**
+     * Stores {irradiance} as a single row of {COEFFICIENT_COUNT} {GL_RGB32F} pixels, such that it is cached and baked
+     * like a texture. */
+    static void write_texture_data(const SphericalHarmonics *irradiance, TextureData *data);
+
+    static int read_texture_data(SphericalHarmonics *irradiance, const TextureData *data);
+};
+
+#endif //SYSTEM_SPHERICAL_HARMONICS_HPP
@@ -1,5 +1,8 @@
 #include "texture.hpp"
 
+#include <cstdio>
+#include <cstring>
+
 #define STB_IMAGE_IMPLEMENTATION
 
 #include <stb_image.h>
@@ -8,6 +11,7 @@
 
 #include "../../util/nm_log.hpp"
 #include "../../util/util.hpp"
+#include "radiance_decoder.hpp"
 #include "shader.hpp"
 #include "../manager/embedded.hpp"
 #include "primitive/primitive.hpp"
@@ -23,16 +27,57 @@ const glm::mat4 Texture::CAPTURE_VIEWS[] = {
         glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f))
 };
 
+void Texture::initialize_decoding()
+{
+    // NB: first pixel is top-left corner, flip it on load. stbi keeps this setting in global state, so it is set once
+    // instead of before every load to allow decoding on multiple threads at once
+    stbi_set_flip_vertically_on_load(1);
+}
+
+/** Whether BC1 is supported, and BC1 with sRGB decoding. Written once by {initialize_formats}. */
+static bool s3tc_supported = false;
+static bool s3tc_srgb_supported = false;
+
+void Texture::initialize_formats()
+{
+    GLint extension_count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+    for (GLint i = 0; i < extension_count; i++) {
+        const char *name = (const char *) glGetStringi(GL_EXTENSIONS, (GLuint) i);
+        if (strcmp(name, "GL_EXT_texture_compression_s3tc") == 0) {
+            s3tc_supported = true;
+        } else if (strcmp(name, "GL_EXT_texture_sRGB") == 0) {
+            s3tc_srgb_supported = true;
+        }
+    }
+
+    if (!s3tc_supported) {
+        nm_log::log(LOG_WARN, "S3TC is not supported, textures prepared with BC1 are decoded instead\n");
+    }
+}
+
+bool Texture::is_format_supported(GLenum internal_format)
+{
+    switch (internal_format) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+            return s3tc_supported;
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+            return s3tc_supported && s3tc_srgb_supported;
+        default:
+            // BC4 and BC5 are core, as are all uncompressed formats
+            return true;
+    }
+}
+
 int Texture::create_tex_from_file(
-        Texture *tex, const char *tex_file,
-        uint32_t channel_count, uint32_t bit_depth, uint32_t texture_unit, TextureManager::ChannelType channel_type,
+        Texture *tex, const char *tex_file, TextureManager::Semantic semantic, uint32_t texture_unit,
         TextureManager::WrapType wrap_type)
 {
     char *buffer = nullptr;
     size_t size;
     Util::read_file(&buffer, &size, tex_file);
 
-    int rval = create_tex_from_mem(tex, buffer, size, channel_count, bit_depth, texture_unit, channel_type, wrap_type);
+    int rval = create_tex_from_mem(tex, buffer, size, semantic, texture_unit, wrap_type);
 
     delete buffer;
 
@@ -40,441 +85,696 @@ int Texture::create_tex_from_file(
 }
 
 int Texture::create_tex_from_mem(
-        Texture *tex, const char *tex_data, size_t tex_len,
-        uint32_t channel_count, uint32_t bit_depth, uint32_t texture_unit, TextureManager::ChannelType channel_type,
+        Texture *tex, const char *tex_data, size_t tex_len, TextureManager::Semantic semantic, uint32_t texture_unit,
         TextureManager::WrapType wrap_type
 )
 {
-    tex->texture_type = GL_TEXTURE_2D;
+    TextureData data{};
+    if (decode_tex(&data, tex_data, tex_len, semantic) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
 
-    glGenTextures(1, &tex->tex_id);
-    glBindTexture(tex->texture_type, tex->tex_id);
+    return upload_tex(tex, &data, texture_unit, wrap_type);
+}
 
-    // set the texture wrapping/filtering options (on the currently bound texture object)
-    if (wrap_type == TextureManager::REPEAT) {
-        glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    } else if (wrap_type == TextureManager::CLAMP) {
-        glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    } else {
-        nm_log::log(LOG_WARN, "unrecognized wrapping type, guessing GL_REPEAT\n");
-        glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_T, GL_REPEAT);
+int Texture::decode_tex(
+        TextureData *data, const char *tex_data, size_t tex_len, TextureManager::Semantic semantic
+)
+{
+    switch (semantic) {
+        case TextureManager::DIFFUSE:
+            if (decode_image(data, tex_data, tex_len, 4, 8) == EXIT_FAILURE) {
+                return EXIT_FAILURE;
+            }
+            data->internal_format = GL_SRGB8_ALPHA8;
+            break;
+        case TextureManager::NORMAL: {
+            // NB: stbi decodes two channels as gray and alpha, so decode three and drop Z
+            if (decode_image(data, tex_data, tex_len, 3, 8) == EXIT_FAILURE) {
+                return EXIT_FAILURE;
+            }
+            size_t pixel_count = (size_t) data->width * data->height;
+            for (size_t i = 0; i < pixel_count; i++) {
+                data->data[i * 2 + 0] = data->data[i * 3 + 0];
+                data->data[i * 2 + 1] = data->data[i * 3 + 1];
+            }
+            data->format = GL_RG;
+            data->internal_format = GL_RG8;
+            data->data.resize(data->get_level_size(0));
+            break;
+        }
+        case TextureManager::SCALAR: {
+            // keep the precision of 16 bit images, which is mostly used for displacement
+            bool is_16_bit = stbi_is_16_bit_from_memory((const unsigned char *) tex_data, (int) tex_len);
+            if (decode_image(data, tex_data, tex_len, 1, is_16_bit ? 16 : 8) == EXIT_FAILURE) {
+                return EXIT_FAILURE;
+            }
+            data->internal_format = is_16_bit ? GL_R16 : GL_R8;
+            break;
+        }
+        case TextureManager::RADIANCE:
+        default:
+            // decode Radiance HDR images straight to half floats, halving the upload
+            if (RadianceDecoder::is_radiance(tex_data, tex_len)) {
+                if (RadianceDecoder::decode(data, tex_data, tex_len, GL_HALF_FLOAT) == EXIT_FAILURE) {
+                    return EXIT_FAILURE;
+                }
+            } else if (decode_image(data, tex_data, tex_len, 3, 32) == EXIT_FAILURE) {
+                return EXIT_FAILURE;
+            }
+            data->internal_format = GL_RGB16F;
     }
-    glTexParameteri(tex->texture_type, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(tex->texture_type, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 
+    return EXIT_SUCCESS;
+}
+
+int Texture::decode_image(
+        TextureData *data, const char *tex_data, size_t tex_len, uint32_t channel_count, uint32_t bit_depth
+)
+{
     // load and generate the texture
     int found_width, found_height, found_channel_count;
-    // NB: first pixel is top-left corner, flip it with this call
-    stbi_set_flip_vertically_on_load(1);
-    void *data;
-    // todo could combine channel type and bit depth into a single enum variable
-    if (bit_depth == 8 && channel_type == TextureManager::INTEGER) {
-        // unsigned char *
-        default_depth:
-        data = stbi_load_from_memory(
-                (const unsigned char *) tex_data, tex_len, &found_width, &found_height, &found_channel_count,
-                channel_count);
-    } else if (bit_depth == 16 && channel_type == TextureManager::INTEGER) {
+    void *pixels;
+    if (bit_depth == 16) {
         // unsigned short *
-        data = stbi_load_16_from_memory(
+        pixels = stbi_load_16_from_memory(
                 (const unsigned char *) tex_data, tex_len, &found_width, &found_height, &found_channel_count,
                 channel_count);
-    } else if (bit_depth == 32 && channel_type == TextureManager::FLOATING_POINT) {
+    } else if (bit_depth == 32) {
         // float *
-        data = stbi_loadf_from_memory(
+        pixels = stbi_loadf_from_memory(
                 (const unsigned char *) tex_data, tex_len, &found_width, &found_height, &found_channel_count,
                 channel_count);
     } else {
-        nm_log::log(LOG_WARN, "no stbi function found for specified bit depth, guessing 8 bit depth\n");
-        goto default_depth;
+        if (bit_depth != 8) {
+            nm_log::log(LOG_WARN, "no stbi function found for specified bit depth, guessing 8 bit depth\n");
+            bit_depth = 8;
+        }
+        // unsigned char *
+        pixels = stbi_load_from_memory(
+                (const unsigned char *) tex_data, tex_len, &found_width, &found_height, &found_channel_count,
+                channel_count);
     }
 
+    if (!pixels) {
+        nm_log::log(LOG_ERROR, "failed to load texture\n");
+
+        return EXIT_FAILURE;
+    }
 
     if (found_channel_count != (int) channel_count) {
-        nm_log::log(LOG_WARN,
+        nm_log::log(LOG_TRACE,
                     "specified channel count (%d) not equal to found channel count (%d)\n",
-                    channel_count, found_channel_count, tex->tex_id);
+                    channel_count, found_channel_count);
     }
 
     // keep on moving forward with assumed channel count since this is the size of the buffer
     // since stbi may complain but will always allocate the number of channels the user specifies
-    if (data) {
-        GLenum format;
-        GLenum internal_format;
-        if (channel_count == 2) {
-            format = GL_RG;
-            internal_format = GL_RG;
-        } else if (channel_count == 3) {
-            format = GL_RGB;
-            internal_format = GL_RGB;
-        } else if (channel_count == 4) {
-            format = GL_RGBA;
-            internal_format = GL_RGBA;
-        } else {
-            nm_log::log(LOG_WARN, "unknown texture format, guessing GL_RGBA\n");
-            format = GL_RGBA;
-            internal_format = GL_RGBA;
-        }
-
-        GLenum type;
-        if (bit_depth == 8 && channel_type == TextureManager::INTEGER) {
-            type = GL_UNSIGNED_BYTE;
-        } else if (bit_depth == 16 && channel_type == TextureManager::INTEGER) {
-            type = GL_UNSIGNED_SHORT;
-        } else if (bit_depth == 32 && channel_type == TextureManager::FLOATING_POINT) {
-            type = GL_FLOAT;
-        } else {
-            nm_log::log(LOG_WARN, "unknown texture type, guessing GL_UNSIGNED_BYTE\n");
-            type = GL_UNSIGNED_BYTE;
-        }
-
-        // NB: first pixel is lower-left corner
-        glTexImage2D(tex->texture_type, 0, internal_format, found_width, found_height, 0, format, type, data);
-        glGenerateMipmap(tex->texture_type);
+    if (channel_count == 1) {
+        data->format = GL_RED;
+    } else if (channel_count == 2) {
+        data->format = GL_RG;
+    } else if (channel_count == 3) {
+        data->format = GL_RGB;
+    } else if (channel_count == 4) {
+        data->format = GL_RGBA;
     } else {
-        nm_log::log(LOG_ERROR, "failed to load texture\n");
-        stbi_image_free(data);
+        nm_log::log(LOG_WARN, "unknown texture format, guessing GL_RGBA\n");
+        data->format = GL_RGBA;
+    }
+    data->internal_format = data->format;
 
-        return EXIT_FAILURE;
+    if (bit_depth == 16) {
+        data->type = GL_UNSIGNED_SHORT;
+    } else if (bit_depth == 32) {
+        data->type = GL_FLOAT;
+    } else {
+        data->type = GL_UNSIGNED_BYTE;
     }
 
-    stbi_image_free(data);
+    data->texture_type = GL_TEXTURE_2D;
+    data->width = found_width;
+    data->height = found_height;
+    data->level_count = 1;
+    data->face_count = 1;
+    data->data.assign((uint8_t *) pixels, (uint8_t *) pixels + data->get_level_size(0));
 
-    tex->texture_unit = GL_TEXTURE0 + texture_unit;
-    glBindTexture(tex->texture_type, 0);
+    stbi_image_free(pixels);
 
     return EXIT_SUCCESS;
 }
 
-int Texture::create_tex_from_tex(Texture *tex, Texture *resource_tex, uint32_t texture_unit)
+int Texture::upload_tex(
+        Texture *tex, const TextureData *data, uint32_t texture_unit, TextureManager::WrapType wrap_type)
 {
-    const uint32_t RES_X = 512;
-    const uint32_t RES_Y = 512;
+    allocate_tex(tex, data, texture_unit, wrap_type);
+    for (uint32_t level = 0; level < data->level_count; level++) {
+        upload_tex_rows(tex, data, level, 0, data->get_row_count(level), data->get_pixels(level, 0));
+    }
+    generate_mipmap_tex(tex, data);
 
-    /** generate texture */
-    glGenTextures(1, &tex->tex_id);
+    return EXIT_SUCCESS;
+}
+
+int Texture::allocate_tex(
+        Texture *tex, const TextureData *data, uint32_t texture_unit, TextureManager::WrapType wrap_type)
+{
     tex->texture_type = GL_TEXTURE_2D;
+
+    glGenTextures(1, &tex->tex_id);
     glBindTexture(tex->texture_type, tex->tex_id);
 
-    /** setup framebuffer */
-    GLuint captureFBO;
-    GLuint captureRBO;
-    glGenFramebuffers(1, &captureFBO);
-    glGenRenderbuffers(1, &captureRBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, RES_X, RES_Y);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, tex->texture_type, tex->tex_id, 0);
-
-    /** setup image to render to */
-    glTexImage2D(tex->texture_type, 0, GL_RG16F, RES_X, RES_Y, 0, GL_RG, GL_FLOAT, 0);
-    glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(tex->texture_type, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    // set the texture wrapping/filtering options (on the currently bound texture object)
+    if (wrap_type == TextureManager::REPEAT) {
+        glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    } else if (wrap_type == TextureManager::CLAMP) {
+        glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    } else {
+        nm_log::log(LOG_WARN, "unrecognized wrapping type, guessing GL_REPEAT\n");
+        glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    }
     glTexParameteri(tex->texture_type, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(tex->texture_type, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 
-    // save the current viewport dims to later restore it
-    GLfloat viewport_dims[4];
-    glGetFloatv(GL_VIEWPORT, viewport_dims);
+    // NB: first pixel is lower-left corner
+    for (uint32_t level = 0; level < data->level_count; level++) {
+        if (data->is_compressed()) {
+            glCompressedTexImage2D(
+                    tex->texture_type, level, data->internal_format,
+                    data->get_level_width(level), data->get_level_height(level), 0, data->get_level_size(level),
+                    nullptr);
+        } else {
+            glTexImage2D(
+                    tex->texture_type, level, data->internal_format,
+                    data->get_level_width(level), data->get_level_height(level), 0, data->format, data->type,
+                    nullptr);
+        }
+    }
+
+    // prevent sampling levels that are not provided
+    if (data->level_count > 1) {
+        glTexParameteri(tex->texture_type, GL_TEXTURE_MAX_LEVEL, (GLint) data->level_count - 1);
+    }
 
-    glViewport(0, 0, RES_X, RES_Y);
-    ShaderProgram shader{};
-    ShaderProgram::create_shader_program(&shader, brdf_vert, brdf_vert_len, brdf_frag, brdf_frag_len);
-    ShaderProgram::use_shader_program(&shader);
+    tex->texture_unit = GL_TEXTURE0 + texture_unit;
+    glBindTexture(tex->texture_type, 0);
+
+    return EXIT_SUCCESS;
+}
 
-    glClear((unsigned) GL_COLOR_BUFFER_BIT | (unsigned) GL_DEPTH_BUFFER_BIT);
+void Texture::upload_tex_rows(
+        Texture *tex, const TextureData *data, uint32_t level, uint32_t first_row, uint32_t row_count,
+        const void *pixels)
+{
+    glBindTexture(tex->texture_type, tex->tex_id);
 
-    // begin render_quad
-    GLuint quad_vao = 0;
-    GLuint quad_vbo;
-    float quad_vertices[] = {
-            -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
-            1.0f, 1.0f, 0.0f, 1.0f, 1.0f, 1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
-    };
-    glGenVertexArrays(1, &quad_vao);
-    glBindVertexArray(quad_vao);
+    if (data->is_compressed()) {
+        // a row holds four rows of pixels, the last row of blocks may cover less
+        uint32_t y = first_row * 4;
+        uint32_t height = data->get_level_height(level) - y;
+        if (height > row_count * 4) {
+            height = row_count * 4;
+        }
+        glCompressedTexSubImage2D(
+                tex->texture_type, level, 0, y, data->get_level_width(level), height, data->internal_format,
+                row_count * data->get_row_size(level), pixels);
+    } else {
+        // rows of the decoded pixels are tightly packed
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(
+                tex->texture_type, level, 0, first_row, data->get_level_width(level), row_count, data->format,
+                data->type, pixels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
 
-    glGenBuffers(1, &quad_vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertices), &quad_vertices, GL_STATIC_DRAW);
+    glBindTexture(tex->texture_type, 0);
+}
 
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *) 0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *) (3 * sizeof(float)));
+void Texture::generate_mipmap_tex(Texture *tex, const TextureData *data)
+{
+    // prepared mip chains are uploaded as-is
+    if (data->level_count > 1) {
+        return;
+    }
 
-    glBindVertexArray(quad_vao);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
+    glBindTexture(tex->texture_type, tex->tex_id);
+    glGenerateMipmap(tex->texture_type);
+    glBindTexture(tex->texture_type, 0);
+}
 
-    glDeleteVertexArrays(1, &quad_vao); // todo is this a full cleanup?
-    // end   render_quad
+int Texture::create_placeholder_tex(Texture *tex, const uint8_t *color, uint32_t texture_unit)
+{
+    tex->texture_type = GL_TEXTURE_2D;
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glGenTextures(1, &tex->tex_id);
+    glBindTexture(tex->texture_type, tex->tex_id);
 
-    ShaderProgram::delete_shader_program(&shader);
+    glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(tex->texture_type, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(tex->texture_type, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 
-    // restore viewport
-    glViewport(viewport_dims[0], viewport_dims[1], viewport_dims[2], viewport_dims[3]);
+    glTexImage2D(tex->texture_type, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, color);
 
     tex->texture_unit = GL_TEXTURE0 + texture_unit;
+    glBindTexture(tex->texture_type, 0);
 
     return EXIT_SUCCESS;
 }
 
-int Texture::create_cubemap_from_tex(Texture *tex, Texture *resource_tex, uint32_t texture_unit)
+/**
+ * Number of samples taken per texel by the roughest pre-filter level, smoother levels take fewer. The dominant light is
+ * removed from environments before they are pre-filtered (see {DominantLight}), the smooth residual needs few. */
+static const uint32_t PRE_FILTER_MAX_SAMPLE_COUNT = 256;
+
+/**
+ * Bumped whenever {create_pre_filter_samples} changes the samples, such as how their count scales with roughness or
+ * how their source level is chosen, such that cached pre-filters are regenerated. */
+static const uint32_t PRE_FILTER_VERSION = 1;
+
+/** Reverses the bits of {bits} into a fraction, the second coordinate of the Hammersley point set. */
+static float get_radical_inverse(uint32_t bits)
 {
-    const uint32_t RES_X = 512;
-    const uint32_t RES_Y = 512;
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
 
-    /** generate texture */
-    glGenTextures(1, &tex->tex_id);
-    tex->texture_type = GL_TEXTURE_CUBE_MAP;
-    glBindTexture(tex->texture_type, tex->tex_id);
+    return (float) bits * 2.3283064365386963e-10f; // / 0x100000000
+}
 
-    /** setup framebuffer */
-    GLuint captureFBO;
-    GLuint captureRBO;
-    glGenFramebuffers(1, &captureFBO);
-    glGenRenderbuffers(1, &captureRBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, RES_X, RES_Y);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
+/**
+ * Fills row {level} of {table} with the GGX importance samples of that pre-filter level, each an RGBA float holding
+ * the direction in tangent space (normal, view and reflection are +Z) and the level of the source to read it from.
+ * The level is chosen such that a texel covers the solid angle of the sample (filtered importance sampling), which
+ * allows far fewer samples than point sampling the source would. Samples below the horizon are left out.
+ * The number of samples scales with roughness since the lobe widens with it. Returns the number of samples.
+ * {source_texel_count} is the number of texels of the first level of the source, over all of its faces. */
+static uint32_t create_pre_filter_samples(TextureData *table, uint32_t level, uint32_t source_texel_count)
+{
+    float roughness = (float) level / (float) (Texture::PRE_FILTER_LEVEL_COUNT - 1);
+    float a = roughness * roughness;
+    float a2 = a * a;
+    uint32_t count = (uint32_t) ceilf((float) PRE_FILTER_MAX_SAMPLE_COUNT * roughness);
+    count = count > 0 ? count : 1;
+
+    auto texel_solid_angle = (float) (4. * M_PI / source_texel_count);
+    auto *samples = (float *) (table->get_pixels(0, 0) + level * table->get_row_size(0));
+    uint32_t sample_count = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        auto phi = (float) (2. * M_PI * i / count);
+        float x = get_radical_inverse(i);
+        float cos_theta = sqrtf((1.f - x) / (1.f + (a2 - 1.f) * x));
+        float sin_theta = sqrtf(1.f - cos_theta * cos_theta);
+
+        // reflect the view direction (+Z) around the halfway vector
+        glm::vec3 h(cosf(phi) * sin_theta, sinf(phi) * sin_theta, cos_theta);
+        glm::vec3 l = 2.f * h.z * h - glm::vec3(0.f, 0.f, 1.f);
+        if (l.z <= 0.f) {
+            continue;
+        }
 
-    /** setup cubemap to render to */
-    for (uint32_t i = 0; i < 6; i++) {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, RES_X, RES_Y, 0, GL_RGB, GL_FLOAT, nullptr);
+        // with the normal and view direction equal, the pdf of l reduces to D / 4
+        float d = a2 / (float) (M_PI * powf(cos_theta * cos_theta * (a2 - 1.f) + 1.f, 2.f));
+        float pdf = d * .25f + .0001f;
+        float sample_solid_angle = 1.f / ((float) count * pdf + .0001f);
+        float source_level = roughness == 0.f ? 0.f : fmaxf(.5f * log2f(sample_solid_angle / texel_solid_angle), 0.f);
+
+        float *sample = samples + sample_count * 4;
+        sample[0] = l.x;
+        sample[1] = l.y;
+        sample[2] = l.z;
+        sample[3] = source_level;
+        sample_count++;
     }
-    glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(tex->texture_type, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // see below glGenerateMipmap
-    glTexParameteri(tex->texture_type, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    /** convert HDR equirectangular environment map to cubemap equivalent */
-    // hacky way to manually create shader since we do not have access to a shader manager instance
-    ShaderProgram shader{};
-    ShaderProgram::create_shader_program(
-            &shader, equirectangular_map_vert, equirectangular_map_vert_len,
-            equirectangular_map_frag, equirectangular_map_frag_len);
-    ShaderProgram::use_shader_program(&shader);
-    ShaderProgram::set_int(&shader, "equirectangular_map", 0);
-    ShaderProgram::set_mat4(&shader, "projection_matrix", CAPTURE_PROJECTION);
-    // apply a scaling with .5 since code expects a 1x1x1 cube (our unit cube is 2x2x2)
-    ShaderProgram::set_mat4(&shader, "model_matrix", glm::scale(glm::identity<glm::mat4>(), glm::vec3(.5f)));
-
-    // find the previously obtained texture resource
-    Texture::bind_tex(resource_tex);
-
-    // hacky way to manually create mesh since we do not have access to a primitive manager instance
-    Primitive *skybox = FullPrimitive::create_skybox();
+    return sample_count;
+}
 
-    // save the current viewport dims to later restore it
-    GLfloat viewport_dims[4];
-    glGetFloatv(GL_VIEWPORT, viewport_dims);
+int Texture::create_pre_filtered_cubemap_from_cubemap(Texture *tex, Texture *resource_tex, uint32_t texture_unit)
+{
+    PreFilterPass pass{};
+    if (begin_pre_filter(&pass, tex, resource_tex, texture_unit) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
 
-    glViewport(0, 0, RES_X, RES_Y); // configure the viewport to the capture dimensions.
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    for (uint32_t i = 0; i < 6; i++) {
-        ShaderProgram::set_mat4(&shader, "view_matrix", CAPTURE_VIEWS[i]);
-        glFramebufferTexture2D(
-                GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, tex->tex_id, 0);
-        glClear((unsigned) GL_COLOR_BUFFER_BIT | (unsigned) GL_DEPTH_BUFFER_BIT);
+    // time every level on the GPU, the results are read once all levels are submitted
+    GLuint queries[PRE_FILTER_LEVEL_COUNT];
+    glGenQueries(PRE_FILTER_LEVEL_COUNT, queries);
+    for (uint32_t level = 0; level < PRE_FILTER_LEVEL_COUNT; level++) {
+        glBeginQuery(GL_TIME_ELAPSED, queries[level]);
+        render_pre_filter_level(&pass, level);
+        glEndQuery(GL_TIME_ELAPSED);
+    }
 
-        skybox->render_primitive();
+    for (uint32_t level = 0; level < PRE_FILTER_LEVEL_COUNT; level++) {
+        GLuint64 time;
+        glGetQueryObjectui64v(queries[level], GL_QUERY_RESULT, &time);
+        uint32_t resolution = pass.resolution >> level;
+        nm_log::log(LOG_INFO, "pre-filter level %d (%dx%d) took %.2f ms with %d samples per texel\n",
+                    level, resolution, resolution, (double) time * 1e-6, pass.sample_counts[level]);
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteQueries(PRE_FILTER_LEVEL_COUNT, queries);
 
-    // enable mipmap to later sample different levels in pre-filter map
-    glBindTexture(tex->texture_type, tex->tex_id);
-    glGenerateMipmap(tex->texture_type);
+    end_pre_filter(&pass);
 
-    // manually delete primitive since it has not been registered in a primitive manager instance
-    skybox->delete_primitive();
+    return EXIT_SUCCESS;
+}
 
-    // manually delete shader instance since it has not been registered in a shader manager instance
-    ShaderProgram::delete_shader_program(&shader);
+int Texture::begin_pre_filter(PreFilterPass *pass, Texture *tex, Texture *resource_tex, uint32_t texture_unit)
+{
+    const IblTier *tier = IblTier::get();
 
-    // restore viewport
-    glViewport(viewport_dims[0], viewport_dims[1], viewport_dims[2], viewport_dims[3]);
+    return begin_pre_filter(
+            pass, tex, resource_tex, texture_unit, tier->pre_filter_resolution, tier->pre_filter_format);
+}
 
-    tex->texture_unit = GL_TEXTURE0 + texture_unit;
+/** Preprocessor definitions of {pre_filter_map.frag} for the layout of the target and of the source. */
+static const char *get_pre_filter_defines(bool octahedral, bool octahedral_source)
+{
+    if (!octahedral) {
+        return octahedral_source ? "#define OCTAHEDRAL_SOURCE\n" : nullptr;
+    }
 
-    return EXIT_SUCCESS;
+    return octahedral_source ? "#define OCTAHEDRAL\n#define OCTAHEDRAL_SOURCE\n" : "#define OCTAHEDRAL\n";
 }
 
-int Texture::create_irradiance_cubemap_from_cubemap(Texture *tex, Texture *resource_tex, uint32_t texture_unit)
+int Texture::begin_pre_filter(
+        PreFilterPass *pass, Texture *tex, Texture *resource_tex, uint32_t texture_unit, uint32_t resolution,
+        GLenum internal_format)
 {
-    const uint32_t RES_X = 32;
-    const uint32_t RES_Y = 32;
+    bool octahedral = IblTier::get_layout() == IblTier::OCTAHEDRAL;
+    bool octahedral_source = resource_tex->texture_type == GL_TEXTURE_2D;
+    uint32_t face_count = octahedral ? 1 : 6;
+    resolution = IblTier::get_layout_resolution(resolution);
+
+    // hacky way to manually create shader since we do not have access to a shader manager instance. Created first,
+    // such that nothing else is allocated if it fails
+    const char *defines = get_pre_filter_defines(octahedral, octahedral_source);
+    const char *library_text = octahedral || octahedral_source ? octahedral_glsl : nullptr;
+    int rval;
+    if (octahedral) {
+        rval = ShaderProgram::create_shader_program(
+                &pass->shader, pre_filter_octahedral_vert, pre_filter_octahedral_vert_len, nullptr, 0,
+                pre_filter_map_frag, pre_filter_map_frag_len, defines, library_text, octahedral_glsl_len);
+    } else {
+        rval = ShaderProgram::create_shader_program(
+                &pass->shader, pre_filter_map_vert, pre_filter_map_vert_len, pre_filter_map_geom,
+                pre_filter_map_geom_len, pre_filter_map_frag, pre_filter_map_frag_len, defines, library_text,
+                octahedral_glsl_len);
+    }
+    if (rval == EXIT_FAILURE) {
+        nm_log::log(LOG_ERROR, "failed to create pre-filter shader program\n");
 
-    /** generate texture */
-    glGenTextures(1, &tex->tex_id);
-    tex->texture_type = GL_TEXTURE_CUBE_MAP;
-    glBindTexture(tex->texture_type, tex->tex_id);
+        return EXIT_FAILURE;
+    }
 
-    /** setup framebuffer */
-    GLuint captureFBO;
-    GLuint captureRBO;
-    glGenFramebuffers(1, &captureFBO);
-    glGenRenderbuffers(1, &captureRBO);
+    pass->tex = tex;
+    pass->resource_tex = resource_tex;
+    pass->resolution = resolution;
 
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, RES_X, RES_Y);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
+    // the sample levels depend on the resolution of the source
+    Texture::bind_tex(resource_tex);
+    GLint source_resolution;
+    glGetTexLevelParameteriv(
+            octahedral_source ? GL_TEXTURE_2D : GL_TEXTURE_CUBE_MAP_POSITIVE_X, 0, GL_TEXTURE_WIDTH,
+            &source_resolution);
+    GLint source_max_level;
+    glGetTexParameteriv(resource_tex->texture_type, GL_TEXTURE_MAX_LEVEL, &source_max_level);
+    Texture::unbind_tex(resource_tex);
+    uint32_t source_texel_count = (octahedral_source ? 1 : 6) * (uint32_t) (source_resolution * source_resolution);
+
+    // build the samples of all levels once, and upload them as a table with a row per level
+    TextureData sample_table{
+            GL_TEXTURE_2D, GL_RGBA32F, GL_RGBA, GL_FLOAT, PRE_FILTER_MAX_SAMPLE_COUNT, PRE_FILTER_LEVEL_COUNT, 1, 1,
+            {}};
+    sample_table.data.resize(sample_table.get_level_size(0));
+    for (uint32_t level = 0; level < PRE_FILTER_LEVEL_COUNT; level++) {
+        pass->sample_counts[level] = create_pre_filter_samples(&sample_table, level, source_texel_count);
+    }
+    create_tex_from_data(&pass->sample_table, &sample_table, 1, TextureManager::CLAMP);
 
-    /** setup cubemap to render to */
-    for (uint32_t i = 0; i < 6; i++) {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, RES_X, RES_Y, 0, GL_RGB, GL_FLOAT, nullptr);
+    /** setup cubemap or octahedral map to render to, with a level per roughness step */
+    glGenTextures(1, &tex->tex_id);
+    tex->texture_type = IblTier::get_texture_type();
+    tex->texture_unit = GL_TEXTURE0 + texture_unit;
+    glBindTexture(tex->texture_type, tex->tex_id);
+    for (uint32_t level = 0; level < PRE_FILTER_LEVEL_COUNT; level++) {
+        for (uint32_t face = 0; face < face_count; face++) {
+            glTexImage2D(octahedral ? GL_TEXTURE_2D : GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, (GLint) level,
+                         (GLint) internal_format, resolution >> level, resolution >> level, 0, GL_RGB, GL_FLOAT,
+                         nullptr);
+        }
     }
     glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(tex->texture_type, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    if (!octahedral) {
+        glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    }
+    // we can use trilinear filtering since we are using mipmaps
+    glTexParameteri(tex->texture_type, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(tex->texture_type, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(tex->texture_type, GL_TEXTURE_MAX_LEVEL, PRE_FILTER_LEVEL_COUNT - 1);
+    glBindTexture(tex->texture_type, 0);
 
-    /** convert HDR cubemap to irradiance cubemap equivalent */
-    // hacky way to manually create shader since we do not have access to a shader manager instance
-    ShaderProgram shader{};
-    ShaderProgram::create_shader_program(
-            &shader, irradiance_map_vert, irradiance_map_vert_len,
-            irradiance_map_frag, irradiance_map_frag_len);
-    ShaderProgram::use_shader_program(&shader);
-    ShaderProgram::set_int(&shader, "environment_map", 0);
-    ShaderProgram::set_mat4(&shader, "projection_matrix", CAPTURE_PROJECTION);
-    // apply a scaling with .5 since code expects a 1x1x1 cube (our unit cube is 2x2x2)
-    ShaderProgram::set_mat4(&shader, "model_matrix", glm::scale(glm::identity<glm::mat4>(), glm::vec3(.5f)));
-
-    // find the previously obtained texture resource
-    Texture::bind_tex(resource_tex);
+    /** setup framebuffer, without depth buffer since the inside of the skybox never overlaps itself */
+    glGenFramebuffers(1, &pass->capture_fbo);
+
+    ShaderProgram::use_shader_program(&pass->shader);
+    ShaderProgram::set_int(&pass->shader, "environment_map", (signed) resource_tex->texture_unit - GL_TEXTURE0);
+    ShaderProgram::set_int(&pass->shader, "sample_table", (signed) pass->sample_table.texture_unit - GL_TEXTURE0);
+    if (octahedral_source) {
+        // an octahedral source is filtered by the shader, which cannot query the levels it has
+        ShaderProgram::set_float(
+                &pass->shader, "max_source_lod",
+                fminf((float) source_max_level, floorf(log2f((float) source_resolution))));
+    }
+    if (!octahedral) {
+        ShaderProgram::set_mat4(&pass->shader, "projection_matrix", CAPTURE_PROJECTION);
+        for (uint32_t face = 0; face < 6; face++) {
+            char name[32];
+            snprintf(name, sizeof(name), "view_matrices[%d]", face);
+            ShaderProgram::set_mat4(&pass->shader, name, CAPTURE_VIEWS[face]);
+        }
+        // apply a scaling with .5 since code expects a 1x1x1 cube (our unit cube is 2x2x2)
+        ShaderProgram::set_mat4(
+                &pass->shader, "model_matrix", glm::scale(glm::identity<glm::mat4>(), glm::vec3(.5f)));
+    }
+    ShaderProgram::unuse_shader_program();
+
+    if (octahedral) {
+        // the triangle covering the octahedral map is generated from the vertex id, core profile still needs a vao
+        pass->skybox = nullptr;
+        glGenVertexArrays(1, &pass->vertex_array);
+    } else {
+        // hacky way to manually create mesh since we do not have access to a primitive manager instance
+        pass->skybox = FullPrimitive::create_skybox();
+        pass->vertex_array = 0;
+    }
+
+    return EXIT_SUCCESS;
+}
 
-    // hacky way to manually create mesh since we do not have access to a primitive manager instance
-    Primitive *skybox = FullPrimitive::create_skybox();
+void Texture::render_pre_filter_level(PreFilterPass *pass, uint32_t level)
+{
+    uint32_t resolution = pass->resolution >> level;
 
     // save the current viewport dims to later restore it
     GLfloat viewport_dims[4];
     glGetFloatv(GL_VIEWPORT, viewport_dims);
 
-    glViewport(0, 0, RES_X, RES_Y); // configure the viewport to the capture dimensions.
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    for (uint32_t i = 0; i < 6; i++) {
-        ShaderProgram::set_mat4(&shader, "view_matrix", CAPTURE_VIEWS[i]);
-        glFramebufferTexture2D(
-                GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, tex->tex_id, 0);
-        glClear((unsigned) GL_COLOR_BUFFER_BIT | (unsigned) GL_DEPTH_BUFFER_BIT);
-
-        skybox->render_primitive();
+    // attach all faces of the level as layers, the geometry shader routes the skybox to each of them. an octahedral
+    // map has a single layer
+    glBindFramebuffer(GL_FRAMEBUFFER, pass->capture_fbo);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, pass->tex->tex_id, (GLint) level);
+    glViewport(0, 0, resolution, resolution);
+
+    // levels may be rendered in between other passes, so all state is set every time
+    ShaderProgram::use_shader_program(&pass->shader);
+    ShaderProgram::set_int(&pass->shader, "level", (int) level);
+    ShaderProgram::set_int(&pass->shader, "sample_count", (int) pass->sample_counts[level]);
+    Texture::bind_tex(pass->resource_tex);
+    Texture::bind_tex(&pass->sample_table);
+
+    // clears all layers
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (pass->skybox) {
+        pass->skybox->render_primitive();
+    } else {
+        glBindVertexArray(pass->vertex_array);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
     }
+
+    Texture::unbind_tex(&pass->sample_table);
+    Texture::unbind_tex(pass->resource_tex);
+    ShaderProgram::unuse_shader_program();
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+    // restore viewport
+    glViewport(viewport_dims[0], viewport_dims[1], viewport_dims[2], viewport_dims[3]);
+}
+
+void Texture::end_pre_filter(PreFilterPass *pass)
+{
+    glDeleteFramebuffers(1, &pass->capture_fbo);
+    Texture::delete_tex(&pass->sample_table);
+
     // manually delete primitive since it has not been registered in a primitive manager instance
-    skybox->delete_primitive();
+    if (pass->skybox) {
+        pass->skybox->delete_primitive();
+        delete pass->skybox;
+    } else {
+        glDeleteVertexArrays(1, &pass->vertex_array);
+    }
 
     // manually delete shader instance since it has not been registered in a shader manager instance
-    ShaderProgram::delete_shader_program(&shader);
+    ShaderProgram::delete_shader_program(&pass->shader);
+}
 
-    // restore viewport
-    glViewport(viewport_dims[0], viewport_dims[1], viewport_dims[2], viewport_dims[3]);
+int Texture::get_generator_info(int (*create_function)(Texture *, Texture *, uint32_t), GeneratorInfo *info)
+{
+    if (create_function == &create_pre_filtered_cubemap_from_cubemap) {
+        // the environment the pre-filter is generated from has the same layout
+        const IblTier *tier = IblTier::get();
+        uint32_t resolution = IblTier::get_layout_resolution(tier->pre_filter_resolution);
+        if (IblTier::get_layout() == IblTier::OCTAHEDRAL) {
+            *info = {"pre_filter", resolution, tier->pre_filter_format, PRE_FILTER_LEVEL_COUNT,
+                     PRE_FILTER_MAX_SAMPLE_COUNT, PRE_FILTER_VERSION,
+                     pre_filter_octahedral_vert, &pre_filter_octahedral_vert_len, nullptr, nullptr,
+                     pre_filter_map_frag, &pre_filter_map_frag_len, get_pre_filter_defines(true, true),
+                     octahedral_glsl, &octahedral_glsl_len};
+        } else {
+            *info = {"pre_filter", resolution, tier->pre_filter_format, PRE_FILTER_LEVEL_COUNT,
+                     PRE_FILTER_MAX_SAMPLE_COUNT, PRE_FILTER_VERSION,
+                     pre_filter_map_vert, &pre_filter_map_vert_len, pre_filter_map_geom, &pre_filter_map_geom_len,
+                     pre_filter_map_frag, &pre_filter_map_frag_len, nullptr, nullptr, nullptr};
+        }
+    } else {
+        nm_log::log(LOG_ERROR, "unknown texture generating function\n");
 
-    tex->texture_unit = GL_TEXTURE0 + texture_unit;
+        return EXIT_FAILURE;
+    }
 
     return EXIT_SUCCESS;
 }
 
-int Texture::create_pre_filtered_cubemap_from_cubemap(Texture *tex, Texture *resource_tex, uint32_t texture_unit)
+int Texture::create_tex_from_data(
+        Texture *tex, const TextureData *data, uint32_t texture_unit, TextureManager::WrapType wrap_type)
+{
+    allocate_tex_from_data(tex, data, texture_unit, wrap_type);
+    for (uint32_t level = 0; level < data->level_count; level++) {
+        for (uint32_t face = 0; face < data->face_count; face++) {
+            upload_tex_face(tex, data, level, face);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int Texture::allocate_tex_from_data(
+        Texture *tex, const TextureData *data, uint32_t texture_unit, TextureManager::WrapType wrap_type)
 {
-    const uint32_t RES_X = 128;
-    const uint32_t RES_Y = 128;
+    tex->texture_type = data->texture_type;
 
     glGenTextures(1, &tex->tex_id);
-    tex->texture_type = GL_TEXTURE_CUBE_MAP;
     glBindTexture(tex->texture_type, tex->tex_id);
 
-    /** setup framebuffer */
-    GLuint captureFBO;
-    GLuint captureRBO;
-    glGenFramebuffers(1, &captureFBO);
-    glGenRenderbuffers(1, &captureRBO);
+    GLint wrap = wrap_type == TextureManager::REPEAT ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+    glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_S, wrap);
+    glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_T, wrap);
+    glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_R, wrap);
+    glTexParameteri(
+            tex->texture_type, GL_TEXTURE_MIN_FILTER, data->level_count > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(tex->texture_type, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // only the stored levels are defined, limit sampling to them to keep the texture complete
+    glTexParameteri(tex->texture_type, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(tex->texture_type, GL_TEXTURE_MAX_LEVEL, (GLint) data->level_count - 1);
+
+    for (uint32_t level = 0; level < data->level_count; level++) {
+        for (uint32_t face = 0; face < data->face_count; face++) {
+            GLenum target = data->texture_type == GL_TEXTURE_CUBE_MAP ?
+                            GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : data->texture_type;
+            glTexImage2D(
+                    target, (GLint) level, (GLint) data->internal_format,
+                    data->get_level_width(level), data->get_level_height(level), 0, data->format, data->type,
+                    nullptr);
+        }
+    }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-    // {glRenderbufferStorage} is performed later due to changing framebuffer sizes
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
+    tex->texture_unit = GL_TEXTURE0 + texture_unit;
+    glBindTexture(tex->texture_type, 0);
 
-    /** setup cubemap to render to and attach to framebuffer */
-    for (uint32_t i = 0; i < 6; i++) {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, RES_X, RES_Y, 0, GL_RGB, GL_FLOAT, nullptr);
-    }
-    glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(tex->texture_type, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    // we can use trilinear filtering since we are using mipmaps
-    glTexParameteri(tex->texture_type, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(tex->texture_type, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return EXIT_SUCCESS;
+}
 
-    glGenerateMipmap(tex->texture_type); // this cubemap is mipmapped, with increasing roughness values
-
-    /** convert HDR cubemap to pre-filter cubemap equivalent */
-    // hacky way to manually create shader since we do not have access to a shader manager instance
-    ShaderProgram shader{};
-    ShaderProgram::create_shader_program(
-            &shader, pre_filter_map_vert, pre_filter_map_vert_len,
-            pre_filter_map_frag, pre_filter_map_frag_len);
-    ShaderProgram::use_shader_program(&shader);
-    ShaderProgram::set_int(&shader, "environment_map", 0);
-    ShaderProgram::set_mat4(&shader, "projection_matrix", CAPTURE_PROJECTION);
-    // apply a scaling with .5 since code expects a 1x1x1 cube (our unit cube is 2x2x2)
-    ShaderProgram::set_mat4(&shader, "model_matrix", glm::scale(glm::identity<glm::mat4>(), glm::vec3(.5f)));
-
-    // find the previously obtained texture resource
-    Texture::bind_tex(resource_tex);
+void Texture::upload_tex_face(Texture *tex, const TextureData *data, uint32_t level, uint32_t face)
+{
+    glBindTexture(tex->texture_type, tex->tex_id);
 
-    // hacky way to manually create mesh since we do not have access to a primitive manager instance
-    Primitive *skybox = FullPrimitive::create_skybox();
+    // rows of small levels are not 4-byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    GLenum target = data->texture_type == GL_TEXTURE_CUBE_MAP ?
+                    GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : data->texture_type;
+    glTexSubImage2D(
+            target, (GLint) level, 0, 0, data->get_level_width(level), data->get_level_height(level), data->format,
+            data->type, data->get_pixels(level, face));
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
-    // save the current viewport dims to later restore it
-    GLfloat viewport_dims[4];
-    glGetFloatv(GL_VIEWPORT, viewport_dims);
+    glBindTexture(tex->texture_type, 0);
+}
 
-    const uint32_t MAX_MIP_LEVELS = 5;
-    uint32_t mip_width = RES_X;
-    uint32_t mip_height = RES_Y;
-    for (uint32_t mip = 0; mip < MAX_MIP_LEVELS; mip++) {
-        // resize framebuffer according to mip-level size
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mip_width, mip_height);
-        glViewport(0, 0, mip_width, mip_height);
-
-        float roughness = (float) mip / (float) (MAX_MIP_LEVELS - 1);
-        ShaderProgram::set_float(&shader, "roughness", roughness);
-        for (uint32_t i = 0; i < 6; i++) {
-            ShaderProgram::set_mat4(&shader, "view_matrix", CAPTURE_VIEWS[i]);
-            glFramebufferTexture2D(
-                    GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, tex->tex_id, mip);
-            glClear((unsigned) GL_COLOR_BUFFER_BIT | (unsigned) GL_DEPTH_BUFFER_BIT);
-
-            skybox->render_primitive();
-        }
+int Texture::read_tex(Texture *tex, TextureData *data, uint32_t level_count)
+{
+    glBindTexture(tex->texture_type, tex->tex_id);
 
-        mip_width /= 2;
-        mip_height /= 2;
+    GLenum level_target = tex->texture_type == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : tex->texture_type;
+    GLint internal_format, width, height;
+    glGetTexLevelParameteriv(level_target, 0, GL_TEXTURE_INTERNAL_FORMAT, &internal_format);
+    glGetTexLevelParameteriv(level_target, 0, GL_TEXTURE_WIDTH, &width);
+    glGetTexLevelParameteriv(level_target, 0, GL_TEXTURE_HEIGHT, &height);
+
+    if (level_count == 0) {
+        for (GLint size = width > height ? width : height; size > 0; size >>= 1) {
+            level_count++;
+        }
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    // manually delete primitive since it has not been registered in a primitive manager instance
-    skybox->delete_primitive();
+    data->texture_type = tex->texture_type;
+    data->internal_format = (GLenum) internal_format;
+    data->width = (uint32_t) width;
+    data->height = (uint32_t) height;
+    data->level_count = level_count;
+    data->face_count = tex->texture_type == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+    if (TextureData::get_transfer_format(data->internal_format, &data->format, &data->type) == EXIT_FAILURE) {
+        glBindTexture(tex->texture_type, 0);
 
-    // manually delete shader instance since it has not been registered in a shader manager instance
-    ShaderProgram::delete_shader_program(&shader);
+        return EXIT_FAILURE;
+    }
 
-    // restore viewport
-    glViewport(viewport_dims[0], viewport_dims[1], viewport_dims[2], viewport_dims[3]);
+    size_t size = 0;
+    for (uint32_t level = 0; level < level_count; level++) {
+        size += data->get_level_size(level) * data->face_count;
+    }
+    data->data.resize(size);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    for (uint32_t level = 0; level < level_count; level++) {
+        for (uint32_t face = 0; face < data->face_count; face++) {
+            GLenum target = tex->texture_type == GL_TEXTURE_CUBE_MAP ?
+                            GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : tex->texture_type;
+            glGetTexImage(
+                    target, (GLint) level, data->format, data->type,
+                    data->get_pixels(level, face));
+        }
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
 
-    tex->texture_unit = GL_TEXTURE0 + texture_unit;
+    glBindTexture(tex->texture_type, 0);
 
     return EXIT_SUCCESS;
 }
@@ -5,6 +5,13 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "../manager/texture_manager.hpp"
+#include "shader.hpp"
+#include "ibl_tier.hpp"
+#include "texture_data.hpp"
+
+struct PreFilterPass;
+
+class Primitive;
 
 class Texture {
 public:
@@ -15,34 +22,140 @@ public:
     /** Type: GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP */
     GLenum texture_type;
 
+    /**
+     * Sets the global state of stb_image.h that decoding relies on. Must be called once before any image is decoded,
+     * and before images are decoded on other threads. */
+    static void initialize_decoding();
+
+    /**
+     * Queries the extensions that provide the block compressed formats core OpenGL lacks. Must be called once with a
+     * context current, before {is_format_supported} is called on any thread. */
+    static void initialize_formats();
+
+    /** Returns whether textures of {internal_format} can be uploaded, see {initialize_formats}. */
+    static bool is_format_supported(GLenum internal_format);
+
     /** Reads a file from disk into memory, calls {create_tex_from_mem} on that memory and deallocates the memory. */
     static int create_tex_from_file(
-            Texture *tex, const char *tex_file,
-            uint32_t channel_count, uint32_t bit_depth, uint32_t texture_unit, TextureManager::ChannelType channel_type,
+            Texture *tex, const char *tex_file, TextureManager::Semantic semantic, uint32_t texture_unit,
             TextureManager::WrapType wrap_type);
 
     /** Uses stbi_image.h to read in texture data from memory and create a {GL_TEXTURE_2D} from it. */
     static int create_tex_from_mem(
-            Texture *tex, const char *tex_data, size_t tex_len,
-            uint32_t channel_count, uint32_t bit_depth, uint32_t texture_unit, TextureManager::ChannelType channel_type,
-            TextureManager::WrapType wrap_type);
+            Texture *tex, const char *tex_data, size_t tex_len, TextureManager::Semantic semantic,
+            uint32_t texture_unit, TextureManager::WrapType wrap_type);
+
+    /**
+     * The CPU half of {create_tex_from_mem}, decodes the image into a single level of {data} in the format that
+     * {semantic} is stored in. Does not touch OpenGL state and may be called from any thread. */
+    static int decode_tex(
+            TextureData *data, const char *tex_data, size_t tex_len, TextureManager::Semantic semantic);
 
-    /** Creates a {GL_TEXTURE2D} which is a 2D LUT for the BRDF equations used. */
-    static int create_tex_from_tex(Texture *tex, Texture *resource_tex, uint32_t texture_unit);
+    /**
+     * Decodes the image into a single level of {data} with {channel_count} channels of {bit_depth} bits, 32 bits
+     * being floating point. The internal format is left to the driver. Used to prepare images at full precision. */
+    static int decode_image(
+            TextureData *data, const char *tex_data, size_t tex_len, uint32_t channel_count, uint32_t bit_depth);
+
+    /**
+     * The OpenGL half of {create_tex_from_mem}, creates a mipmapped {GL_TEXTURE_2D} from decoded {data}. The mip chain
+     * is generated unless {data} already holds it. */
+    static int upload_tex(
+            Texture *tex, const TextureData *data, uint32_t texture_unit, TextureManager::WrapType wrap_type);
+
+    /**
+     * Steps of {upload_tex} for uploading in parts: {allocate_tex} creates the texture and all levels of {data}
+     * without pixels, {upload_tex_rows} uploads {row_count} rows of {level} starting at {first_row}, and
+     * {generate_mipmap_tex} completes it by generating the mip chain if {data} does not provide one.
+     * Rows are those of {TextureData::get_row_count}, rows of blocks if {data} is compressed.
+     * {pixels} is an offset into the bound {GL_PIXEL_UNPACK_BUFFER} if there is one. */
+    static int allocate_tex(
+            Texture *tex, const TextureData *data, uint32_t texture_unit, TextureManager::WrapType wrap_type);
+
+    static void upload_tex_rows(
+            Texture *tex, const TextureData *data, uint32_t level, uint32_t first_row, uint32_t row_count,
+            const void *pixels);
+
+    static void generate_mipmap_tex(Texture *tex, const TextureData *data);
+
+    /** Creates a 1x1 {GL_TEXTURE_2D} with RGBA {color}, shown in place of a texture that is still streaming in. */
+    static int create_placeholder_tex(Texture *tex, const uint8_t *color, uint32_t texture_unit);
 
     /** Projection and view matrices for capturing data onto the 6 cubemap face directions. */
     static const glm::mat4 CAPTURE_PROJECTION;
     static const glm::mat4 CAPTURE_VIEWS[];
 
-    /** Creates a {GL_TEXTURE_CUBE_MAP} from {resource_tex}. */
-    static int create_cubemap_from_tex(Texture *tex, Texture *resource_tex, uint32_t texture_unit);
-
-    /** Creates a {GL_TEXTURE_CUBE_MAP} which is the irradiance calculated from {resource_tex}. */
-    static int create_irradiance_cubemap_from_cubemap(Texture *tex, Texture *resource_tex, uint32_t texture_unit);
+    /** Number of mip levels of the pre-filter cubemap, one per roughness step. */
+    static const uint32_t PRE_FILTER_LEVEL_COUNT = 5;
 
-    /** Creates a {GL_TEXTURE_CUBE_MAP} which is the pre-filter calculated from {resource_tex}. */
+    /**
+     * Creates a {GL_TEXTURE_CUBE_MAP}, or an octahedral {GL_TEXTURE_2D}, which is the pre-filter calculated from
+     * {resource_tex}, with the layout, resolution and format of the selected {IblTier}. The source may be either. */
     static int create_pre_filtered_cubemap_from_cubemap(Texture *tex, Texture *resource_tex, uint32_t texture_unit);
 
+    /**
+     * Steps of {create_pre_filtered_cubemap_from_cubemap} for rendering in parts: {begin_pre_filter} creates {tex}
+     * without pixels and the resources of {pass}, {render_pre_filter_level} renders all faces of {level} in a single
+     * draw into a layered attachment, or the octahedral map as a single triangle, and {end_pre_filter} deletes the
+     * resources of {pass}. Levels may be rendered in
+     * any order and in between other passes, {resource_tex} must be kept until all are rendered. Levels may also be
+     * rendered again after {resource_tex} changed, as long as its resolution stays the same. */
+    static int begin_pre_filter(PreFilterPass *pass, Texture *tex, Texture *resource_tex, uint32_t texture_unit);
+
+    /**
+     * Like above, but with a face {resolution} and {internal_format} of {tex} other than those of the {IblTier}. The
+     * layout is that of the {IblTier}. */
+    static int begin_pre_filter(
+            PreFilterPass *pass, Texture *tex, Texture *resource_tex, uint32_t texture_unit, uint32_t resolution,
+            GLenum internal_format);
+
+    static void render_pre_filter_level(PreFilterPass *pass, uint32_t level);
+
+    static void end_pre_filter(PreFilterPass *pass);
+
+    /** Everything a generated texture depends on besides its source texture, used to key cached results. */
+    struct GeneratorInfo {
+        const char *name;
+        uint32_t resolution;
+        GLenum internal_format;
+        /** Number of meaningful levels, 0 for the full mip chain. */
+        uint32_t level_count;
+        /** Number of samples taken per texel by the roughest level, 0 if the pass does not sample. */
+        uint32_t max_sample_count;
+        /** Bumped whenever the samples or other inputs the pass computes on the CPU change. */
+        uint32_t version;
+        /** Shaders used by the generating pass. */
+        const char *vert_text;
+        const size_t *vert_len;
+        const char *geom_text;
+        const size_t *geom_len;
+        const char *frag_text;
+        const size_t *frag_len;
+        /** Preprocessor definitions the shaders are compiled with, null if none. */
+        const char *defines;
+        /** Functions inserted after {defines}, null if none. */
+        const char *library_text;
+        const size_t *library_len;
+    };
+
+    /** Looks up the {GeneratorInfo} of one of the generating functions above. */
+    static int get_generator_info(int (*create_function)(Texture *, Texture *, uint32_t), GeneratorInfo *info);
+
+    /** Creates a texture from previously generated {data}, uploading all of its levels and faces as-is. */
+    static int create_tex_from_data(
+            Texture *tex, const TextureData *data, uint32_t texture_unit, TextureManager::WrapType wrap_type);
+
+    /**
+     * Steps of {create_tex_from_data} for uploading in parts: {allocate_tex_from_data} creates the texture and all
+     * levels and faces of {data} without pixels, {upload_tex_face} uploads a single face of {level}. */
+    static int allocate_tex_from_data(
+            Texture *tex, const TextureData *data, uint32_t texture_unit, TextureManager::WrapType wrap_type);
+
+    static void upload_tex_face(Texture *tex, const TextureData *data, uint32_t level, uint32_t face);
+
+    /** Reads back the first {level_count} levels of {tex} into {data}, 0 reads back the full mip chain. */
+    static int read_tex(Texture *tex, TextureData *data, uint32_t level_count);
+
     static void bind_tex(Texture *tex);
 
     /** Unbinds the current texture. */
@@ -51,4 +164,20 @@ public:
     static void delete_tex(Texture *tex);
 };
 
+/** A pre-filter cubemap that is rendered a level at a time, see {Texture::begin_pre_filter}. */
+struct PreFilterPass {
+    Texture *tex;
+    Texture *resource_tex;
+    /** Resolution of the first level of {tex}. */
+    uint32_t resolution;
+    /** Samples of all levels, a row per level, and the number of samples in each row. */
+    Texture sample_table;
+    uint32_t sample_counts[Texture::PRE_FILTER_LEVEL_COUNT];
+    ShaderProgram shader;
+    /** Skybox routed to the faces of a cubemap, or a vertex array without attributes for an octahedral map. */
+    Primitive *skybox;
+    GLuint vertex_array;
+    GLuint capture_fbo;
+};
+
 #endif //SYSTEM_TEXTURE_HPP
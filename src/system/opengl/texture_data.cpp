@@ -0,0 +1,540 @@
+#include "texture_data.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#include "../../util/nm_log.hpp"
+
+/** On-disk header preceding the pixels, all fields are stored as 32 bit unsigned integers. */
+struct TextureDataHeader {
+    uint32_t texture_type;
+    uint32_t internal_format;
+    uint32_t format;
+    uint32_t type;
+    uint32_t width;
+    uint32_t height;
+    uint32_t level_count;
+    uint32_t face_count;
+    uint64_t size;
+};
+
+uint32_t TextureData::get_pixel_size(GLenum format, GLenum type)
+{
+    uint32_t components;
+    switch (format) {
+        case GL_RED:
+            components = 1;
+            break;
+        case GL_RG:
+            components = 2;
+            break;
+        case GL_RGB:
+            components = 3;
+            break;
+        case GL_RGBA:
+        default:
+            components = 4;
+    }
+
+    switch (type) {
+        case GL_UNSIGNED_INT_5_9_9_9_REV:
+        case GL_UNSIGNED_INT_10F_11F_11F_REV:
+            // all channels packed in a single integer
+            return 4;
+        case GL_UNSIGNED_BYTE:
+            return components;
+        case GL_UNSIGNED_SHORT:
+        case GL_HALF_FLOAT:
+            return components * 2;
+        case GL_FLOAT:
+        default:
+            return components * 4;
+    }
+}
+
+int TextureData::get_transfer_format(GLenum internal_format, GLenum *format, GLenum *type)
+{
+    switch (internal_format) {
+        case GL_RG16F:
+            *format = GL_RG;
+            *type = GL_HALF_FLOAT;
+            break;
+        case GL_RGB16F:
+            *format = GL_RGB;
+            *type = GL_HALF_FLOAT;
+            break;
+        case GL_RGBA16F:
+            *format = GL_RGBA;
+            *type = GL_HALF_FLOAT;
+            break;
+        case GL_RGB9_E5:
+            *format = GL_RGB;
+            *type = GL_UNSIGNED_INT_5_9_9_9_REV;
+            break;
+        case GL_R11F_G11F_B10F:
+            *format = GL_RGB;
+            *type = GL_UNSIGNED_INT_10F_11F_11F_REV;
+            break;
+        default:
+            nm_log::log(LOG_ERROR, "no transfer format known for internal format \"%d\"\n", internal_format);
+
+            return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+uint32_t TextureData::get_block_size(GLenum internal_format)
+{
+    switch (internal_format) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RED_RGTC1:
+            return 8;
+        case GL_COMPRESSED_RG_RGTC2:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+bool TextureData::is_compressed() const
+{
+    return get_block_size(internal_format) != 0;
+}
+
+uint32_t TextureData::get_level_width(uint32_t level) const
+{
+    return width >> level ? width >> level : 1;
+}
+
+uint32_t TextureData::get_level_height(uint32_t level) const
+{
+    return height >> level ? height >> level : 1;
+}
+
+uint32_t TextureData::get_row_count(uint32_t level) const
+{
+    if (is_compressed()) {
+        return (get_level_height(level) + 3) / 4;
+    }
+
+    return get_level_height(level);
+}
+
+size_t TextureData::get_row_size(uint32_t level) const
+{
+    if (is_compressed()) {
+        return (size_t) (get_level_width(level) + 3) / 4 * get_block_size(internal_format);
+    }
+
+    return (size_t) get_level_width(level) * get_pixel_size(format, type);
+}
+
+size_t TextureData::get_level_size(uint32_t level) const
+{
+    return get_row_count(level) * get_row_size(level);
+}
+
+const uint8_t *TextureData::get_pixels(uint32_t level, uint32_t face) const
+{
+    size_t offset = 0;
+    for (uint32_t i = 0; i < level; i++) {
+        offset += get_level_size(i) * face_count;
+    }
+    offset += get_level_size(level) * face;
+
+    return data.data() + offset;
+}
+
+uint8_t *TextureData::get_pixels(uint32_t level, uint32_t face)
+{
+    return const_cast<uint8_t *>(static_cast<const TextureData *>(this)->get_pixels(level, face));
+}
+
+int TextureData::pack_channels(TextureData *packed, const TextureData *const *channels, uint32_t channel_count)
+{
+    const TextureData *first = nullptr;
+    GLenum type = GL_UNSIGNED_BYTE;
+    for (uint32_t i = 0; i < channel_count; i++) {
+        if (!channels[i]) {
+            continue;
+        }
+        if (!first) {
+            first = channels[i];
+        }
+        if (channels[i]->is_compressed() || channels[i]->face_count != 1 || channels[i]->level_count != 1 ||
+            channels[i]->width != first->width || channels[i]->height != first->height ||
+            (channels[i]->type != GL_UNSIGNED_BYTE && channels[i]->type != GL_UNSIGNED_SHORT)) {
+            nm_log::log(LOG_ERROR, "channels to pack do not have equal dimensions and integer type\n");
+
+            return EXIT_FAILURE;
+        }
+        if (channels[i]->type == GL_UNSIGNED_SHORT) {
+            type = GL_UNSIGNED_SHORT;
+        }
+    }
+    if (!first || channel_count < 1 || channel_count > 4) {
+        nm_log::log(LOG_ERROR, "cannot pack %d channels\n", channel_count);
+
+        return EXIT_FAILURE;
+    }
+
+    // all channels get the precision of the most precise source
+    static const GLenum FORMATS[] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+    static const GLenum INTERNAL_FORMATS_8[] = {GL_R8, GL_RG8, GL_RGB8, GL_RGBA8};
+    static const GLenum INTERNAL_FORMATS_16[] = {GL_R16, GL_RG16, GL_RGB16, GL_RGBA16};
+    packed->texture_type = GL_TEXTURE_2D;
+    packed->internal_format = (type == GL_UNSIGNED_SHORT ? INTERNAL_FORMATS_16 : INTERNAL_FORMATS_8)[channel_count - 1];
+    packed->format = FORMATS[channel_count - 1];
+    packed->type = type;
+    packed->width = first->width;
+    packed->height = first->height;
+    packed->level_count = 1;
+    packed->face_count = 1;
+    packed->data.assign(packed->get_level_size(0), 0);
+
+    // copy the first channel of every source, widening 8 bit values to 16 bits if needed
+    size_t pixel_count = (size_t) first->width * first->height;
+    for (uint32_t i = 0; i < channel_count; i++) {
+        if (!channels[i]) {
+            continue;
+        }
+        uint32_t pixel_size = get_pixel_size(channels[i]->format, channels[i]->type);
+        for (size_t j = 0; j < pixel_count; j++) {
+            const uint8_t *source = &channels[i]->data[j * pixel_size];
+            if (type == GL_UNSIGNED_BYTE) {
+                packed->data[j * channel_count + i] = *source;
+                continue;
+            }
+            uint16_t value;
+            if (channels[i]->type == GL_UNSIGNED_SHORT) {
+                memcpy(&value, source, sizeof(value));
+            } else {
+                value = (uint16_t) (*source * 257);
+            }
+            memcpy(&packed->data[(j * channel_count + i) * sizeof(value)], &value, sizeof(value));
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+uint16_t TextureData::float_to_half(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    auto sign = (uint16_t) (bits >> 16 & 0x8000);
+    bits &= 0x7fffffff;
+
+    // largest finite half float
+    const uint32_t HALF_MAX_BITS = 0x477fe000;
+    if (bits > HALF_MAX_BITS) {
+        bits = HALF_MAX_BITS;
+    }
+
+    if (bits < 113u << 23) {
+        // below the smallest normal half float, let the addition of a magic number do the rounding
+        const uint32_t DENORM_MAGIC_BITS = ((127 - 15) + (23 - 10) + 1) << 23;
+        float magnitude, magic;
+        memcpy(&magnitude, &bits, sizeof(magnitude));
+        memcpy(&magic, &DENORM_MAGIC_BITS, sizeof(magic));
+        magnitude += magic;
+        memcpy(&bits, &magnitude, sizeof(bits));
+
+        return (uint16_t) (sign | (bits - DENORM_MAGIC_BITS));
+    }
+
+    uint32_t mantissa_odd = bits >> 13 & 1;
+    bits += ((uint32_t) (15 - 127) << 23) + 0xfff + mantissa_odd;
+
+    return (uint16_t) (sign | bits >> 13);
+}
+
+float TextureData::half_to_float(uint16_t half)
+{
+    // move exponent and mantissa into place and rebias the exponent, after which only the extremes need fixing
+    const uint32_t SHIFTED_EXPONENT = 0x7c00u << 13;
+    uint32_t bits = (uint32_t) (half & 0x7fff) << 13;
+    uint32_t exponent = bits & SHIFTED_EXPONENT;
+    bits += (127 - 15) << 23;
+
+    float value;
+    if (exponent == SHIFTED_EXPONENT) {
+        // infinity or NaN
+        bits += (128 - 16) << 23;
+        memcpy(&value, &bits, sizeof(value));
+    } else if (exponent == 0) {
+        // denormal, renormalize by subtracting the implicit one
+        const uint32_t MAGIC_BITS = 113u << 23;
+        float magic;
+        memcpy(&magic, &MAGIC_BITS, sizeof(magic));
+        bits += 1 << 23;
+        memcpy(&value, &bits, sizeof(value));
+        value -= magic;
+    } else {
+        memcpy(&value, &bits, sizeof(value));
+    }
+
+    return half & 0x8000 ? -value : value;
+}
+
+/** Bits of mantissa of {GL_RGB9_E5}, and the bias and maximum of its exponent. */
+static const int RGB9_E5_MANTISSA_BITS = 9;
+static const int RGB9_E5_EXPONENT_BIAS = 15;
+static const int RGB9_E5_EXPONENT_MAX = 31;
+
+uint32_t TextureData::float_to_rgb9_e5(const float *rgb)
+{
+    // (https://registry.khronos.org/OpenGL/extensions/EXT/EXT_texture_shared_exponent.txt)
+    const float MAX_VALUE = (float) ((1 << RGB9_E5_MANTISSA_BITS) - 1) / (float) (1 << RGB9_E5_MANTISSA_BITS) *
+                            (float) (1 << (RGB9_E5_EXPONENT_MAX - RGB9_E5_EXPONENT_BIAS));
+
+    float clamped[3];
+    float max = 0.f;
+    for (uint32_t c = 0; c < 3; c++) {
+        // also maps NaN to zero
+        clamped[c] = rgb[c] > 0.f ? (rgb[c] < MAX_VALUE ? rgb[c] : MAX_VALUE) : 0.f;
+        max = clamped[c] > max ? clamped[c] : max;
+    }
+
+    // the shared exponent is that of the largest channel, frexpf returns one more than floor(log2(max))
+    int exponent = -RGB9_E5_EXPONENT_BIAS;
+    if (max > 0.f) {
+        frexpf(max, &exponent);
+        exponent = exponent > -RGB9_E5_EXPONENT_BIAS ? exponent : -RGB9_E5_EXPONENT_BIAS;
+    }
+    int shared_exponent = exponent + RGB9_E5_EXPONENT_BIAS;
+
+    // rounding the largest channel up may overflow its mantissa, which takes the next exponent
+    float scale = ldexpf(1.f, RGB9_E5_MANTISSA_BITS - exponent);
+    if ((uint32_t) floorf(max * scale + .5f) == 1u << RGB9_E5_MANTISSA_BITS) {
+        shared_exponent++;
+        scale *= .5f;
+    }
+
+    uint32_t packed = (uint32_t) shared_exponent << 27;
+    for (uint32_t c = 0; c < 3; c++) {
+        packed |= (uint32_t) floorf(clamped[c] * scale + .5f) << (c * RGB9_E5_MANTISSA_BITS);
+    }
+
+    return packed;
+}
+
+void TextureData::rgb9_e5_to_float(uint32_t packed, float *rgb)
+{
+    int exponent = (int) (packed >> 27) - RGB9_E5_EXPONENT_BIAS - RGB9_E5_MANTISSA_BITS;
+    for (uint32_t c = 0; c < 3; c++) {
+        rgb[c] = ldexpf((float) (packed >> (c * RGB9_E5_MANTISSA_BITS) & 0x1ffu), exponent);
+    }
+}
+
+void TextureData::read_rgb(GLenum type, const uint8_t *pixel, float *rgb)
+{
+    switch (type) {
+        case GL_UNSIGNED_INT_5_9_9_9_REV: {
+            uint32_t packed;
+            memcpy(&packed, pixel, sizeof(packed));
+            rgb9_e5_to_float(packed, rgb);
+            break;
+        }
+        case GL_HALF_FLOAT:
+            for (uint32_t c = 0; c < 3; c++) {
+                uint16_t half;
+                memcpy(&half, pixel + c * sizeof(half), sizeof(half));
+                rgb[c] = half_to_float(half);
+            }
+            break;
+        case GL_FLOAT:
+        default:
+            memcpy(rgb, pixel, 3 * sizeof(float));
+    }
+}
+
+void TextureData::write_rgb(GLenum type, const float *rgb, uint8_t *pixel)
+{
+    switch (type) {
+        case GL_UNSIGNED_INT_5_9_9_9_REV: {
+            uint32_t packed = float_to_rgb9_e5(rgb);
+            memcpy(pixel, &packed, sizeof(packed));
+            break;
+        }
+        case GL_HALF_FLOAT:
+            for (uint32_t c = 0; c < 3; c++) {
+                uint16_t half = float_to_half(rgb[c]);
+                memcpy(pixel + c * sizeof(half), &half, sizeof(half));
+            }
+            break;
+        case GL_FLOAT:
+        default:
+            memcpy(pixel, rgb, 3 * sizeof(float));
+    }
+}
+
+int TextureData::convert_rgb(TextureData *data, GLenum internal_format)
+{
+    if (data->format != GL_RGB || (data->type != GL_FLOAT && data->type != GL_HALF_FLOAT)) {
+        nm_log::log(LOG_ERROR, "only RGB data of floats or half floats can be converted\n");
+
+        return EXIT_FAILURE;
+    }
+
+    TextureData converted{
+            data->texture_type, internal_format, 0, 0, data->width, data->height, data->level_count, data->face_count,
+            {}};
+    if ((internal_format != GL_RGB16F && internal_format != GL_RGB9_E5) ||
+        get_transfer_format(internal_format, &converted.format, &converted.type) == EXIT_FAILURE) {
+        nm_log::log(LOG_ERROR, "cannot convert RGB data to internal format \"%d\"\n", internal_format);
+
+        return EXIT_FAILURE;
+    }
+    if (converted.type == data->type) {
+        data->internal_format = internal_format;
+
+        return EXIT_SUCCESS;
+    }
+
+    size_t size = 0;
+    for (uint32_t level = 0; level < data->level_count; level++) {
+        size += converted.get_level_size(level) * data->face_count;
+    }
+    converted.data.resize(size);
+
+    uint32_t pixel_size = get_pixel_size(data->format, data->type);
+    uint32_t converted_pixel_size = get_pixel_size(converted.format, converted.type);
+    for (uint32_t level = 0; level < data->level_count; level++) {
+        size_t pixel_count = (size_t) data->get_level_width(level) * data->get_level_height(level);
+        for (uint32_t face = 0; face < data->face_count; face++) {
+            const uint8_t *pixels = data->get_pixels(level, face);
+            uint8_t *converted_pixels = converted.get_pixels(level, face);
+            for (size_t i = 0; i < pixel_count; i++) {
+                float rgb[3];
+                read_rgb(data->type, pixels + i * pixel_size, rgb);
+                if (converted.type == GL_UNSIGNED_INT_5_9_9_9_REV) {
+                    uint32_t packed = float_to_rgb9_e5(rgb);
+                    memcpy(converted_pixels + i * converted_pixel_size, &packed, sizeof(packed));
+                } else {
+                    for (uint32_t c = 0; c < 3; c++) {
+                        uint16_t half = float_to_half(rgb[c]);
+                        memcpy(converted_pixels + i * converted_pixel_size + c * sizeof(half), &half, sizeof(half));
+                    }
+                }
+            }
+        }
+    }
+
+    *data = std::move(converted);
+
+    return EXIT_SUCCESS;
+}
+
+int TextureData::write(const TextureData *texture_data, FILE *file)
+{
+    TextureDataHeader header{
+            texture_data->texture_type, texture_data->internal_format, texture_data->format, texture_data->type,
+            texture_data->width, texture_data->height, texture_data->level_count, texture_data->face_count,
+            texture_data->data.size()};
+
+    if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+        fwrite(texture_data->data.data(), sizeof(uint8_t), texture_data->data.size(), file) !=
+        texture_data->data.size()) {
+        nm_log::log(LOG_ERROR, "failed to write texture data\n");
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/** Copies the fields of {header} into {texture_data}, except for the pixels. */
+static void set_header(TextureData *texture_data, const TextureDataHeader *header)
+{
+    texture_data->texture_type = header->texture_type;
+    texture_data->internal_format = header->internal_format;
+    texture_data->format = header->format;
+    texture_data->type = header->type;
+    texture_data->width = header->width;
+    texture_data->height = header->height;
+    texture_data->level_count = header->level_count;
+    texture_data->face_count = header->face_count;
+}
+
+/** Largest width and height that is accepted from a header, such that the size of the pixels cannot overflow. */
+static const uint32_t MAX_HEADER_RESOLUTION = 1u << 16u;
+
+/**
+ * Whether {header} describes pixels of {header->size} bytes, such that a corrupt or partially written header neither
+ * allocates an arbitrary amount of memory nor yields fewer pixels than its levels and faces are read from. */
+static bool is_header_valid(const TextureDataHeader *header)
+{
+    if (header->width == 0 || header->width > MAX_HEADER_RESOLUTION ||
+        header->height == 0 || header->height > MAX_HEADER_RESOLUTION ||
+        header->level_count == 0 || header->level_count > 32 ||
+        (header->face_count != 1 && header->face_count != 6)) {
+        return false;
+    }
+
+    TextureData layout{};
+    set_header(&layout, header);
+    uint64_t size = 0;
+    for (uint32_t level = 0; level < layout.level_count; level++) {
+        size += (uint64_t) layout.get_level_size(level) * layout.face_count;
+    }
+
+    return size == header->size;
+}
+
+int TextureData::read(TextureData *texture_data, FILE *file)
+{
+    TextureDataHeader header{};
+    if (fread(&header, sizeof(header), 1, file) != 1) {
+        nm_log::log(LOG_ERROR, "failed to read texture data header\n");
+
+        return EXIT_FAILURE;
+    }
+
+    if (!is_header_valid(&header)) {
+        nm_log::log(LOG_ERROR, "texture data header does not match the size of its pixels\n");
+
+        return EXIT_FAILURE;
+    }
+
+    set_header(texture_data, &header);
+
+    texture_data->data.resize(header.size);
+    if (fread(texture_data->data.data(), sizeof(uint8_t), header.size, file) != header.size) {
+        nm_log::log(LOG_ERROR, "failed to read texture data pixels\n");
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int TextureData::read_from_memory(TextureData *texture_data, const uint8_t *memory, size_t size)
+{
+    TextureDataHeader header{};
+    if (size < sizeof(header)) {
+        nm_log::log(LOG_ERROR, "failed to read texture data header\n");
+
+        return EXIT_FAILURE;
+    }
+    memcpy(&header, memory, sizeof(header));
+
+    if (!is_header_valid(&header)) {
+        nm_log::log(LOG_ERROR, "texture data header does not match the size of its pixels\n");
+
+        return EXIT_FAILURE;
+    }
+
+    if (size - sizeof(header) < header.size) {
+        nm_log::log(LOG_ERROR, "failed to read texture data pixels\n");
+
+        return EXIT_FAILURE;
+    }
+
+    set_header(texture_data, &header);
+    texture_data->data.assign(memory + sizeof(header), memory + sizeof(header) + header.size);
+
+    return EXIT_SUCCESS;
+}
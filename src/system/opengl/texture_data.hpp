@@ -0,0 +1,114 @@
+#ifndef SYSTEM_TEXTURE_DATA_HPP
+#define SYSTEM_TEXTURE_DATA_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <glad/glad.h>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+/** BC1, from EXT_texture_compression_s3tc which glad lacks, see {Texture::initialize_formats}. */
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+/** BC1 of which the colors are decoded from sRGB when sampled, from EXT_texture_sRGB. */
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+
+/**
+ * CPU-side copy of all levels (and faces) of a texture, laid out exactly as it is uploaded.
+ * Used to move generated textures between the GPU and disk without regenerating them. */
+struct TextureData {
+    /** GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP. */
+    GLenum texture_type;
+    /** Sized internal format, for example GL_RGB16F. */
+    GLenum internal_format;
+    /** Pixel transfer format and type of {data}, for example GL_RGB and GL_HALF_FLOAT. Unused if compressed. */
+    GLenum format;
+    GLenum type;
+    /** Dimensions of level 0. */
+    uint32_t width;
+    uint32_t height;
+    uint32_t level_count;
+    /** 6 for cubemaps, 1 otherwise. */
+    uint32_t face_count;
+    /** Tightly packed pixels, levels are outer, faces are inner. */
+    std::vector<uint8_t> data;
+
+    /** Returns the number of bytes of a single pixel in {format} and {type}. */
+    static uint32_t get_pixel_size(GLenum format, GLenum type);
+
+    /** Finds the transfer format and type to use when reading back or uploading {internal_format}. */
+    static int get_transfer_format(GLenum internal_format, GLenum *format, GLenum *type);
+
+    /** Returns the number of bytes of a 4x4 block of compressed {internal_format}, or 0 if it is not compressed. */
+    static uint32_t get_block_size(GLenum internal_format);
+
+    /** Whether {data} holds 4x4 blocks of {internal_format} instead of pixels in {format} and {type}. */
+    bool is_compressed() const;
+
+    /** Returns the dimensions of {level}, halving those of level 0 for every level down to 1. */
+    uint32_t get_level_width(uint32_t level) const;
+
+    uint32_t get_level_height(uint32_t level) const;
+
+    /**
+     * Returns the number of rows of {level} and the size in bytes of one row. A row of a compressed texture is a row
+     * of blocks, which covers four rows of pixels. */
+    uint32_t get_row_count(uint32_t level) const;
+
+    size_t get_row_size(uint32_t level) const;
+
+    /** Returns the size in bytes of one face of {level}. */
+    size_t get_level_size(uint32_t level) const;
+
+    /** Returns a pointer to the pixels of {face} of {level}. */
+    const uint8_t *get_pixels(uint32_t level, uint32_t face) const;
+
+    uint8_t *get_pixels(uint32_t level, uint32_t face);
+
+    /**
+     * Creates a single face and level {packed} with {channel_count} channels, of which channel {i} is the first channel
+     * of {channels[i]}, or zero if it is null. All non-null {channels} must be single level 8 or 16 bit images of equal
+     * dimensions, the channels are 16 bit if any of them is. */
+    static int pack_channels(TextureData *packed, const TextureData *const *channels, uint32_t channel_count);
+
+    /**
+     * Converts {value} to a half float, rounding to nearest even. Values beyond the largest finite half float are
+     * clamped to it, since infinite radiance breaks filtering. */
+    static uint16_t float_to_half(float value);
+
+    static float half_to_float(uint16_t half);
+
+    /**
+     * Packs {rgb} into {GL_RGB9_E5}, three 9 bit mantissas sharing a 5 bit exponent, rounding to nearest. Negative
+     * values become zero and values beyond the largest representable one are clamped to it. */
+    static uint32_t float_to_rgb9_e5(const float *rgb);
+
+    static void rgb9_e5_to_float(uint32_t packed, float *rgb);
+
+    /** Reads the RGB pixel at {pixel} into {rgb}, which is of {type} {GL_FLOAT}, {GL_HALF_FLOAT}, or packed RGB9_E5. */
+    static void read_rgb(GLenum type, const uint8_t *pixel, float *rgb);
+
+    /** Writes {rgb} to the RGB pixel at {pixel}, the counterpart of {read_rgb}. */
+    static void write_rgb(GLenum type, const float *rgb, uint8_t *pixel);
+
+    /**
+     * Converts all levels and faces of RGB {data} of floats or half floats to {internal_format}, which is
+     * {GL_RGB16F} or {GL_RGB9_E5}. */
+    static int convert_rgb(TextureData *data, GLenum internal_format);
+
+    /** Writes the header and pixels to the current position of {file}. */
+    static int write(const TextureData *texture_data, FILE *file);
+
+    /** Reads the header and pixels from the current position of {file}. */
+    static int read(TextureData *texture_data, FILE *file);
+
+    /** Reads the header and pixels from {size} bytes of {memory}, as written by {write}. */
+    static int read_from_memory(TextureData *texture_data, const uint8_t *memory, size_t size);
+};
+
+#endif //SYSTEM_TEXTURE_DATA_HPP
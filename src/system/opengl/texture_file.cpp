@@ -0,0 +1,75 @@
+#include "texture_file.hpp"
+
+#include <cstring>
+
+#include "../../util/nm_log.hpp"
+
+static const char MAGIC[4] = {'P', 'B', 'R', 'T'};
+
+/** Size of the magic and the version preceding the texture data. */
+static const size_t HEADER_SIZE = sizeof(MAGIC) + sizeof(uint32_t);
+
+const uint32_t TextureFile::VERSION = 3;
+
+int TextureFile::write(const char *file_name, const TextureData *texture_data)
+{
+    FILE *file = fopen(file_name, "wb");
+    if (!file) {
+        nm_log::log(LOG_ERROR, "failed to open file \"%s\" for writing\n", file_name);
+
+        return EXIT_FAILURE;
+    }
+
+    int rval = EXIT_SUCCESS;
+    if (fwrite(MAGIC, sizeof(MAGIC), 1, file) != 1 ||
+        fwrite(&VERSION, sizeof(VERSION), 1, file) != 1 ||
+        TextureData::write(texture_data, file) == EXIT_FAILURE) {
+        nm_log::log(LOG_ERROR, "failed to write texture file \"%s\"\n", file_name);
+        rval = EXIT_FAILURE;
+    }
+    fclose(file);
+
+    return rval;
+}
+
+int TextureFile::read(const char *file_name, TextureData *texture_data)
+{
+    FILE *file = fopen(file_name, "rb");
+    if (!file) {
+        nm_log::log(LOG_ERROR, "failed to open file \"%s\"\n", file_name);
+
+        return EXIT_FAILURE;
+    }
+
+    char magic[4];
+    uint32_t version;
+    if (fread(magic, sizeof(magic), 1, file) != 1 ||
+        fread(&version, sizeof(version), 1, file) != 1 ||
+        memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION) {
+        nm_log::log(LOG_ERROR, "\"%s\" is not a valid version %d texture file\n", file_name, VERSION);
+        fclose(file);
+
+        return EXIT_FAILURE;
+    }
+
+    int rval = TextureData::read(texture_data, file);
+    fclose(file);
+
+    return rval;
+}
+
+int TextureFile::read_from_memory(const uint8_t *memory, size_t size, TextureData *texture_data)
+{
+    uint32_t version = 0;
+    if (size >= HEADER_SIZE && memcmp(memory, MAGIC, sizeof(MAGIC)) == 0) {
+        memcpy(&version, memory + sizeof(MAGIC), sizeof(version));
+    }
+
+    if (version != VERSION) {
+        nm_log::log(LOG_ERROR, "not a valid version %d texture file\n", VERSION);
+
+        return EXIT_FAILURE;
+    }
+
+    return TextureData::read_from_memory(texture_data, memory + HEADER_SIZE, size - HEADER_SIZE);
+}
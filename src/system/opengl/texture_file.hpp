@@ -0,0 +1,24 @@
+#ifndef SYSTEM_TEXTURE_FILE_HPP
+#define SYSTEM_TEXTURE_FILE_HPP
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "texture_data.hpp"
+
+/**
+ * File format of textures prepared by {pbr_texture}: a magic, a version and a single {TextureData} holding the full
+ * mip chain, such that it is uploaded as-is instead of decoded and mipmapped at load. */
+struct TextureFile {
+    /** Bumped whenever the layout or the prepared contents change, older files are rejected. */
+    static const uint32_t VERSION;
+
+    static int write(const char *file_name, const TextureData *texture_data);
+
+    static int read(const char *file_name, TextureData *texture_data);
+
+    /** Reads a texture file from {size} bytes of {memory}, for example a mapped {ResourcePack} entry. */
+    static int read_from_memory(const uint8_t *memory, size_t size, TextureData *texture_data);
+};
+
+#endif //SYSTEM_TEXTURE_FILE_HPP
@@ -1,8 +1,37 @@
 #include "renderer.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 #include "material.hpp"
+#include "opengl/ibl_tier.hpp"
+#include "opengl/reflection_probe.hpp"
 #include "opengl/texture.hpp"
 
+/** Names of the uniforms set while drawing, hashed at compile time. */
+static constexpr UniformName UNIFORM_PRE_FILTER_ROTATION("pre_filter_rotation");
+static constexpr UniformName UNIFORM_PRE_FILTER_INTENSITY("pre_filter_intensity");
+static constexpr UniformName UNIFORM_COLOR("color");
+static constexpr UniformName UNIFORM_MODEL_MATRIX("model_matrix");
+static constexpr UniformName UNIFORM_VIEW_MATRIX("view_matrix");
+static constexpr UniformName UNIFORM_PROJECTION_MATRIX("projection_matrix");
+static constexpr UniformName UNIFORM_POS_CAMERA("pos_camera");
+static constexpr UniformName UNIFORM_POS_LIGHT("pos_light");
+static constexpr UniformName UNIFORM_COLOR_LIGHT("color_light");
+static constexpr UniformName UNIFORM_DIRECTION_DOMINANT_LIGHT("direction_dominant_light");
+static constexpr UniformName UNIFORM_COLOR_DOMINANT_LIGHT("color_dominant_light");
+static constexpr UniformName UNIFORM_IRRADIANCE_COEFFICIENTS("irradiance_coefficients");
+static constexpr UniformName UNIFORM_LINEAR_OUTPUT("linear_output");
+static constexpr UniformName UNIFORM_PRE_FILTER_MAP("pre_filter_map");
+static constexpr UniformName UNIFORM_BRDF_LUT("brdf_lut");
+static constexpr UniformName UNIFORM_ENVIRONMENT_ROTATION("environment_rotation");
+static constexpr UniformName UNIFORM_ENVIRONMENT_INTENSITY("environment_intensity");
+static constexpr UniformName UNIFORM_DOMINANT_LIGHT_DIRECTION("dominant_light_direction");
+static constexpr UniformName UNIFORM_DOMINANT_LIGHT_RADIANCE("dominant_light_radiance");
+static constexpr UniformName UNIFORM_DOMINANT_LIGHT_COS_RADIUS("dominant_light_cos_radius");
+static constexpr UniformName UNIFORM_ENVIRONMENT_MAP("environment_map");
+
 Renderer::Renderer(
         Camera *p_camera, ShaderManager *p_shader_manager, TextureManager *p_texture_manager,
         PrimitiveManager *p_primitive_manager
@@ -15,6 +44,58 @@ void Renderer::render(Scene *scene)
 {
     glClear((uint32_t) GL_COLOR_BUFFER_BIT | (uint32_t) GL_DEPTH_BUFFER_BIT);
 
+    state_switches = 0;
+    saved_state_switches = 0;
+
+    use_camera_view();
+
+    // prepare the next environment a little every frame, instead of stalling on the frame that it is first bound
+    if (switching && texture_manager->update_environment(TextureManager::DEFAULT_ENVIRONMENT_BUDGET)) {
+        if (cubemap != next_cubemap) {
+            irradiance_outdated = true;
+            environment_version++;
+        }
+        cubemap = next_cubemap;
+        cubemap_pre_filter = next_cubemap_pre_filter;
+        switching = false;
+    }
+
+    // decode the images of all textures needed this frame at once, instead of one by one when first bound
+    std::vector<uint32_t> textures = {cubemap, cubemap_pre_filter, BRDF_LUT};
+    scene->get_textures(&textures);
+    texture_manager->prefetch(textures);
+
+    if (irradiance_outdated) {
+        irradiance = SphericalHarmonics{};
+        if (texture_manager->get_irradiance(cubemap, &irradiance) == EXIT_FAILURE) {
+            nm_log::log(LOG_ERROR, "failed to obtain irradiance, ambient diffuse lighting is disabled\n");
+        }
+        dominant_light = DominantLight{glm::vec3(0.f, 1.f, 0.f), glm::vec3(0.f), 0.f};
+        if (texture_manager->get_dominant_light(cubemap, &dominant_light) == EXIT_FAILURE) {
+            nm_log::log(LOG_ERROR, "failed to obtain dominant light, it is not shaded\n");
+        }
+        irradiance_outdated = false;
+        coefficients_outdated = true;
+    }
+
+    // the yaw and exposure are folded into the nine coefficients once, instead of into every shaded fragment
+    if (coefficients_outdated) {
+        SphericalHarmonics rotated{};
+        SphericalHarmonics::rotate_y(&irradiance, environment_yaw, &rotated);
+        irradiance_coefficients.resize(SphericalHarmonics::COEFFICIENT_COUNT);
+        for (uint32_t k = 0; k < SphericalHarmonics::COEFFICIENT_COUNT; k++) {
+            irradiance_coefficients[k] = rotated.coefficients[k] * environment_intensity;
+        }
+        coefficients_outdated = false;
+    }
+
+    update_reflection_probes(scene);
+
+    // start reading the files of the next scene, such that switching to it does not wait on the disk
+    std::vector<uint32_t> next_textures;
+    scene->get_next_textures(&next_textures);
+    texture_manager->prefetch_files(next_textures);
+
     if (debug_mode) {
         render_lines(PRIMITIVE_COORDINATE_SYSTEM, glm::identity<glm::mat4>());
     }
@@ -23,6 +104,13 @@ void Renderer::render(Scene *scene)
 
     scene->render(debug_mode);
 
+    // includes the draws of reflection probe captures, only logged when it changes to not log every frame
+    if (saved_state_switches != reported_saved_state_switches) {
+        nm_log::log(LOG_TRACE, "draw queues saved %d state switches this frame, %d were made\n",
+                    saved_state_switches, state_switches);
+        reported_saved_state_switches = saved_state_switches;
+    }
+
     window::get_instance().swap_buffers();
 }
 
@@ -31,72 +119,177 @@ void Renderer::toggle_draw_coordinate()
     debug_mode = !debug_mode;
 }
 
-void Renderer::render_pbr(
-        uint32_t mesh_id, uint32_t material_id, std::vector<glm::vec3> positions,
-        std::vector<glm::vec3> colors, glm::mat4 model_matrix)
+void Renderer::begin_draw_queue(const std::vector<glm::vec3> &positions, const std::vector<glm::vec3> &colors)
 {
-    ShaderProgram *program = shader_manager->get(SHADER_PBR);
-    ShaderProgram::use_shader_program(program);
-    ShaderProgram::set_mat4(program, "model_matrix", model_matrix);
-    ShaderProgram::set_mat4(program, "view_matrix", camera->get_view_matrix());
-    ShaderProgram::set_mat4(program, "projection_matrix", camera->get_proj_matrix());
-
-    ShaderProgram::set_vec3_array(program, "pos_light", positions);
-    ShaderProgram::set_vec3_array(program, "color_light", colors);
-
-    ShaderProgram::set_vec3(program, "pos_camera", camera->get_camera_position());
+    draw_queue.clear();
+    light_positions = positions;
+    light_colors = colors;
+}
 
-    Material *material;
-    Material::get_material_by_id(material_id, &material);
+void Renderer::queue_pbr(uint32_t mesh_id, uint32_t material_id, glm::mat4 model_matrix, ReflectionProbe *probe)
+{
+    // probes pre-filter into the layout of the environment, so a single variant serves both
+    bool octahedral = IblTier::get_layout() == IblTier::OCTAHEDRAL;
+    queue_packet({0, PASS_OPAQUE, octahedral ? SHADER_PBR_OCTAHEDRAL : SHADER_PBR, mesh_id, material_id,
+                  glm::vec3(0.f), model_matrix, probe});
+}
 
-    material->set(program, texture_manager);
+void Renderer::queue_default(uint32_t mesh_id, glm::vec3 color, glm::mat4 model_matrix, DrawPass pass)
+{
+    queue_packet({0, pass, SHADER_DEFAULT, mesh_id, 0, color, model_matrix, nullptr});
+}
 
-    ShaderProgram::set_int(program, "irradiance_map",
-                           (signed) texture_manager->get(cubemap_irradiance)->texture_unit - GL_TEXTURE0);
-    ShaderProgram::set_int(program, "pre_filter_map",
-                           (signed) texture_manager->get(cubemap_pre_filter)->texture_unit - GL_TEXTURE0);
-    ShaderProgram::set_int(program, "brdf_lut",
-                           (signed) texture_manager->get(BRDF_LUT)->texture_unit - GL_TEXTURE0);
+void Renderer::queue_packet(DrawPacket packet)
+{
+    // the bits of a non-negative float sort like the float itself, the upper 24 of them are precise enough for depth
+    float depth = fmaxf(-(view_matrix * packet.model_matrix[3]).z, 0.f);
+    uint32_t depth_bits;
+    memcpy(&depth_bits, &depth, sizeof(depth_bits));
+
+    // pass (4 bits), shader (8), material (12), depth (24), and the order of queueing (16) to keep sorting stable
+    packet.key = (uint64_t) (packet.pass & 0xfu) << 60u |
+                 (uint64_t) (packet.shader & 0xffu) << 52u |
+                 (uint64_t) (packet.material_id & 0xfffu) << 40u |
+                 (uint64_t) (depth_bits >> 8u) << 16u |
+                 (uint64_t) (draw_queue.size() & 0xffffu);
+    draw_queue.push_back(packet);
+}
 
-    material->bind(texture_manager);
+void Renderer::submit_draw_queue()
+{
+    std::sort(draw_queue.begin(), draw_queue.end(), [](const DrawPacket &a, const DrawPacket &b) {
+        return a.key < b.key;
+    });
+
+    // the state set on the program in use, reset when the program changes since uniforms are per program
+    const DrawPacket *previous = nullptr;
+    ShaderProgram *program = nullptr;
+    Material *material = nullptr;
+    Texture *pre_filter = nullptr;
+    // locations of the uniforms set per draw, resolved once per program instead of looked up for every draw
+    GLint model_matrix_location = -1;
+    GLint color_location = -1;
+    GLint pre_filter_rotation_location = -1;
+    GLint pre_filter_intensity_location = -1;
+    // the textures left bound, unbound once all draws are done
+    Material *bound_material = nullptr;
+    Texture *bound_pre_filter = nullptr;
+    uint32_t switch_count = 0;
+    uint32_t unsorted_switch_count = 0;
+    for (auto &packet : draw_queue) {
+        if (packet.pass == PASS_OVERLAY && (!previous || previous->pass != PASS_OVERLAY)) {
+            // remove stored depth buffer, to always draw the overlay on top
+            glClear(GL_DEPTH_BUFFER_BIT);
+        }
+
+        // rendering every draw on its own switches the program, and for pbr the material and pre-filter as well
+        bool pbr = packet.shader != SHADER_DEFAULT;
+        unsorted_switch_count += pbr ? 3 : 1;
+
+        if (!previous || packet.shader != previous->shader) {
+            program = shader_manager->get(packet.shader);
+            use_draw_shader(program, packet.shader);
+            model_matrix_location = ShaderProgram::get_location(program, UNIFORM_MODEL_MATRIX);
+            color_location = ShaderProgram::get_location(program, UNIFORM_COLOR);
+            pre_filter_rotation_location = ShaderProgram::get_location(program, UNIFORM_PRE_FILTER_ROTATION);
+            pre_filter_intensity_location = ShaderProgram::get_location(program, UNIFORM_PRE_FILTER_INTENSITY);
+            material = nullptr;
+            pre_filter = nullptr;
+            switch_count++;
+        }
+
+        if (pbr) {
+            Material *packet_material;
+            if (Material::get_material_by_id(packet.material_id, &packet_material) == EXIT_FAILURE) {
+                continue;
+            }
+            if (packet_material != material) {
+                packet_material->set(program, texture_manager);
+                packet_material->bind(texture_manager);
+                material = packet_material;
+                bound_material = packet_material;
+                switch_count++;
+            }
+
+            // a probe captures the environment with its yaw and exposure applied, so it is looked up as-is
+            bool use_probe = packet.probe && packet.probe->ready;
+            Texture *packet_pre_filter =
+                    use_probe ? &packet.probe->pre_filter : texture_manager->get(cubemap_pre_filter);
+            if (packet_pre_filter != pre_filter) {
+                ShaderProgram::set_mat3(
+                        pre_filter_rotation_location, use_probe ? glm::mat3(1.f) : environment_rotation);
+                ShaderProgram::set_float(pre_filter_intensity_location, use_probe ? 1.f : environment_intensity);
+                Texture::bind_tex(packet_pre_filter);
+                pre_filter = packet_pre_filter;
+                bound_pre_filter = packet_pre_filter;
+                switch_count++;
+            }
+        } else {
+            ShaderProgram::set_vec3(color_location, packet.color);
+        }
+
+        ShaderProgram::set_mat4(model_matrix_location, packet.model_matrix);
+        primitive_manager->get(packet.mesh_id)->render_primitive();
+        previous = &packet;
+    }
 
-    Texture::bind_tex(texture_manager->get(cubemap_irradiance));
-    Texture::bind_tex(texture_manager->get(cubemap_pre_filter));
-    Texture::bind_tex(texture_manager->get(BRDF_LUT));
-    primitive_manager->get(mesh_id)->render_primitive();
-    Texture::unbind_tex(texture_manager->get(BRDF_LUT));
-    Texture::unbind_tex(texture_manager->get(cubemap_pre_filter));
-    Texture::unbind_tex(texture_manager->get(cubemap_irradiance));
+    if (bound_pre_filter) {
+        Texture::unbind_tex(texture_manager->get(BRDF_LUT));
+        Texture::unbind_tex(bound_pre_filter);
+    }
+    if (bound_material) {
+        bound_material->unbind(texture_manager);
+    }
+    if (program) {
+        ShaderProgram::unuse_shader_program();
+    }
 
-    material->unbind(texture_manager);
+    state_switches += switch_count;
+    saved_state_switches += unsorted_switch_count - switch_count;
+    draw_queue.clear();
+}
 
-    ShaderProgram::unuse_shader_program();
+uint32_t Renderer::get_saved_state_switches() const
+{
+    return saved_state_switches;
 }
 
-void Renderer::render_default(uint32_t mesh_id, glm::vec3 color, glm::mat4 model_matrix)
+void Renderer::use_draw_shader(ShaderProgram *program, ShaderType shader)
 {
-    ShaderProgram *program = shader_manager->get(SHADER_DEFAULT);
     ShaderProgram::use_shader_program(program);
-    ShaderProgram::set_mat4(program, "model_matrix", model_matrix);
-    ShaderProgram::set_mat4(program, "view_matrix", camera->get_view_matrix());
-    ShaderProgram::set_mat4(program, "projection_matrix", camera->get_proj_matrix());
+    ShaderProgram::set_mat4(program, UNIFORM_VIEW_MATRIX, view_matrix);
+    ShaderProgram::set_mat4(program, UNIFORM_PROJECTION_MATRIX, projection_matrix);
+    ShaderProgram::set_vec3(program, UNIFORM_POS_CAMERA, view_position);
+    if (shader == SHADER_DEFAULT) {
+        return;
+    }
 
-    ShaderProgram::set_vec3(program, "pos_camera", camera->get_camera_position());
+    ShaderProgram::set_vec3_array(program, UNIFORM_POS_LIGHT, light_positions);
+    ShaderProgram::set_vec3_array(program, UNIFORM_COLOR_LIGHT, light_colors);
 
-    ShaderProgram::set_vec3(program, "color", color);
+    // the direction is in the frame of the environment, which the lookup rotation rotates world directions into
+    ShaderProgram::set_vec3(
+            program, UNIFORM_DIRECTION_DOMINANT_LIGHT, glm::transpose(environment_rotation) * dominant_light.direction);
+    ShaderProgram::set_vec3(program, UNIFORM_COLOR_DOMINANT_LIGHT, dominant_light.irradiance * environment_intensity);
 
-    primitive_manager->get(mesh_id)->render_primitive();
+    ShaderProgram::set_vec3_array(program, UNIFORM_IRRADIANCE_COEFFICIENTS, irradiance_coefficients);
+    ShaderProgram::set_int(program, UNIFORM_LINEAR_OUTPUT, linear_output);
 
-    ShaderProgram::unuse_shader_program();
+    // the environment and the probes pre-filter into the same texture unit
+    ShaderProgram::set_int(program, UNIFORM_PRE_FILTER_MAP,
+                           (signed) texture_manager->get(cubemap_pre_filter)->texture_unit - GL_TEXTURE0);
+    ShaderProgram::set_int(program, UNIFORM_BRDF_LUT,
+                           (signed) texture_manager->get(BRDF_LUT)->texture_unit - GL_TEXTURE0);
+    Texture::bind_tex(texture_manager->get(BRDF_LUT));
 }
 
 void Renderer::render_lines(uint32_t primitive_id, glm::mat4 model_matrix)
 {
     ShaderProgram *program = shader_manager->get(SHADER_LINES);
     ShaderProgram::use_shader_program(program);
-    ShaderProgram::set_mat4(program, "model_matrix", model_matrix);
-    ShaderProgram::set_mat4(program, "view_matrix", camera->get_view_matrix());
-    ShaderProgram::set_mat4(program, "projection_matrix", camera->get_proj_matrix());
+    ShaderProgram::set_mat4(program, UNIFORM_MODEL_MATRIX, model_matrix);
+    ShaderProgram::set_mat4(program, UNIFORM_VIEW_MATRIX, view_matrix);
+    ShaderProgram::set_mat4(program, UNIFORM_PROJECTION_MATRIX, projection_matrix);
     primitive_manager->get(primitive_id)->render_primitive();
     ShaderProgram::unuse_shader_program();
 }
@@ -111,30 +304,30 @@ void Renderer::render_widget(glm::vec3 position)
     glm::mat4 model_matrix = glm::translate(glm::identity<glm::mat4>(), position);
 
     // x-axis
-    render_default(PRIMITIVE_CONE, glm::vec3(1.f, 0.f, 0.f), glm::rotate(
+    queue_default(PRIMITIVE_CONE, glm::vec3(1.f, 0.f, 0.f), glm::rotate(
             glm::scale(glm::translate(model_matrix, glm::vec3(CYLINDER_LENGTH_SCALE, 0.f, 0.f)),
-                       glm::vec3(1.f / CONE_SCALE)), -(float) M_PI_2, glm::vec3(0.f, 0.f, 1.f)));
-    render_default(PRIMITIVE_CYLINDER, glm::vec3(1.f, 0.f, 0.f), glm::translate(
+                       glm::vec3(1.f / CONE_SCALE)), -(float) M_PI_2, glm::vec3(0.f, 0.f, 1.f)), PASS_OVERLAY);
+    queue_default(PRIMITIVE_CYLINDER, glm::vec3(1.f, 0.f, 0.f), glm::translate(
             glm::scale(glm::rotate(model_matrix, -(float) M_PI_2, glm::vec3(0.f, 0.f, 1.f)),
                        glm::vec3(1.f / CYLINDER_WIDTH_SCALE, CYLINDER_LENGTH_SCALE / 2.f, 1.f / CYLINDER_WIDTH_SCALE)),
-            glm::vec3(0.f, 1.f, 0.f)));
+            glm::vec3(0.f, 1.f, 0.f)), PASS_OVERLAY);
 
     // y-axis
-    render_default(PRIMITIVE_CONE, glm::vec3(0.f, 1.f, 0.f),
-                   glm::scale(glm::translate(model_matrix, glm::vec3(0.f, CYLINDER_LENGTH_SCALE, 0.f)),
-                              glm::vec3(1.f / CONE_SCALE)));
-    render_default(PRIMITIVE_CYLINDER, glm::vec3(0.f, 1.f, 0.f), glm::translate(glm::scale(model_matrix, glm::vec3(
+    queue_default(PRIMITIVE_CONE, glm::vec3(0.f, 1.f, 0.f),
+                  glm::scale(glm::translate(model_matrix, glm::vec3(0.f, CYLINDER_LENGTH_SCALE, 0.f)),
+                             glm::vec3(1.f / CONE_SCALE)), PASS_OVERLAY);
+    queue_default(PRIMITIVE_CYLINDER, glm::vec3(0.f, 1.f, 0.f), glm::translate(glm::scale(model_matrix, glm::vec3(
             1.f / CYLINDER_WIDTH_SCALE, CYLINDER_LENGTH_SCALE / 2.f, 1.f / CYLINDER_WIDTH_SCALE)),
-                                                                                glm::vec3(0.f, 1.f, 0.f)));
+                                                                               glm::vec3(0.f, 1.f, 0.f)), PASS_OVERLAY);
 
     // z-axis
-    render_default(PRIMITIVE_CONE, glm::vec3(0.f, 0.f, 1.f), glm::rotate(
+    queue_default(PRIMITIVE_CONE, glm::vec3(0.f, 0.f, 1.f), glm::rotate(
             glm::scale(glm::translate(model_matrix, glm::vec3(0.f, 0.f, CYLINDER_LENGTH_SCALE)),
-                       glm::vec3(1.f / CONE_SCALE)), +(float) M_PI_2, glm::vec3(1.f, 0.f, 0.f)));
-    render_default(PRIMITIVE_CYLINDER, glm::vec3(0.f, 0.f, 1.f), glm::translate(
+                       glm::vec3(1.f / CONE_SCALE)), +(float) M_PI_2, glm::vec3(1.f, 0.f, 0.f)), PASS_OVERLAY);
+    queue_default(PRIMITIVE_CYLINDER, glm::vec3(0.f, 0.f, 1.f), glm::translate(
             glm::scale(glm::rotate(model_matrix, (float) M_PI_2, glm::vec3(1.f, 0.f, 0.f)),
                        glm::vec3(1.f / CYLINDER_WIDTH_SCALE, CYLINDER_LENGTH_SCALE / 2.f, 1.f / CYLINDER_WIDTH_SCALE)),
-            glm::vec3(0.f, 1.f, 0.f)));
+            glm::vec3(0.f, 1.f, 0.f)), PASS_OVERLAY);
 }
 
 float Renderer::get_scale(glm::vec3 position)
@@ -167,14 +360,28 @@ float Renderer::get_cylinder_radius(glm::vec3 position)
 
 void Renderer::render_skybox()
 {
-    ShaderProgram *program = shader_manager->get(SHADER_SKYBOX);
+    bool octahedral = IblTier::get_layout() == IblTier::OCTAHEDRAL;
+    ShaderProgram *program = shader_manager->get(octahedral ? SHADER_SKYBOX_OCTAHEDRAL : SHADER_SKYBOX);
     ShaderProgram::use_shader_program(program);
-    ShaderProgram::set_mat4(program, "model_matrix", glm::scale(glm::identity<glm::mat4>(), glm::vec3(.5f)));
-    ShaderProgram::set_mat4(program, "view_matrix", camera->get_view_matrix());
-    ShaderProgram::set_mat4(program, "projection_matrix", camera->get_proj_matrix());
+    ShaderProgram::set_mat4(program, UNIFORM_MODEL_MATRIX, glm::scale(glm::identity<glm::mat4>(), glm::vec3(.5f)));
+    ShaderProgram::set_mat4(program, UNIFORM_VIEW_MATRIX, view_matrix);
+    ShaderProgram::set_mat4(program, UNIFORM_PROJECTION_MATRIX, projection_matrix);
+    ShaderProgram::set_mat3(program, UNIFORM_ENVIRONMENT_ROTATION, environment_rotation);
+    ShaderProgram::set_float(program, UNIFORM_ENVIRONMENT_INTENSITY, environment_intensity);
+    ShaderProgram::set_int(program, UNIFORM_LINEAR_OUTPUT, linear_output);
+
+    // spread over the solid angle it was extracted from, a light without irradiance gets a disk that is never hit
+    bool has_dominant_light = dominant_light.solid_angle > 0.f;
+    ShaderProgram::set_vec3(program, UNIFORM_DOMINANT_LIGHT_DIRECTION, dominant_light.direction);
+    ShaderProgram::set_vec3(
+            program, UNIFORM_DOMINANT_LIGHT_RADIANCE,
+            has_dominant_light ? dominant_light.irradiance / dominant_light.solid_angle : glm::vec3(0.f));
+    ShaderProgram::set_float(
+            program, UNIFORM_DOMINANT_LIGHT_COS_RADIUS,
+            has_dominant_light ? 1.f - dominant_light.solid_angle / (float) (2. * M_PI) : 2.f);
 
     ShaderProgram::set_int(
-            program, "environment_map",
+            program, UNIFORM_ENVIRONMENT_MAP,
             (signed) texture_manager->get(cubemap)->texture_unit - GL_TEXTURE0);
     Texture::bind_tex(texture_manager->get(cubemap));
     primitive_manager->get(PRIMITIVE_SKYBOX)->render_primitive();
@@ -182,10 +389,126 @@ void Renderer::render_skybox()
     ShaderProgram::unuse_shader_program();
 }
 
-void Renderer::switch_skybox(
-        TextureType p_cubemap, TextureType p_cubemap_irradiance, TextureType p_cubemap_pre_filter)
+void Renderer::switch_skybox(TextureType p_cubemap, TextureType p_cubemap_pre_filter)
 {
-    cubemap = p_cubemap;
-    cubemap_irradiance = p_cubemap_irradiance;
-    cubemap_pre_filter = p_cubemap_pre_filter;
+    next_cubemap = p_cubemap;
+    next_cubemap_pre_filter = p_cubemap_pre_filter;
+    switching = true;
+    texture_manager->prepare_environment(p_cubemap, p_cubemap_pre_filter);
+}
+
+TextureType Renderer::get_cubemap() const
+{
+    return cubemap;
+}
+
+void Renderer::set_environment_yaw(float p_yaw)
+{
+    environment_yaw = p_yaw;
+
+    // lookups rotate the other way, a direction in the world is found in the environment maps at the inverse rotation
+    environment_rotation = glm::mat3(glm::rotate(glm::identity<glm::mat4>(), -p_yaw, glm::vec3(0.f, 1.f, 0.f)));
+    coefficients_outdated = true;
+    environment_version++;
+}
+
+float Renderer::get_environment_yaw() const
+{
+    return environment_yaw;
+}
+
+void Renderer::set_environment_exposure(float p_exposure)
+{
+    environment_exposure = p_exposure;
+    environment_intensity = exp2f(p_exposure);
+    coefficients_outdated = true;
+    environment_version++;
+}
+
+float Renderer::get_environment_exposure() const
+{
+    return environment_exposure;
+}
+
+void Renderer::use_camera_view()
+{
+    view_matrix = camera->get_view_matrix();
+    projection_matrix = camera->get_proj_matrix();
+    view_position = camera->get_camera_position();
+    linear_output = false;
+}
+
+void Renderer::update_reflection_probes(Scene *scene)
+{
+    std::vector<ReflectionProbe *> &probes = scene->reflection_probes;
+
+    // continue the capture in progress, there is at most one
+    ReflectionProbe *probe = nullptr;
+    for (auto &candidate : probes) {
+        if (candidate->next_step < ReflectionProbe::STEP_COUNT) {
+            probe = candidate;
+            break;
+        }
+    }
+
+    // or start capturing the next probe that is out of date, taking turns such that a probe that keeps changing does
+    // not keep the others from being captured
+    for (size_t i = 0; !probe && i < probes.size(); i++) {
+        size_t index = (next_reflection_probe + i) % probes.size();
+        if (probes[index]->dirty || probes[index]->environment_version != environment_version) {
+            probe = probes[index];
+            probe->dirty = false;
+            probe->environment_version = environment_version;
+            probe->next_step = 0;
+            next_reflection_probe = index + 1;
+        }
+    }
+
+    if (!probe) {
+        return;
+    }
+
+    if (probe->next_step < ReflectionProbe::FACE_STEP_COUNT) {
+        capture_reflection_probe_face(scene, probe, probe->next_step);
+    } else {
+        uint32_t level = probe->next_step - ReflectionProbe::FACE_STEP_COUNT;
+        if (level == 0) {
+            // the pre-filter reads coarser levels of the capture for its wider lobes
+            Texture::bind_tex(&probe->capture);
+            glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+            Texture::unbind_tex(&probe->capture);
+        }
+        Texture::render_pre_filter_level(&probe->pass, level);
+    }
+
+    probe->next_step++;
+    if (probe->next_step == ReflectionProbe::STEP_COUNT) {
+        probe->ready = true;
+    }
+}
+
+void Renderer::capture_reflection_probe_face(Scene *scene, ReflectionProbe *probe, uint32_t face)
+{
+    // save the current viewport dims to later restore it
+    GLint viewport_dims[4];
+    glGetIntegerv(GL_VIEWPORT, viewport_dims);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, probe->capture_fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+                           probe->capture.tex_id, 0);
+    glViewport(0, 0, ReflectionProbe::CAPTURE_RESOLUTION, ReflectionProbe::CAPTURE_RESOLUTION);
+    glClear((uint32_t) GL_COLOR_BUFFER_BIT | (uint32_t) GL_DEPTH_BUFFER_BIT);
+
+    view_matrix = Texture::CAPTURE_VIEWS[face] * glm::translate(glm::identity<glm::mat4>(), -probe->position);
+    projection_matrix = Texture::CAPTURE_PROJECTION;
+    view_position = probe->position;
+    linear_output = true;
+
+    render_skybox();
+    scene->render_capture(probe);
+
+    use_camera_view();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport_dims[0], viewport_dims[1], viewport_dims[2], viewport_dims[3]);
 }
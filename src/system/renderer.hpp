@@ -12,7 +12,16 @@
 #include "manager/primitive_manager.hpp"
 #include "../scene/scene.hpp"
 
+struct ReflectionProbe;
+
 class Renderer {
+public:
+    /** Passes of the draw queue, submitted in this order. */
+    enum DrawPass {
+        PASS_OPAQUE,
+        /** Drawn on top of everything before it, the depth buffer is cleared when the pass starts. */
+        PASS_OVERLAY
+    };
 private:
     Camera *camera;
     ShaderManager *shader_manager;
@@ -20,11 +29,76 @@ private:
     PrimitiveManager *primitive_manager;
 
     TextureType cubemap = CUBEMAP_NOON_GRASS;
-    TextureType cubemap_irradiance = CUBEMAP_NOON_GRASS_IRRADIANCE;
     TextureType cubemap_pre_filter = CUBEMAP_NOON_GRASS_PRE_FILTER;
 
+    /** Environment that is switched to once the texture manager has prepared it, the current one is used until then. */
+    TextureType next_cubemap = CUBEMAP_NOON_GRASS;
+    TextureType next_cubemap_pre_filter = CUBEMAP_NOON_GRASS_PRE_FILTER;
+    bool switching = false;
+
+    /** Irradiance and dominant light of {cubemap}, obtained when it changes. */
+    SphericalHarmonics irradiance{};
+    DominantLight dominant_light{};
+    bool irradiance_outdated = true;
+
+    /**
+     * Yaw of the environment around the Y-axis in radians, and its exposure in stops. Both are applied while looking up
+     * the environment, such that changing them does not touch the environment textures. */
+    float environment_yaw = 0.f;
+    float environment_exposure = 0.f;
+
+    /** Lookup rotation and linear intensity of the environment, derived from its yaw and exposure. */
+    glm::mat3 environment_rotation = glm::mat3(1.f);
+    float environment_intensity = 1.f;
+
+    /** Coefficients of {irradiance} rotated by {environment_yaw} and scaled by {environment_intensity}. */
+    std::vector<glm::vec3> irradiance_coefficients;
+    bool coefficients_outdated = true;
+
+    /** Bumped whenever the environment changes, such that reflection probes capture it again. */
+    uint32_t environment_version = 0;
+
+    /** Index of the reflection probe that is checked first for a new capture, such that every probe gets a turn. */
+    size_t next_reflection_probe = 0;
+
+    /** What is rendered from, that of the camera except while capturing a reflection probe. */
+    glm::mat4 view_matrix = glm::mat4(1.f);
+    glm::mat4 projection_matrix = glm::mat4(1.f);
+    glm::vec3 view_position = glm::vec3(0.f);
+    /** Whether linear radiance is output instead of tone mapped colors, while capturing a reflection probe. */
+    bool linear_output = false;
+
     /** Whether the coordinate system should be drawn. */
     bool debug_mode = false;
+
+    /**
+     * A draw collected by {queue_pbr} or {queue_default}. {key} holds its pass, shader, material and depth from the
+     * most to the least significant bits, such that sorting by it groups draws that share state and orders them front
+     * to back within a group. */
+    struct DrawPacket {
+        uint64_t key;
+        DrawPass pass;
+        ShaderType shader;
+        uint32_t mesh_id;
+        /** Material of a pbr draw, 0 for a default draw which is drawn in {color}. */
+        uint32_t material_id;
+        glm::vec3 color;
+        glm::mat4 model_matrix;
+        ReflectionProbe *probe;
+    };
+
+    std::vector<DrawPacket> draw_queue;
+
+    /** Lights shaded by the pbr draws of {draw_queue}, set once per shader instead of once per draw. */
+    std::vector<glm::vec3> light_positions;
+    std::vector<glm::vec3> light_colors;
+
+    /**
+     * State switches made by {submit_draw_queue} this frame, and those it left out compared to setting all state for
+     * every draw. The latter is logged when it changes. */
+    uint32_t state_switches = 0;
+    uint32_t saved_state_switches = 0;
+    uint32_t reported_saved_state_switches = 0;
 public:
 
     Renderer(
@@ -38,16 +112,36 @@ public:
 
     void toggle_draw_coordinate();
 
-    void render_pbr(
-            uint32_t mesh_id, uint32_t material_id, std::vector<glm::vec3> positions,
-            std::vector<glm::vec3> colors, glm::mat4 model_matrix);
+    /** Starts collecting draws into the draw queue, pbr draws are shaded by the lights at {positions} of {colors}. */
+    void begin_draw_queue(const std::vector<glm::vec3> &positions, const std::vector<glm::vec3> &colors);
 
-    void render_default(uint32_t mesh_id, glm::vec3 color, glm::mat4 model_matrix);
+    /** Reflects {probe} if it is given and has been captured, the environment otherwise. */
+    void queue_pbr(uint32_t mesh_id, uint32_t material_id, glm::mat4 model_matrix, ReflectionProbe *probe = nullptr);
+
+    void queue_default(uint32_t mesh_id, glm::vec3 color, glm::mat4 model_matrix, DrawPass pass = PASS_OPAQUE);
+
+    /** Draws the queued draws sorted by their keys, only changing the state that differs between neighbours. */
+    void submit_draw_queue();
+
+    /** Returns the number of state switches the draw queue left out in the last frame. */
+    uint32_t get_saved_state_switches() const;
 
     void render_lines(uint32_t primitive_id, glm::mat4 model_matrix);
 
-    void switch_skybox(
-            TextureType p_cubemap, TextureType p_cubemap_irradiance, TextureType p_cubemap_pre_filter);
+    void switch_skybox(TextureType p_cubemap, TextureType p_cubemap_pre_filter);
+
+    /** Returns the cubemap of the environment that is bound, the one created on the first frame. */
+    TextureType get_cubemap() const;
+
+    /** Rotates the environment by {p_yaw} radians around the Y-axis, without re-baking it. */
+    void set_environment_yaw(float p_yaw);
+
+    float get_environment_yaw() const;
+
+    /** Scales the radiance of the environment by two to the power {p_exposure}, without re-baking it. */
+    void set_environment_exposure(float p_exposure);
+
+    float get_environment_exposure() const;
 
 private:
     const float WIDGET_CONE_BASE_RADIUS = .03f;
@@ -56,6 +150,7 @@ private:
     const float CYLINDER_LENGTH = .3f;
     const float CYLINDER_RADIUS = .02f;
 public:
+    /** Queues the widget of a selected object at {position} in the overlay pass. */
     void render_widget(glm::vec3 position);
 
     /**
@@ -72,6 +167,25 @@ public:
     float get_cylinder_radius(glm::vec3 position);
 
     void render_skybox();
+
+private:
+    /** Appends a draw to {draw_queue}, its key is made from its fields and the current view. */
+    void queue_packet(DrawPacket packet);
+
+    /** Uses {program} of {shader} for the draws that follow, setting the uniforms that are the same for all of them. */
+    void use_draw_shader(ShaderProgram *program, ShaderType shader);
+
+    /** Renders from the camera, undoing a reflection probe capture. */
+    void use_camera_view();
+
+    /**
+     * Performs a single step of the capture of the reflection probes of {scene}, continuing the capture in progress or
+     * else starting the next out of date probe. The cost per frame stays that of a face or a pre-filter level, however
+     * many probes there are. */
+    void update_reflection_probes(Scene *scene);
+
+    /** Renders the skybox and {scene} from {probe} into {face} of its capture. */
+    void capture_reflection_probe_face(Scene *scene, ReflectionProbe *probe, uint32_t face);
 };
 
 
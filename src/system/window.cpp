@@ -66,6 +66,11 @@ void window::cleanup()
 {
     if (!initialized) return;
 
+    if (shared_context_handle) {
+        glfwDestroyWindow(shared_context_handle);
+        shared_context_handle = nullptr;
+    }
+
     glfwDestroyWindow(window_handle);
     window_handle = nullptr;
 
@@ -105,6 +110,26 @@ void window::set_title(const char *p_title)
     glfwSetWindowTitle(window_handle, p_title);
 }
 
+GLFWwindow *window::create_shared_context()
+{
+    if (!initialized) return nullptr;
+
+    if (shared_context_handle) {
+        return shared_context_handle;
+    }
+
+    // the context version hints of {initialize} still apply
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    shared_context_handle = glfwCreateWindow(1, 1, "", NULL, window_handle);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
+    if (!shared_context_handle) {
+        nm_log::log(LOG_ERROR, "failed to create shared OpenGl context\n");
+    }
+
+    return shared_context_handle;
+}
+
 input *window::get_input_handler() const
 {
     return input_handler;
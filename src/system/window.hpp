@@ -27,6 +27,9 @@ private:
 
     GLFWwindow *window_handle = nullptr;
 
+    /** Hidden window of which the context shares objects with that of {window_handle}, see {create_shared_context}. */
+    GLFWwindow *shared_context_handle = nullptr;
+
     /** True when window has been successfully initialized with {initialize}. */
     bool initialized = false;
 
@@ -49,6 +52,12 @@ public:
 
     void set_title(const char *p_title);
 
+    /**
+     * Creates an OpenGL context that shares textures, buffers, shaders, and sync objects with the context of the
+     * window, such that another thread can create them while the window renders. It belongs to a hidden window that
+     * is destroyed by {cleanup}. Returns nullptr if it could not be created. */
+    GLFWwindow *create_shared_context();
+
     input *get_input_handler() const;
 
 private:
@@ -0,0 +1,316 @@
+#include "block_compression.hpp"
+
+#include <cmath>
+
+#include "../util/nm_log.hpp"
+
+/** Pixels of a 4x4 block in the range [0, 255], row by row. Only the first {channel_count} channels are used. */
+struct Block {
+    float pixels[16][4];
+};
+
+/** Copies the block at block coordinates {x}, {y} of a level, repeating the edge pixels for blocks that overhang it. */
+static void fetch_block(
+        const uint16_t *pixels, uint32_t width, uint32_t height, uint32_t channel_count, uint32_t x, uint32_t y,
+        Block *block)
+{
+    for (uint32_t i = 0; i < 16; i++) {
+        uint32_t pixel_x = x * 4 + i % 4;
+        uint32_t pixel_y = y * 4 + i / 4;
+        if (pixel_x >= width) {
+            pixel_x = width - 1;
+        }
+        if (pixel_y >= height) {
+            pixel_y = height - 1;
+        }
+
+        const uint16_t *pixel = pixels + ((size_t) pixel_y * width + pixel_x) * channel_count;
+        for (uint32_t c = 0; c < channel_count; c++) {
+            block->pixels[i][c] = (float) pixel[c] / 257.f;
+        }
+    }
+}
+
+static uint8_t quantize(float value, float max)
+{
+    value = roundf(value * max / 255.f);
+
+    return (uint8_t) (value < 0.f ? 0.f : value > max ? max : value);
+}
+
+/** Encodes channel {channel} of {block} as a BC4 block of 8 bytes. */
+static void encode_bc4(const Block *block, uint32_t channel, uint8_t *out)
+{
+    float min = 255.f;
+    float max = 0.f;
+    for (const auto &pixel : block->pixels) {
+        min = fminf(min, pixel[channel]);
+        max = fmaxf(max, pixel[channel]);
+    }
+
+    // the first endpoint being larger selects the mode with six interpolated values
+    uint8_t red_0 = quantize(max, 255.f);
+    uint8_t red_1 = quantize(min, 255.f);
+    float palette[8] = {(float) red_0, (float) red_1};
+    for (int i = 2; i < 8; i++) {
+        palette[i] = ((float) (8 - i) * red_0 + (float) (i - 1) * red_1) / 7.f;
+    }
+
+    uint64_t indices = 0;
+    for (uint32_t i = 0; i < 16; i++) {
+        uint64_t best_index = 0;
+        float best_error = INFINITY;
+        for (uint64_t j = 0; j < 8; j++) {
+            float error = fabsf(block->pixels[i][channel] - palette[j]);
+            if (error < best_error) {
+                best_error = error;
+                best_index = j;
+            }
+        }
+        indices |= best_index << (3 * i);
+    }
+
+    out[0] = red_0;
+    out[1] = red_1;
+    for (int i = 0; i < 6; i++) {
+        out[2 + i] = (uint8_t) (indices >> (8 * i));
+    }
+}
+
+static uint16_t pack_565(const float *color)
+{
+    return (uint16_t) (quantize(color[0], 31.f) << 11 | quantize(color[1], 63.f) << 5 | quantize(color[2], 31.f));
+}
+
+static void unpack_565(uint16_t packed, float *color)
+{
+    uint32_t r = packed >> 11 & 31;
+    uint32_t g = packed >> 5 & 63;
+    uint32_t b = packed & 31;
+    color[0] = (float) (r << 3 | r >> 2);
+    color[1] = (float) (g << 2 | g >> 4);
+    color[2] = (float) (b << 3 | b >> 2);
+}
+
+/** Picks the closest of the four colors between {endpoints} for every pixel, returns the summed squared error. */
+static float fit_bc1_indices(const Block *block, const uint16_t *endpoints, uint32_t *indices)
+{
+    float palette[4][3];
+    unpack_565(endpoints[0], palette[0]);
+    unpack_565(endpoints[1], palette[1]);
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2.f * palette[0][c] + palette[1][c]) / 3.f;
+        palette[3][c] = (palette[0][c] + 2.f * palette[1][c]) / 3.f;
+    }
+
+    float total_error = 0.f;
+    *indices = 0;
+    for (uint32_t i = 0; i < 16; i++) {
+        uint32_t best_index = 0;
+        float best_error = INFINITY;
+        for (uint32_t j = 0; j < 4; j++) {
+            float error = 0.f;
+            for (int c = 0; c < 3; c++) {
+                float difference = block->pixels[i][c] - palette[j][c];
+                error += difference * difference;
+            }
+            if (error < best_error) {
+                best_error = error;
+                best_index = j;
+            }
+        }
+        *indices |= best_index << (2 * i);
+        total_error += best_error;
+    }
+
+    return total_error;
+}
+
+/** Orders quantized {endpoints} such that the block uses four colors, then fits the indices. */
+static float fit_bc1(const Block *block, const float *color_0, const float *color_1, uint16_t *endpoints,
+                     uint32_t *indices)
+{
+    endpoints[0] = pack_565(color_0);
+    endpoints[1] = pack_565(color_1);
+    if (endpoints[0] < endpoints[1]) {
+        uint16_t swap = endpoints[0];
+        endpoints[0] = endpoints[1];
+        endpoints[1] = swap;
+    }
+
+    return fit_bc1_indices(block, endpoints, indices);
+}
+
+/**
+ * Encodes the RGB channels of {block} as a BC1 block of 8 bytes. The endpoints are the extremes of the pixels along
+ * their principal axis, after which they are refined once with a least squares fit to the chosen indices. */
+static void encode_bc1(const Block *block, uint8_t *out)
+{
+    float mean[3] = {};
+    for (const auto &pixel : block->pixels) {
+        for (int c = 0; c < 3; c++) {
+            mean[c] += pixel[c] / 16.f;
+        }
+    }
+
+    float covariance[6] = {};
+    for (const auto &pixel : block->pixels) {
+        float r = pixel[0] - mean[0];
+        float g = pixel[1] - mean[1];
+        float b = pixel[2] - mean[2];
+        covariance[0] += r * r;
+        covariance[1] += r * g;
+        covariance[2] += r * b;
+        covariance[3] += g * g;
+        covariance[4] += g * b;
+        covariance[5] += b * b;
+    }
+
+    // principal axis by power iteration, starting from the luminance direction
+    float axis[3] = {.299f, .587f, .114f};
+    for (int i = 0; i < 8; i++) {
+        float next[3] = {
+                covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+                covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+                covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]};
+        float length = sqrtf(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+        if (length < 1e-6f) {
+            break;
+        }
+        for (int c = 0; c < 3; c++) {
+            axis[c] = next[c] / length;
+        }
+    }
+
+    float min_t = INFINITY;
+    float max_t = -INFINITY;
+    for (const auto &pixel : block->pixels) {
+        float t = (pixel[0] - mean[0]) * axis[0] + (pixel[1] - mean[1]) * axis[1] + (pixel[2] - mean[2]) * axis[2];
+        min_t = fminf(min_t, t);
+        max_t = fmaxf(max_t, t);
+    }
+
+    float color_0[3];
+    float color_1[3];
+    for (int c = 0; c < 3; c++) {
+        color_0[c] = mean[c] + axis[c] * max_t;
+        color_1[c] = mean[c] + axis[c] * min_t;
+    }
+
+    uint16_t endpoints[2];
+    uint32_t indices;
+    float error = fit_bc1(block, color_0, color_1, endpoints, &indices);
+
+    // solve for the endpoints that best reproduce the pixels with the chosen indices
+    static const float WEIGHTS[4] = {1.f, 0.f, 2.f / 3.f, 1.f / 3.f};
+    float aa = 0.f, ab = 0.f, bb = 0.f;
+    float ax[3] = {}, bx[3] = {};
+    for (uint32_t i = 0; i < 16; i++) {
+        float a = WEIGHTS[indices >> (2 * i) & 3];
+        float b = 1.f - a;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int c = 0; c < 3; c++) {
+            ax[c] += a * block->pixels[i][c];
+            bx[c] += b * block->pixels[i][c];
+        }
+    }
+
+    float determinant = aa * bb - ab * ab;
+    if (fabsf(determinant) > 1e-6f) {
+        for (int c = 0; c < 3; c++) {
+            color_0[c] = (bb * ax[c] - ab * bx[c]) / determinant;
+            color_1[c] = (aa * bx[c] - ab * ax[c]) / determinant;
+        }
+
+        uint16_t refined_endpoints[2];
+        uint32_t refined_indices;
+        if (fit_bc1(block, color_0, color_1, refined_endpoints, &refined_indices) < error) {
+            endpoints[0] = refined_endpoints[0];
+            endpoints[1] = refined_endpoints[1];
+            indices = refined_indices;
+        }
+    }
+
+    out[0] = (uint8_t) endpoints[0];
+    out[1] = (uint8_t) (endpoints[0] >> 8);
+    out[2] = (uint8_t) endpoints[1];
+    out[3] = (uint8_t) (endpoints[1] >> 8);
+    for (int i = 0; i < 4; i++) {
+        out[4 + i] = (uint8_t) (indices >> (8 * i));
+    }
+}
+
+int BlockCompression::compress(TextureData *data, Format format)
+{
+    if (data->face_count != 1 || data->type != GL_UNSIGNED_SHORT) {
+        nm_log::log(LOG_ERROR, "block compression requires a 16 bit single face texture\n");
+
+        return EXIT_FAILURE;
+    }
+
+    uint32_t channel_count = TextureData::get_pixel_size(data->format, data->type) / 2;
+    static const uint32_t REQUIRED_CHANNEL_COUNTS[] = {3, 1, 2};
+    uint32_t required_channel_count = REQUIRED_CHANNEL_COUNTS[format];
+    if (channel_count < required_channel_count) {
+        nm_log::log(LOG_ERROR, "texture has too few channels for the block compression format\n");
+
+        return EXIT_FAILURE;
+    }
+
+    GLenum internal_format;
+    switch (format) {
+        case BC1:
+            internal_format = GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+            break;
+        case BC4:
+            internal_format = GL_COMPRESSED_RED_RGTC1;
+            break;
+        case BC5:
+        default:
+            internal_format = GL_COMPRESSED_RG_RGTC2;
+    }
+    TextureData compressed{
+            data->texture_type, internal_format, GL_NONE, GL_NONE, data->width, data->height, data->level_count,
+            data->face_count, {}};
+
+    size_t size = 0;
+    for (uint32_t level = 0; level < compressed.level_count; level++) {
+        size += compressed.get_level_size(level);
+    }
+    compressed.data.resize(size);
+
+    uint32_t block_size = TextureData::get_block_size(compressed.internal_format);
+    for (uint32_t level = 0; level < data->level_count; level++) {
+        const auto *pixels = (const uint16_t *) data->get_pixels(level, 0);
+        uint8_t *blocks = compressed.get_pixels(level, 0);
+        uint32_t width = data->get_level_width(level);
+        uint32_t height = data->get_level_height(level);
+
+        for (uint32_t y = 0; y < compressed.get_row_count(level); y++) {
+            for (uint32_t x = 0; x < (width + 3) / 4; x++) {
+                Block block{};
+                fetch_block(pixels, width, height, channel_count, x, y, &block);
+
+                switch (format) {
+                    case BC1:
+                        encode_bc1(&block, blocks);
+                        break;
+                    case BC4:
+                        encode_bc4(&block, 0, blocks);
+                        break;
+                    case BC5:
+                    default:
+                        encode_bc4(&block, 0, blocks);
+                        encode_bc4(&block, 1, blocks + 8);
+                }
+                blocks += block_size;
+            }
+        }
+    }
+
+    *data = std::move(compressed);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,268 @@
+#include "mip_chain.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64)
+
+#include <xmmintrin.h>
+
+#define MIP_CHAIN_SSE
+
+#endif
+
+#include "../util/nm_log.hpp"
+
+/** Lobes of the Lanczos kernel. */
+static const int LANCZOS_A = 3;
+
+/** A level in floating point, channels are interleaved. */
+struct Image {
+    uint32_t width;
+    uint32_t height;
+    uint32_t channel_count;
+    std::vector<float> pixels;
+};
+
+/** Filter taps to reduce {in_size} samples to {out_size}, output {i} uses {tap_count} samples starting at {first[i]}. */
+struct Kernel {
+    uint32_t tap_count;
+    std::vector<int> first;
+    std::vector<float> weights;
+};
+
+static float lanczos(float x)
+{
+    x = fabsf(x);
+    if (x < 1e-6f) {
+        return 1.f;
+    }
+    if (x >= (float) LANCZOS_A) {
+        return 0.f;
+    }
+
+    float pi_x = (float) M_PI * x;
+
+    return (float) LANCZOS_A * sinf(pi_x) * sinf(pi_x / (float) LANCZOS_A) / (pi_x * pi_x);
+}
+
+static void compute_kernel(Kernel *kernel, uint32_t in_size, uint32_t out_size)
+{
+    // the kernel is stretched by the reduction factor, to cut off frequencies the output cannot represent
+    float scale = (float) in_size / (float) out_size;
+    float support = (float) LANCZOS_A * scale;
+    kernel->tap_count = (uint32_t) ceilf(2.f * support) + 1;
+    kernel->first.resize(out_size);
+    kernel->weights.resize((size_t) out_size * kernel->tap_count);
+
+    for (uint32_t i = 0; i < out_size; i++) {
+        float center = ((float) i + .5f) * scale;
+        int first = (int) floorf(center - support);
+        kernel->first[i] = first;
+
+        float *weights = &kernel->weights[(size_t) i * kernel->tap_count];
+        float sum = 0.f;
+        for (uint32_t t = 0; t < kernel->tap_count; t++) {
+            weights[t] = lanczos(((float) (first + (int) t) + .5f - center) / scale);
+            sum += weights[t];
+        }
+        for (uint32_t t = 0; t < kernel->tap_count; t++) {
+            weights[t] /= sum;
+        }
+    }
+}
+
+/** Adds {weight} times {count} values of {src} to {dst}. */
+static void accumulate_row(float *dst, const float *src, float weight, size_t count)
+{
+    size_t i = 0;
+#ifdef MIP_CHAIN_SSE
+    __m128 w = _mm_set1_ps(weight);
+    for (; i + 4 <= count; i += 4) {
+        __m128 d = _mm_loadu_ps(dst + i);
+        __m128 s = _mm_loadu_ps(src + i);
+        _mm_storeu_ps(dst + i, _mm_add_ps(d, _mm_mul_ps(s, w)));
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] += src[i] * weight;
+    }
+}
+
+/**
+ * Filters {in_height} rows of {row_length} values into {out_height} rows. Whole rows are accumulated at once, which
+ * keeps memory access sequential and vectorizes well regardless of the channel count. */
+static void reduce_rows(
+        const float *in, uint32_t in_height, float *out, uint32_t out_height, size_t row_length)
+{
+    Kernel kernel{};
+    compute_kernel(&kernel, in_height, out_height);
+
+    for (uint32_t i = 0; i < out_height; i++) {
+        float *dst = out + (size_t) i * row_length;
+        memset(dst, 0, row_length * sizeof(float));
+
+        const float *weights = &kernel.weights[(size_t) i * kernel.tap_count];
+        for (uint32_t t = 0; t < kernel.tap_count; t++) {
+            if (weights[t] == 0.f) {
+                continue;
+            }
+
+            // wrap around, the textures are tiled
+            int row = (kernel.first[i] + (int) t) % (int) in_height;
+            if (row < 0) {
+                row += (int) in_height;
+            }
+            accumulate_row(dst, in + (size_t) row * row_length, weights[t], row_length);
+        }
+    }
+}
+
+/** Swaps rows and columns of {width} by {height} pixels of {channel_count} values. */
+static void transpose(const float *in, uint32_t width, uint32_t height, uint32_t channel_count, float *out)
+{
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            memcpy(out + ((size_t) x * height + y) * channel_count, in + ((size_t) y * width + x) * channel_count,
+                   channel_count * sizeof(float));
+        }
+    }
+}
+
+/** Halves the dimensions of {in}, filtering the columns and then the rows by filtering the transpose. */
+static void downsample(const Image *in, Image *out)
+{
+    out->width = in->width > 1 ? in->width / 2 : 1;
+    out->height = in->height > 1 ? in->height / 2 : 1;
+    out->channel_count = in->channel_count;
+    out->pixels.resize((size_t) out->width * out->height * out->channel_count);
+
+    size_t in_row_length = (size_t) in->width * in->channel_count;
+    std::vector<float> columns((size_t) out->height * in_row_length);
+    reduce_rows(in->pixels.data(), in->height, columns.data(), out->height, in_row_length);
+
+    std::vector<float> transposed(columns.size());
+    transpose(columns.data(), in->width, out->height, in->channel_count, transposed.data());
+
+    size_t transposed_row_length = (size_t) out->height * in->channel_count;
+    std::vector<float> rows((size_t) out->width * transposed_row_length);
+    reduce_rows(transposed.data(), in->width, rows.data(), out->width, transposed_row_length);
+
+    transpose(rows.data(), out->height, out->width, in->channel_count, out->pixels.data());
+}
+
+static float srgb_to_linear(float value)
+{
+    return value <= .04045f ? value / 12.92f : powf((value + .055f) / 1.055f, 2.4f);
+}
+
+static float linear_to_srgb(float value)
+{
+    return value <= .0031308f ? value * 12.92f : 1.055f * powf(value, 1.f / 2.4f) - .055f;
+}
+
+/** Whether channel {channel} of {channel_count} holds alpha under {semantic}. */
+static bool is_alpha(MipChain::Semantic semantic, uint32_t channel, uint32_t channel_count)
+{
+    return semantic == MipChain::COLOR && (channel_count == 2 || channel_count == 4) && channel == channel_count - 1;
+}
+
+/** Converts quantized {pixels} to the space they are filtered in. */
+static void decode_level(const uint8_t *pixels, GLenum type, MipChain::Semantic semantic, Image *image)
+{
+    size_t value_count = image->pixels.size();
+    for (size_t i = 0; i < value_count; i++) {
+        float value;
+        if (type == GL_UNSIGNED_SHORT) {
+            value = (float) ((const uint16_t *) pixels)[i] / 65535.f;
+        } else {
+            value = (float) pixels[i] / 255.f;
+        }
+
+        uint32_t channel = i % image->channel_count;
+        if (semantic == MipChain::COLOR && !is_alpha(semantic, channel, image->channel_count)) {
+            value = srgb_to_linear(value);
+        } else if (semantic == MipChain::NORMAL && channel < 3) {
+            value = value * 2.f - 1.f;
+        }
+
+        image->pixels[i] = value;
+    }
+}
+
+/** Converts {image} back to quantized {pixels}, the inverse of {decode_level}. */
+static void encode_level(const Image *image, GLenum type, MipChain::Semantic semantic, uint8_t *pixels)
+{
+    size_t pixel_count = (size_t) image->width * image->height;
+    for (size_t p = 0; p < pixel_count; p++) {
+        const float *pixel = &image->pixels[p * image->channel_count];
+
+        // filtering shortens normals, restore their length
+        float length = 1.f;
+        if (semantic == MipChain::NORMAL && image->channel_count >= 3) {
+            length = sqrtf(pixel[0] * pixel[0] + pixel[1] * pixel[1] + pixel[2] * pixel[2]);
+            if (length < 1e-6f) {
+                length = 1.f;
+            }
+        }
+
+        for (uint32_t c = 0; c < image->channel_count; c++) {
+            float value = pixel[c];
+            if (semantic == MipChain::COLOR && !is_alpha(semantic, c, image->channel_count)) {
+                value = linear_to_srgb(value > 0.f ? value : 0.f);
+            } else if (semantic == MipChain::NORMAL && c < 3) {
+                value = value / length * .5f + .5f;
+            }
+
+            // the Lanczos kernel has negative lobes and may overshoot
+            value = value < 0.f ? 0.f : value > 1.f ? 1.f : value;
+
+            size_t i = p * image->channel_count + c;
+            if (type == GL_UNSIGNED_SHORT) {
+                ((uint16_t *) pixels)[i] = (uint16_t) lroundf(value * 65535.f);
+            } else {
+                pixels[i] = (uint8_t) lroundf(value * 255.f);
+            }
+        }
+    }
+}
+
+int MipChain::generate(TextureData *data, Semantic semantic)
+{
+    if (data->face_count != 1 || (data->type != GL_UNSIGNED_BYTE && data->type != GL_UNSIGNED_SHORT)) {
+        nm_log::log(LOG_ERROR, "mip chains can only be generated for 8 or 16 bit single face textures\n");
+
+        return EXIT_FAILURE;
+    }
+
+    Image image{};
+    image.width = data->width;
+    image.height = data->height;
+    image.channel_count = TextureData::get_pixel_size(data->format, data->type) /
+                          (data->type == GL_UNSIGNED_SHORT ? 2 : 1);
+    image.pixels.resize((size_t) image.width * image.height * image.channel_count);
+    decode_level(data->data.data(), data->type, semantic, &image);
+
+    // keep level 0 as-is, such that it is not altered by quantization round trips
+    uint32_t level_count = 1;
+    while ((data->width >> level_count) > 0 || (data->height >> level_count) > 0) {
+        level_count++;
+    }
+    data->level_count = level_count;
+
+    size_t size = 0;
+    for (uint32_t level = 0; level < level_count; level++) {
+        size += data->get_level_size(level);
+    }
+    data->data.resize(size);
+
+    for (uint32_t level = 1; level < level_count; level++) {
+        Image next{};
+        downsample(&image, &next);
+        encode_level(&next, data->type, semantic, data->get_pixels(level, 0));
+        image = std::move(next);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,30 @@
+#ifndef TOOLS_MIP_CHAIN_HPP
+#define TOOLS_MIP_CHAIN_HPP
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "../system/opengl/texture_data.hpp"
+
+/**
+ * Generates mip chains on the CPU with a separable Lanczos-3 filter, as a deterministic and higher quality replacement
+ * of {glGenerateMipmap}. Every level is filtered from the unquantized previous level, wrapping around the edges since
+ * material textures are tiled. */
+struct MipChain {
+    /** What the channels hold, which determines the space they are filtered in. */
+    enum Semantic {
+        /** sRGB encoded color, filtered in linear space. The last channel is alpha if there are 2 or 4 channels. */
+        COLOR,
+        /** Tangent space normal in the first three channels, renormalized after filtering. */
+        NORMAL,
+        /** Linear values such as roughness or displacement, filtered as-is. */
+        LINEAR
+    };
+
+    /**
+     * Replaces the levels of {data} with level 0 followed by all levels down to 1x1.
+     * {data} must be a single face of {GL_UNSIGNED_BYTE} or {GL_UNSIGNED_SHORT} values. */
+    static int generate(TextureData *data, Semantic semantic);
+};
+
+#endif //TOOLS_MIP_CHAIN_HPP
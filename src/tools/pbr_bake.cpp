@@ -0,0 +1,142 @@
+#include <cstdlib>
+
+#include <glad/glad.h>
+
+#define GLFW_INCLUDE_NONE
+
+#include <GLFW/glfw3.h>
+
+#include "../util/nm_log.hpp"
+#include "../util/util.hpp"
+#include "../system/opengl/cubemap_converter.hpp"
+#include "../system/opengl/dominant_light.hpp"
+#include "../system/opengl/ibl_tier.hpp"
+#include "../system/opengl/spherical_harmonics.hpp"
+#include "../system/opengl/texture.hpp"
+#include "../system/opengl/environment_bundle.hpp"
+
+/**
+ * Offline baker for the textures that are otherwise generated at run time.
+ * Requires an OpenGL context since it runs the same passes as {Texture} does at run time, except for the cubemap which
+ * is converted on the CPU. */
+
+int bake_environment(const char *hdr_file, const char *bundle_file);
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(
+                stderr,
+                "USAGE: %s {hdr} {bundle} [{tier} [{layout}]]\n\n"
+                "  Bakes the dominant light, cubemap, irradiance coefficients and pre-filter\n"
+                "  cubemap of equirectangular environment {hdr} into {bundle}, at the\n"
+                "  resolutions and formats of IBL tier {tier}: low, medium (default), or high,\n"
+                "  and in {layout}: cubemap (default), or octahedral\n",
+                argv[0]
+        );
+        return EXIT_FAILURE;
+    }
+
+    IblTier::Level tier = IblTier::DEFAULT;
+    if (argc > 3 && IblTier::find(argv[3], &tier) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    IblTier::Layout layout = IblTier::DEFAULT_LAYOUT;
+    if (argc > 4 && IblTier::find_layout(argv[4], &layout) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    IblTier::select_layout(layout);
+    IblTier::select(tier);
+    Texture::initialize_decoding();
+
+    if (glfwInit() == GLFW_FALSE) {
+        nm_log::log(LOG_ERROR, "failed to initialize GLFW\n");
+        return EXIT_FAILURE;
+    }
+
+    // the window is never shown, it only provides the OpenGL context
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow *window_handle = glfwCreateWindow(1, 1, "pbr_bake", NULL, NULL);
+    if (window_handle == NULL) {
+        nm_log::log(LOG_ERROR, "failed to create OpenGl context\n");
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+
+    glfwMakeContextCurrent(window_handle);
+
+    if (gladLoadGL() == 0) {
+        nm_log::log(LOG_ERROR, "failed to load OpenGL extensions\n");
+        glfwDestroyWindow(window_handle);
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+
+    // same state as the application, the passes depend on it
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+    glDepthFunc(GL_LEQUAL);
+
+    int rval = bake_environment(argv[1], argv[2]);
+
+    glfwDestroyWindow(window_handle);
+    glfwTerminate();
+
+    return rval;
+}
+
+int bake_environment(const char *hdr_file, const char *bundle_file)
+{
+    // the cubemap and irradiance are computed on the CPU, only the passes deriving textures require the context
+    char *buffer = nullptr;
+    size_t size;
+    TextureData hdr{};
+    TextureData entries[EnvironmentBundle::ENTRY_COUNT]{};
+    SphericalHarmonics irradiance{};
+    DominantLight light{};
+    ThreadPool pool;
+    const IblTier *tier = IblTier::get();
+    bool octahedral = IblTier::get_layout() == IblTier::OCTAHEDRAL;
+    uint32_t resolution = IblTier::get_layout_resolution(tier->cubemap_resolution);
+    if (Util::read_file(&buffer, &size, hdr_file) == EXIT_FAILURE ||
+        Texture::decode_tex(&hdr, buffer, size, TextureManager::RADIANCE) == EXIT_FAILURE ||
+        DominantLight::extract(&light, &hdr) == EXIT_FAILURE ||
+        (octahedral
+         ? CubemapConverter::convert_octahedral(&entries[EnvironmentBundle::CUBEMAP], &hdr, resolution, &pool)
+         : CubemapConverter::convert(&entries[EnvironmentBundle::CUBEMAP], &hdr, resolution, &pool)) ==
+        EXIT_FAILURE ||
+        TextureData::convert_rgb(&entries[EnvironmentBundle::CUBEMAP], tier->cubemap_format) == EXIT_FAILURE ||
+        SphericalHarmonics::project_irradiance(&irradiance, &entries[EnvironmentBundle::CUBEMAP]) == EXIT_FAILURE) {
+        nm_log::log(LOG_ERROR, "failed to load \"%s\"\n", hdr_file);
+        delete[] buffer;
+
+        return EXIT_FAILURE;
+    }
+    delete[] buffer;
+    SphericalHarmonics::write_texture_data(&irradiance, &entries[EnvironmentBundle::IRRADIANCE]);
+    DominantLight::write_texture_data(&light, &entries[EnvironmentBundle::DOMINANT_LIGHT]);
+
+    // generate all other textures exactly like the texture manager would
+    Texture cubemap{};
+    Texture pre_filter{};
+    Texture::create_tex_from_data(&cubemap, &entries[EnvironmentBundle::CUBEMAP], 0, TextureManager::CLAMP);
+    Texture::create_pre_filtered_cubemap_from_cubemap(&pre_filter, &cubemap, 0);
+    Texture::delete_tex(&cubemap);
+
+    // the pre-filter texture has a partial mip chain
+    int rval = Texture::read_tex(
+            &pre_filter, &entries[EnvironmentBundle::PRE_FILTER], Texture::PRE_FILTER_LEVEL_COUNT);
+    Texture::delete_tex(&pre_filter);
+
+    if (rval == EXIT_FAILURE || EnvironmentBundle::write(bundle_file, entries) == EXIT_FAILURE) {
+        nm_log::log(LOG_ERROR, "failed to bake \"%s\"\n", bundle_file);
+
+        return EXIT_FAILURE;
+    }
+
+    nm_log::log(LOG_INFO, "baked \"%s\" into \"%s\"\n", hdr_file, bundle_file);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,131 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include <glad/glad.h>
+
+#include "../util/nm_log.hpp"
+#include "../system/opengl/texture_data.hpp"
+#include "../system/opengl/texture_file.hpp"
+
+/**
+ * Generates the BRDF lookup table of the split sum approximation at build time, it depends on nothing but the BRDF.
+ * Every texel holds the scale (red) and bias (green) applied to F0 for {n_dot_v} along X and roughness along Y,
+ * integrated with GGX importance sampling like the pass it replaces. */
+
+/** Number of importance samples per texel. */
+static const uint32_t SAMPLE_COUNT = 1024;
+
+int generate_brdf_lut(TextureData *lut, uint32_t resolution);
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(
+                stderr,
+                "USAGE: %s {resolution} {output}\n\n"
+                "  Integrates the BRDF lookup table at {resolution} by {resolution} texels and writes it to texture\n"
+                "  file {output}\n",
+                argv[0]
+        );
+        return EXIT_FAILURE;
+    }
+
+    char *end;
+    unsigned long resolution = strtoul(argv[1], &end, 10);
+    if (*end != '\0' || resolution == 0 || resolution > 4096) {
+        nm_log::log(LOG_ERROR, "\"%s\" is not a valid resolution\n", argv[1]);
+
+        return EXIT_FAILURE;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    TextureData lut{};
+    if (generate_brdf_lut(&lut, (uint32_t) resolution) == EXIT_FAILURE ||
+        TextureFile::write(argv[2], &lut) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    nm_log::log(LOG_INFO, "generated %lux%lu BRDF LUT \"%s\" in %.0f ms\n", resolution, resolution, argv[2], ms);
+
+    return EXIT_SUCCESS;
+}
+
+/** Reverses the bits of {bits} into a fraction, the second coordinate of the Hammersley point set. */
+static float get_radical_inverse(uint32_t bits)
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+
+    return (float) bits * 2.3283064365386963e-10f; // / 0x100000000
+}
+
+/** Schlick-GGX geometry term, with the k used for image based lighting. */
+static float get_geometry_schlick_ggx(float n_dot_v, float roughness)
+{
+    float k = (roughness * roughness) / 2.f;
+
+    return n_dot_v / (n_dot_v * (1.f - k) + k);
+}
+
+/** Writes the scale and bias for {n_dot_v} and {roughness} to {result}. */
+static void integrate_brdf(float n_dot_v, float roughness, float *result)
+{
+    // the normal is +Z and the view direction lies in the XZ plane
+    float v[3] = {sqrtf(1.f - n_dot_v * n_dot_v), 0.f, n_dot_v};
+    float a = roughness * roughness;
+    float g_v = get_geometry_schlick_ggx(n_dot_v, roughness);
+
+    double scale = 0.;
+    double bias = 0.;
+    for (uint32_t i = 0; i < SAMPLE_COUNT; i++) {
+        auto phi = (float) (2. * M_PI * i / SAMPLE_COUNT);
+        float x = get_radical_inverse(i);
+        float cos_theta = sqrtf((1.f - x) / (1.f + (a * a - 1.f) * x));
+        float sin_theta = sqrtf(1.f - cos_theta * cos_theta);
+        float h[3] = {cosf(phi) * sin_theta, sinf(phi) * sin_theta, cos_theta};
+
+        float v_dot_h = v[0] * h[0] + v[1] * h[1] + v[2] * h[2];
+        float n_dot_l = 2.f * v_dot_h * h[2] - v[2];
+        if (n_dot_l <= 0.f) {
+            continue;
+        }
+
+        v_dot_h = fmaxf(v_dot_h, 0.f);
+        float g = get_geometry_schlick_ggx(n_dot_l, roughness) * g_v;
+        float g_vis = g * v_dot_h / (h[2] * n_dot_v);
+        float f_c = powf(1.f - v_dot_h, 5.f);
+
+        scale += (1.f - f_c) * g_vis;
+        bias += f_c * g_vis;
+    }
+
+    result[0] = (float) (scale / SAMPLE_COUNT);
+    result[1] = (float) (bias / SAMPLE_COUNT);
+}
+
+int generate_brdf_lut(TextureData *lut, uint32_t resolution)
+{
+    *lut = TextureData{GL_TEXTURE_2D, GL_RG16F, GL_RG, GL_HALF_FLOAT, resolution, resolution, 1, 1, {}};
+    lut->data.resize(lut->get_level_size(0));
+
+    // texel centers, the first row is the bottom row of the texture
+    for (uint32_t j = 0; j < resolution; j++) {
+        float roughness = ((float) j + .5f) / (float) resolution;
+        for (uint32_t i = 0; i < resolution; i++) {
+            float n_dot_v = ((float) i + .5f) / (float) resolution;
+
+            float result[2];
+            integrate_brdf(n_dot_v, roughness, result);
+
+            uint16_t halves[2] = {TextureData::float_to_half(result[0]), TextureData::float_to_half(result[1])};
+            memcpy(&lut->data[((size_t) j * resolution + i) * sizeof(halves)], halves, sizeof(halves));
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
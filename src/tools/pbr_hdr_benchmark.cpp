@@ -0,0 +1,121 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#define STB_IMAGE_IMPLEMENTATION
+
+#include <stb_image.h>
+
+#include "../util/nm_log.hpp"
+#include "../util/util.hpp"
+#include "../system/opengl/radiance_decoder.hpp"
+
+/**
+ * Compares {RadianceDecoder} with the stbi decoder it replaces, on speed and on the decoded values. Every image is
+ * decoded a number of times by each, of which the fastest time is reported. */
+
+/** Number of times every image is decoded by each decoder. */
+static const int ITERATION_COUNT = 20;
+
+int benchmark_image(const char *image_file);
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(
+                stderr,
+                "USAGE: %s {image}...\n\n"
+                "  Decodes every Radiance HDR {image} with stbi and with the SIMD decoder, and reports their timings.\n",
+                argv[0]
+        );
+        return EXIT_FAILURE;
+    }
+
+    // match the orientation of the decoder, which flips like the application does
+    stbi_set_flip_vertically_on_load(1);
+
+    int rval = EXIT_SUCCESS;
+    for (int i = 1; i < argc; i++) {
+        if (benchmark_image(argv[i]) == EXIT_FAILURE) {
+            rval = EXIT_FAILURE;
+        }
+    }
+
+    return rval;
+}
+
+/** Returns the milliseconds passed since {start}. */
+static double get_elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int benchmark_image(const char *image_file)
+{
+    char *buffer = nullptr;
+    size_t size;
+    if (Util::read_file(&buffer, &size, image_file) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    double stbi_time = INFINITY;
+    double float_time = INFINITY;
+    double half_time = INFINITY;
+    float *reference = nullptr;
+    TextureData floats{};
+    TextureData halves{};
+    int width, height, channel_count;
+    int rval = EXIT_SUCCESS;
+    for (int i = 0; i < ITERATION_COUNT && rval == EXIT_SUCCESS; i++) {
+        auto start = std::chrono::steady_clock::now();
+        stbi_image_free(reference);
+        reference = stbi_loadf_from_memory(
+                (const unsigned char *) buffer, (int) size, &width, &height, &channel_count, 3);
+        stbi_time = fmin(stbi_time, get_elapsed_ms(start));
+
+        start = std::chrono::steady_clock::now();
+        rval |= RadianceDecoder::decode(&floats, buffer, size, GL_FLOAT);
+        float_time = fmin(float_time, get_elapsed_ms(start));
+
+        start = std::chrono::steady_clock::now();
+        rval |= RadianceDecoder::decode(&halves, buffer, size, GL_HALF_FLOAT);
+        half_time = fmin(half_time, get_elapsed_ms(start));
+
+        if (!reference) {
+            rval = EXIT_FAILURE;
+        }
+    }
+    delete[] buffer;
+
+    if (rval == EXIT_FAILURE || floats.width != (uint32_t) width || floats.height != (uint32_t) height) {
+        nm_log::log(LOG_ERROR, "failed to decode \"%s\"\n", image_file);
+        stbi_image_free(reference);
+
+        return EXIT_FAILURE;
+    }
+
+    // differences relative to the value, ignoring values that are flushed to zero or clamped by half floats
+    const auto *float_values = (const float *) floats.data.data();
+    const auto *half_values = (const uint16_t *) halves.data.data();
+    float float_error = 0.f;
+    float half_error = 0.f;
+    for (size_t i = 0; i < (size_t) width * height * 3; i++) {
+        if (reference[i] < 1e-30f) {
+            continue;
+        }
+        float_error = fmaxf(float_error, fabsf(float_values[i] - reference[i]) / reference[i]);
+        if (reference[i] <= 65504.f) {
+            float half_value = TextureData::half_to_float(half_values[i]);
+            half_error = fmaxf(half_error, fabsf(half_value - reference[i]) / reference[i]);
+        }
+    }
+    stbi_image_free(reference);
+
+    nm_log::log(LOG_INFO, "\"%s\" %dx%d: stbi %.2f ms, float %.2f ms (%.1fx), half %.2f ms (%.1fx)\n",
+                image_file, width, height, stbi_time, float_time, stbi_time / float_time, half_time,
+                stbi_time / half_time);
+    nm_log::log(LOG_INFO, "largest relative difference with stbi: float %g, half %g\n", float_error, half_error);
+
+    return EXIT_SUCCESS;
+}
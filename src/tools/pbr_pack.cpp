@@ -0,0 +1,25 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "../system/manager/resource_pack.hpp"
+
+/**
+ * Writes resource files into a single {ResourcePack}. Files are found in the pack by the name they are given on the
+ * command line, which should match the name the application opens them by relative to its working directory. */
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(
+                stderr,
+                "USAGE: %s {pack} {file}...\n\n"
+                "  Writes every {file} that exists into {pack}, named as given\n",
+                argv[0]
+        );
+        return EXIT_FAILURE;
+    }
+
+    std::vector<const char *> names(argv + 2, argv + argc);
+
+    return ResourcePack::write(argv[1], names);
+}
@@ -0,0 +1,124 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#include "block_compression.hpp"
+#include "mip_chain.hpp"
+#include "../util/nm_log.hpp"
+#include "../util/util.hpp"
+#include "../system/opengl/texture.hpp"
+#include "../system/opengl/texture_file.hpp"
+
+/**
+ * Offline preparation of material textures. Decodes an image exactly like {Texture} does at run time, adds the mip
+ * chain, compresses it into blocks and writes a texture file that is uploaded level by level without decoding or
+ * {glGenerateMipmap}. Does not require an OpenGL context. */
+
+/** How the image is used, which determines its channel count, how its levels are filtered and how it is compressed. */
+struct TextureSemantic {
+    const char *name;
+    /** Number of images the texture is made of, each image is a single channel of the texture if more than one. */
+    uint32_t image_count;
+    uint32_t channel_count;
+    MipChain::Semantic semantic;
+    BlockCompression::Format format;
+};
+
+static const TextureSemantic SEMANTICS[] = {
+        {"diffuse", 1, 4, MipChain::COLOR,  BlockCompression::BC1},
+        {"normal",  1, 4, MipChain::NORMAL, BlockCompression::BC5},
+        {"scalar",  1, 2, MipChain::LINEAR, BlockCompression::BC4},
+        {"pair",    2, 2, MipChain::LINEAR, BlockCompression::BC5}
+};
+
+/** Passed instead of an image for channels that are zero. */
+static const char *const NO_IMAGE = "none";
+
+int decode_image(const TextureSemantic *semantic, const char *image_file, TextureData *data);
+
+int prepare_texture(const TextureSemantic *semantic, const char *const *image_files, const char *texture_file);
+
+int main(int argc, char **argv)
+{
+    const TextureSemantic *semantic = nullptr;
+    if (argc >= 2) {
+        for (const auto &candidate : SEMANTICS) {
+            if (strcmp(argv[1], candidate.name) == 0 && (uint32_t) argc == candidate.image_count + 3) {
+                semantic = &candidate;
+            }
+        }
+    }
+
+    if (!semantic) {
+        fprintf(
+                stderr,
+                "USAGE: %s {diffuse|normal|scalar} {image} {texture}\n"
+                "       %s pair {red|%s} {green|%s} {texture}\n\n"
+                "  Decodes 16 bit {image}, generates its mip chain, compresses it and writes it to {texture}.\n"
+                "  For pair, the first channel of both images is packed into a texture compressed per channel.\n",
+                argv[0], argv[0], NO_IMAGE, NO_IMAGE
+        );
+        return EXIT_FAILURE;
+    }
+
+    Texture::initialize_decoding();
+
+    return prepare_texture(semantic, argv + 2, argv[2 + semantic->image_count]);
+}
+
+int decode_image(const TextureSemantic *semantic, const char *image_file, TextureData *data)
+{
+    char *buffer = nullptr;
+    size_t size;
+    if (Util::read_file(&buffer, &size, image_file) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    int rval = Texture::decode_image(data, buffer, size, semantic->channel_count, 16);
+    delete[] buffer;
+
+    return rval;
+}
+
+int prepare_texture(const TextureSemantic *semantic, const char *const *image_files, const char *texture_file)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    TextureData data{};
+    int rval = EXIT_SUCCESS;
+    if (semantic->image_count == 1) {
+        rval = decode_image(semantic, image_files[0], &data);
+    } else {
+        TextureData channels[2];
+        const TextureData *channel_pointers[2] = {};
+        for (uint32_t i = 0; i < semantic->image_count && rval == EXIT_SUCCESS; i++) {
+            if (strcmp(image_files[i], NO_IMAGE) != 0) {
+                rval = decode_image(semantic, image_files[i], &channels[i]);
+                channel_pointers[i] = &channels[i];
+            }
+        }
+        if (rval == EXIT_SUCCESS) {
+            rval = TextureData::pack_channels(&data, channel_pointers, semantic->image_count);
+        }
+    }
+
+    if (rval == EXIT_FAILURE || MipChain::generate(&data, semantic->semantic) == EXIT_FAILURE) {
+        nm_log::log(LOG_ERROR, "failed to prepare \"%s\"\n", texture_file);
+
+        return EXIT_FAILURE;
+    }
+
+    size_t uncompressed_size = data.data.size();
+    if (BlockCompression::compress(&data, semantic->format) == EXIT_FAILURE ||
+        TextureFile::write(texture_file, &data) == EXIT_FAILURE) {
+        nm_log::log(LOG_ERROR, "failed to prepare \"%s\"\n", texture_file);
+
+        return EXIT_FAILURE;
+    }
+
+    double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    nm_log::log(LOG_INFO, "prepared \"%s\" as %s texture with %d levels in %.2f ms, compressed %zu to %zu bytes\n",
+                texture_file, semantic->name, data.level_count, time, uncompressed_size, data.data.size());
+
+    return EXIT_SUCCESS;
+}
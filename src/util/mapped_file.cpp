@@ -0,0 +1,120 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+#else
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#endif
+
+#include "nm_log.hpp"
+
+#ifdef _WIN32
+
+int MappedFile::map_file(MappedFile *mapped_file, const char *file_name)
+{
+    HANDLE file = CreateFileA(
+            file_name, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        nm_log::log(LOG_ERROR, "failed to open file \"%s\"\n", file_name);
+
+        return EXIT_FAILURE;
+    }
+
+    LARGE_INTEGER size;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        nm_log::log(LOG_ERROR, "failed to map file \"%s\"\n", file_name);
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+
+        return EXIT_FAILURE;
+    }
+
+    mapped_file->data = (const uint8_t *) view;
+    mapped_file->size = (size_t) size.QuadPart;
+    mapped_file->file_handle = file;
+    mapped_file->mapping_handle = mapping;
+
+    return EXIT_SUCCESS;
+}
+
+void MappedFile::unmap_file(MappedFile *mapped_file)
+{
+    if (!mapped_file->data) {
+        return;
+    }
+
+    UnmapViewOfFile(mapped_file->data);
+    CloseHandle(mapped_file->mapping_handle);
+    CloseHandle(mapped_file->file_handle);
+    *mapped_file = MappedFile{};
+}
+
+void MappedFile::prefetch(const MappedFile *, size_t, size_t)
+{
+    // PrefetchVirtualMemory is not available on all supported versions, rely on the read-ahead of the system
+}
+
+#else
+
+int MappedFile::map_file(MappedFile *mapped_file, const char *file_name)
+{
+    int file = open(file_name, O_RDONLY);
+    if (file == -1) {
+        nm_log::log(LOG_ERROR, "failed to open file \"%s\"\n", file_name);
+
+        return EXIT_FAILURE;
+    }
+
+    struct stat status{};
+    void *view = MAP_FAILED;
+    if (fstat(file, &status) == 0 && status.st_size > 0) {
+        view = mmap(nullptr, (size_t) status.st_size, PROT_READ, MAP_SHARED, file, 0);
+    }
+    // the mapping keeps its own reference to the file
+    close(file);
+
+    if (view == MAP_FAILED) {
+        nm_log::log(LOG_ERROR, "failed to map file \"%s\"\n", file_name);
+
+        return EXIT_FAILURE;
+    }
+
+    mapped_file->data = (const uint8_t *) view;
+    mapped_file->size = (size_t) status.st_size;
+
+    return EXIT_SUCCESS;
+}
+
+void MappedFile::unmap_file(MappedFile *mapped_file)
+{
+    if (!mapped_file->data) {
+        return;
+    }
+
+    munmap((void *) mapped_file->data, mapped_file->size);
+    *mapped_file = MappedFile{};
+}
+
+void MappedFile::prefetch(const MappedFile *mapped_file, size_t offset, size_t size)
+{
+    // the address passed to madvise must be page aligned
+    size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+    size_t begin = offset / page_size * page_size;
+    madvise((void *) (mapped_file->data + begin), offset + size - begin, MADV_WILLNEED);
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef PBR_MAPPED_FILE_HPP
+#define PBR_MAPPED_FILE_HPP
+
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * A file mapped read-only into memory. Pages are read on first access and are shared through the page cache with
+ * every other process that maps the same file. */
+struct MappedFile {
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+    void *file_handle = nullptr;
+    void *mapping_handle = nullptr;
+#endif
+
+    static int map_file(MappedFile *mapped_file, const char *file_name);
+
+    static void unmap_file(MappedFile *mapped_file);
+
+    /** Hints that {size} bytes at {offset} are accessed soon, such that they are read ahead in the background. */
+    static void prefetch(const MappedFile *mapped_file, size_t offset, size_t size);
+};
+
+#endif //PBR_MAPPED_FILE_HPP
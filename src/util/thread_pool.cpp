@@ -0,0 +1,80 @@
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(uint32_t thread_count)
+{
+    if (thread_count == 0) {
+        // may return 0 if the number of hardware threads is not known
+        thread_count = std::thread::hardware_concurrency();
+        if (thread_count == 0) {
+            thread_count = 1;
+        }
+    }
+
+    for (uint32_t i = 0; i < thread_count; i++) {
+        threads.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    task_available.notify_all();
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+uint32_t ThreadPool::get_thread_count() const
+{
+    return threads.size();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        tasks.push(std::move(task));
+        pending_count++;
+    }
+    task_available.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    tasks_done.wait(lock, [this] { return pending_count == 0; });
+}
+
+void ThreadPool::work()
+{
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            task_available.wait(lock, [this] { return stopping || !tasks.empty(); });
+
+            // only stop once the queue is drained
+            if (tasks.empty()) {
+                return;
+            }
+
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+
+        task();
+
+        bool done;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            done = --pending_count == 0;
+        }
+        if (done) {
+            tasks_done.notify_all();
+        }
+    }
+}
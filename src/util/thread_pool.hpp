@@ -0,0 +1,49 @@
+#ifndef UTIL_THREAD_POOL_HPP
+#define UTIL_THREAD_POOL_HPP
+
+#include <cstdint>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/** Fixed set of worker threads executing submitted tasks in order of submission. */
+class ThreadPool {
+private:
+    std::vector<std::thread> threads;
+    std::queue<std::function<void()>> tasks;
+    /** Number of tasks submitted but not yet finished. */
+    uint32_t pending_count = 0;
+    bool stopping = false;
+
+    std::mutex mutex;
+    /** Signals workers that a task was submitted or that the pool is stopping. */
+    std::condition_variable task_available;
+    /** Signals {wait} that the last pending task finished. */
+    std::condition_variable tasks_done;
+
+    void work();
+
+public:
+    /** Starts {thread_count} workers, 0 uses one worker per hardware thread. */
+    explicit ThreadPool(uint32_t thread_count = 0);
+
+    /** Finishes all submitted tasks and joins the workers. */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    uint32_t get_thread_count() const;
+
+    /** Queues {task} to be executed on one of the workers. */
+    void submit(std::function<void()> task);
+
+    /** Blocks until all submitted tasks are finished. */
+    void wait();
+};
+
+#endif //UTIL_THREAD_POOL_HPP
@@ -33,4 +33,15 @@ int Util::read_file(char **buffer, size_t *size, const char *file_name)
     (*buffer)[*size] = '\0';
 
     return EXIT_SUCCESS;
+}
+
+uint64_t Util::hash(const void *data, size_t size, uint64_t hash)
+{
+    const auto *bytes = (const uint8_t *) data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
 }
\ No newline at end of file
@@ -3,11 +3,18 @@
 
 #include <vector>
 #include <cstdlib>
+#include <cstdint>
 
 #include "nm_log.hpp"
 
 namespace Util {
     int read_file(char **buffer, size_t *size, const char *file_name);
+
+    /** Offset basis of the 64 bit FNV-1a hash, the initial value of {hash}. */
+    const uint64_t HASH_SEED = 0xcbf29ce484222325ull;
+
+    /** Continues the 64 bit FNV-1a hash {hash} over {size} bytes of {data}. Not suited for cryptographic use. */
+    uint64_t hash(const void *data, size_t size, uint64_t hash = HASH_SEED);
 }
 
 #endif //PBR_UTIL_HPP